@@ -0,0 +1,184 @@
+/*******************************************************************************
+ * File        : alloctest.c                                                   *
+ * Function    : test of the time stepping for heap allocations (make test)    *
+ * Programmers : Yizhong Qu   @ Pennsylvania State Univeristy                  *
+ *               Mukesh Kumar @ Pennsylvania State Univeristy                  *
+ *               Gopal Bhatt  @ Pennsylvania State Univeristy                  *
+ * Version     : 2.0 (July 10, 2007)                                           *
+ *-----------------------------------------------------------------------------*
+ *                                                                             *
+ * The data set of calib.c is read and initialized as by pihm.c. After one     *
+ * warm-up step, the per-step calls of the driver, calET_IS(), f() and         *
+ * FPrint(), are repeated over ALLOC_STEPS steps of ETStep and every malloc(), *
+ * calloc() and realloc() of the model is counted. The program is linked with  *
+ * -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc (see the Makefile), so only  *
+ * the calls of the PIHM sources are counted, not those inside the C, netCDF   *
+ * or OpenMP libraries. It fails (exit status 1) if the count is not zero.     *
+ *                                                                             *
+ * The states are held fixed: CVODE is not run, f() is evaluated as CVODE      *
+ * would evaluate it between two outputs.                                      *
+ *                                                                             *
+ * This code is free for users with research purpose only, if appropriate      *
+ * citation is refered. However, there is no warranty in any format for this   *
+ * product.                                                                    *
+ *                                                                             *
+ * For questions or comments, please contact the authors of the reference.     *
+ * One who want to use it for other consideration may also contact Dr.Duffy    *
+ * at cxd11@psu.edu.                                                           *
+ *******************************************************************************/
+
+//! @file alloctest.c Counting allocator test: no heap allocation in steady-state time stepping
+
+/*    C Header Files    */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* SUNDIAL Header Files */
+#include "sundials_types.h"            /* realtype, integertype, booleantype defination */
+#include "nvector_serial.h"            /* contains the definition of type N_Vector      */
+
+/* PIHM Header Files */
+#include "pihm.h"                      /* Definations for all data Structure in PIHM    */
+#include "print.h"                     /* output control and FPrint()                   */
+
+#define ALLOC_STEPS    240             /**< Number of steps counted after the warm-up   */
+
+/* Function declarations */
+void setFileName(char *);                                /* file name prefix of calib.c                          */
+void read_alloc(char *, Model_Data, Control_Data *);     /* read input from files :: read_alloc.c                */
+N_Vector N_VNew_Serial(int);                             /**< \brief CVODE::Set vector of initial values         */
+void initialize(char *, Model_Data, Control_Data *, N_Vector);
+                                                         /* Initialize model & Control Data :: initialize.c      */
+void SetModeKernels(Model_Data);                         /* selects the RHS kernels of the modes :: f.c          */
+void calET_IS(realtype, realtype, Model_Data, N_Vector); /* Calculates ET & IS    :: et_is.c                     */
+int  f(realtype, N_Vector, N_Vector, void *);            /* RHS of system of ODEs :: f.c                         */
+
+void *__real_malloc(size_t);
+void *__real_calloc(size_t, size_t);
+void *__real_realloc(void *, size_t);
+
+static int counting = 0;                /* 1: the allocations are counted              */
+static int nAlloc = 0;                  /* number of allocations while counting        */
+
+
+/*******************************************************************************
+*    Counting Allocator (-Wl,--wrap)
+********************************************************************************/
+void *__wrap_malloc(size_t size)
+//! Function counts a malloc() of the model and passes it on to the C library
+{
+    if(counting)
+    {
+        __sync_fetch_and_add(&nAlloc, 1);
+    }
+    return __real_malloc(size);
+}
+
+
+void *__wrap_calloc(size_t num, size_t size)
+//! Function counts a calloc() of the model and passes it on to the C library
+{
+    if(counting)
+    {
+        __sync_fetch_and_add(&nAlloc, 1);
+    }
+    return __real_calloc(num, size);
+}
+
+
+void *__wrap_realloc(void *ptr, size_t size)
+//! Function counts a realloc() of the model and passes it on to the C library
+{
+    if(counting)
+    {
+        __sync_fetch_and_add(&nAlloc, 1);
+    }
+    return __real_realloc(ptr, size);
+}
+
+
+/* Step of the driver as in pihm.c: ET/IS over the step, RHS, output */
+void TestStep(Model_Data mData, N_Vector CV_Y, N_Vector CV_Yd, realtype t, realtype h)
+//! Function makes the per-step calls of the driver from t to t+h with the states held fixed
+/*! \param mData is pointer to model data structure
+    \param CV_Y is the state vector
+    \param CV_Yd is the rate of change of the states (output of f())
+    \param t is the start of the step
+    \param h is the step size
+*/
+{
+    if(mData->ISMode == 0)
+    {
+        calET_IS(t, h, mData, CV_Y);
+    }
+    f(t + h, CV_Y, CV_Yd, mData);
+    FPrint(mData, CV_Y, t + h);
+}
+
+
+/* Main Function of the Test */
+int main(int argc, char *argv[])
+{
+    char *filename;                 /* File name prefix for input/output files    */
+    char tmpFileName[100];
+
+    Model_Data mData;               /* Model Data                                 */
+    Control_Data cData;             /* Control Data                               */
+    N_Vector CV_Y;                  /* State Variables Vector                     */
+    N_Vector CV_Yd;                 /* Rates of the State Variables               */
+
+    int N;                          /* Problem Size  (Numer of ODEs)              */
+    int k;                          /* loop index variable                        */
+    realtype t, h;                  /* simulation time and step size              */
+
+    setFileName(tmpFileName);
+    filename = (char *)malloc(sizeof(char)*(strlen(tmpFileName)+1));
+    strcpy(filename, tmpFileName);
+    mData = (Model_Data)malloc(sizeof *mData);
+
+    read_alloc(filename, mData, &cData);
+    SetModeKernels(mData);
+
+    N = 3*mData->NumEle + mData->NumRiv;
+    if(mData->UnsatMode == 1)
+    {
+        N = 2*mData->NumEle + mData->NumRiv;
+    }
+    if(mData->ISMode == 1)
+    {
+        N = N + 2*mData->NumEle;
+    }
+    CV_Y = N_VNew_Serial(N);
+    CV_Yd = N_VNew_Serial(N);
+
+    initialize(filename, mData, &cData, CV_Y);
+    FPrintInit(mData, cData.StartTime);
+
+    /* warm-up: the first step may fill the lazily set caches of the forcing and the output */
+    t = cData.StartTime;
+    h = cData.ETStep;
+    TestStep(mData, CV_Y, CV_Yd, t, h);
+    t = t + h;
+
+    /* the steady-state steps, including the flushes of the means and the writer thread */
+    counting = 1;
+    for(k=0; k<ALLOC_STEPS; k++)
+    {
+        TestStep(mData, CV_Y, CV_Yd, t, h);
+        t = t + h;
+    }
+    FPrintCloseAll();
+    counting = 0;
+
+    printf("\n  %d allocation(s) in %d steps of %.1f min after the warm-up\n", nAlloc, ALLOC_STEPS, h);
+    if(nAlloc != 0)
+    {
+        printf("\n  Fatal Error: the time stepping allocates on the heap!\n");
+        exit(1);
+    }
+    printf("  Allocation test passed.\n");
+
+    return 0;
+}
@@ -46,14 +46,8 @@
 
 #define EPSILON 0.05
 
-/* Calibration Parameters */
-realtype is_CALIB;                /**< Calibrates: Interception Storage   */
-realtype et0_CALIB;               /**< Calibrates: et0                    */
-realtype mf_CALIB;                /**< Calibrates: Melt Factor            */
-realtype tf_CALIB;                /**< Calibrates: ThroughFall            */
-
-
 realtype Interpolation(TSD *Data, realtype t);        /* Data Value at time=t from a TimeSeries  */
+void updateForcing(Model_Data MD, realtype t);        /* Forcing Cache of all TimeSeries at time=t */
 
 
 /********************************************************************
@@ -69,33 +63,22 @@ void calET_IS(realtype t, realtype stepsize, Model_Data MD, N_Vector VY)
 {
       int i;
       realtype totEvap;
-      realtype Delta, Gamma;
-      realtype Rn, G, T, Vel, RH, VP,P,LAI,zero_dh,cnpy_h,rl,r_a;
+      realtype G, T, LAI,zero_dh,cnpy_h;
       realtype isval=0,etval=0;
       realtype fracSnow,snowRate,MeltRate,MF,Ts=-3.0,Tr=1.0,To=0.0,massMelt=0,ret;
 
       //Model_Data MD;
 
-      is_CALIB = setis_CALIB();
-      et0_CALIB = setet0_CALIB();
-      mf_CALIB=setmf_CALIB();
-      tf_CALIB = settf_CALIB();
-
       //MD = (Model_Data)DS;
 
       stepsize=stepsize/(24.0*60.0);
+      updateForcing(MD, t);
+      MF = MD->Cal.mf*MD->Forc.MeltF[0];                 /* Melt Factor is the same for all the elements */
       for(i=0; i<MD->NumEle; i++)
       {
-        MD->ElePrep[i] = Interpolation(&MD->TSD_Prep[MD->Ele[i].prep-1], t);
-        Rn = Interpolation(&MD->TSD_Rn[MD->Ele[i].Rn-1], t);
-        T = Interpolation(&MD->TSD_Temp[MD->Ele[i].temp-1], t);
-        Vel = Interpolation(&MD->TSD_WindVel[MD->Ele[i].WindVel-1], t);
-        RH = Interpolation(&MD->TSD_Humidity[MD->Ele[i].humidity-1], t);
-        VP = Interpolation(&MD->TSD_Pressure[MD->Ele[i].pressure-1], t);
-        P = 101.325*pow(10,3)*pow((293-0.0065*MD->Ele[i].zmax)/293,5.26);
-        LAI = Interpolation(&MD->TSD_LAI[MD->Ele[i].LC-1], t);
-        MF = Interpolation(&MD->TSD_MeltF[0], t);
-        MF=mf_CALIB*MF;
+        MD->ElePrep[i] = MD->Forc.Prep[MD->Ele[i].prep-1];
+        T = MD->Forc.Temp[MD->Ele[i].temp-1];
+        LAI = MD->Forc.LAI[MD->Ele[i].LC-1];
 
         /*****************************************Snow Calculation ****************************************************/
         fracSnow = T<Ts?1.0:T>Tr?0:(Tr-T)/(Tr-Ts);
@@ -118,15 +101,11 @@ void calET_IS(realtype t, realtype stepsize, Model_Data MD, N_Vector VY)
 
 
         /**************************************Evaporation from canopy*************************************************/
-        MD->EleISmax[i] = MD->SIFactor[MD->Ele[i].LC-1]*Interpolation(&MD->TSD_LAI[MD->Ele[i].LC-1], t);
+        MD->EleISmax[i] = MD->EleP.ISFactor[i]*MD->Forc.LAI[MD->Ele[i].LC-1];
         //MD->EleIS[i] = is_CALIB*MD->EleISmax[i];
-        /// Bhatt
-        MD->EleISmax[i] = is_CALIB*MD->EleISmax[i];
         if(LAI>0.0)
         {
-            Delta = 2503*pow(10,3)*exp(17.27*T/(T+237.3))/(pow(237.3 + T, 2));
-            Gamma = P*1.0035*0.92/(0.622*2441);
-            zero_dh=Interpolation(&MD->TSD_DH[MD->Ele[i].LC-1], t);
+            zero_dh=MD->Forc.DH[MD->Ele[i].LC-1];
             //zero_dh=0;
             cnpy_h = zero_dh/(1.1*(0.0000001+log(1+pow(0.007*LAI,0.25))));
             /*if(LAI<2.85)
@@ -138,13 +117,10 @@ void calET_IS(realtype t, realtype stepsize, Model_Data MD, N_Vector VY)
                 rl= 0.3*cnpy_h*(1-(zero_dh/cnpy_h));
             }
             */
-            rl=Interpolation(&MD->TSD_DH[MD->Ele[i].LC-1], t);
-            r_a = log(MD->Ele[i].windH/rl)*log(10*MD->Ele[i].windH/rl)/(Vel*0.16);
-
             /* $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$ DELETE 0.01 BELOW $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$ */
 
-            MD->EleET[i][0] = (LAI/MD->Ele[i].LAImax)*(pow((MD->EleIS[i]<0?0:MD->EleIS[i])/MD->EleISmax[i],2.0/3.0))*(Rn*(1-MD->Ele[i].Albedo)*Delta+(1.2*1003.5*((VP/RH)-VP)/r_a))/(1000*2441000.0*(Delta+Gamma));
-            MD->EleTF[i]=tf_CALIB*5.65*pow(10,-2)*MD->EleISmax[i]*exp(3.89*(MD->EleIS[i]<0?0:MD->EleIS[i])/MD->EleISmax[i]);
+            MD->EleET[i][0] = LAI*MD->EleP.et0Frac[i]*(pow((MD->EleIS[i]<0?0:MD->EleIS[i])/MD->EleISmax[i],2.0/3.0))*MD->PET.num[i]/(1000*2441000.0*(MD->PET.Delta[i]+MD->EleP.Gamma[i]));
+            MD->EleTF[i]=MD->Cal.tfCoeff*MD->EleISmax[i]*exp(3.89*(MD->EleIS[i]<0?0:MD->EleIS[i])/MD->EleISmax[i]);
             //printf("\n %f %f %f %f %f %f %f %f %f",MD->EleIS[i],LAI,MD->Ele[i].LAImax,r_a,rl,cnpy_h,Delta,Gamma,MD->EleET[i][0]);
 
         }
@@ -156,7 +132,6 @@ void calET_IS(realtype t, realtype stepsize, Model_Data MD, N_Vector VY)
 
         /**********************************************************************************************************************/
 
-        MD->EleET[i][0]=et0_CALIB*MD->EleET[i][0];
         //printf("\n%f %f",MD->EleIS[i],MD->EleISmax[i]); getchar();
         if(MD->EleIS[i] >= MD->EleISmax[i])
         {
@@ -212,7 +187,7 @@ void calET_IS(realtype t, realtype stepsize, Model_Data MD, N_Vector VY)
                ret =  MD->EleTF[i];
         }
         massMelt=massMelt+MeltRate*stepsize;
-        MD->EleNetPrep[i] = (1-MD->Ele[i].VegFrac)*(1-fracSnow)*MD->ElePrep[i] + ((1-fracSnow)*MD->ElePrep[i]+ret - MD->Ele2IS[i])*MD->Ele[i].VegFrac+MeltRate;
+        MD->EleNetPrep[i] = (1-MD->EleP.VegFrac[i])*(1-fracSnow)*MD->ElePrep[i] + ((1-fracSnow)*MD->ElePrep[i]+ret - MD->Ele2IS[i])*MD->EleP.VegFrac[i]+MeltRate;
         MD->EleTF[i] = ret;
 
         //MD->EleNetPrep[i] =MD->ElePrep[i];
@@ -225,3 +200,74 @@ void calET_IS(realtype t, realtype stepsize, Model_Data MD, N_Vector VY)
     //printf("\t%e",massMelt);
     //getchar();
 }
+
+
+/********************************************************************
+    Rates of Interception & Snow Storage as States of CVODE
+*********************************************************************/
+void EleISSnow(Model_Data MD, int i, realtype is, realtype snow, realtype *dy)
+//! Function evaluates the rates of interception and snow storage of element i when they are states of CVODE (ISMode 1)
+/*! The processes are those of calET_IS() without the explicit step: the forcing cached at the time of f() is used,
+    the store is limited by the rates instead of by stepsize, and the net precipitation to the surface is set for EleVertical().
+    \param MD is pointer to model data structure
+    \param i is the index of the element
+    \param is is the interception storage state
+    \param snow is the snow storage state
+    \param dy is the rate of change of interception and snow storage per day (output)
+*/
+{
+      realtype T, LAI;
+      realtype fracSnow, snowRate, MeltRate, MF, rain, ET0, TF, Ts=-3.0, Tr=1.0, To=0.0;
+
+      is = is < 0 ? 0 : is;
+      snow = snow < 0 ? 0 : snow;
+      MD->EleIS[i] = is;                                  /* f() uses the interception storage for ET from the ground */
+      MD->EleSnow[i] = snow;
+
+      MD->ElePrep[i] = MD->Forc.Prep[MD->Ele[i].prep-1];
+      T = MD->Forc.Temp[MD->Ele[i].temp-1];
+      LAI = MD->Forc.LAI[MD->Ele[i].LC-1];
+
+      /*****************************************Snow Calculation ****************************************************/
+      MF = MD->Cal.mf*MD->Forc.MeltF[0];                  /* Melt Factor is the same for all the elements */
+      fracSnow = T<Ts?1.0:T>Tr?0:(Tr-T)/(Tr-Ts);
+      snowRate = fracSnow*MD->ElePrep[i];
+      MeltRate = (T>To?(T-To)*MF:0);
+      if(snow <= 0 && MeltRate > snowRate)
+      {
+          MeltRate = snowRate;                            /* an empty pack melts what falls on it */
+      }
+      dy[1] = snowRate - MeltRate;
+
+      /**************************************Evaporation from canopy*************************************************/
+      MD->EleISmax[i] = MD->EleP.ISFactor[i]*LAI;
+      if(LAI>0.0)
+      {
+          ET0 = LAI*MD->EleP.et0Frac[i]*(pow(is/MD->EleISmax[i],2.0/3.0))*MD->PET.num[i]/(1000*2441000.0*(MD->PET.Delta[i]+MD->EleP.Gamma[i]));
+          TF = MD->Cal.tfCoeff*MD->EleISmax[i]*exp(3.89*is/MD->EleISmax[i]);
+      }
+      else
+      {
+          ET0 = 0.0;
+          TF = 0.0;
+      }
+
+      /* an empty store passes on no more than the rain; a full store lets the excess drip */
+      rain = (1-fracSnow)*MD->ElePrep[i];
+      if(is <= 0 && rain < ET0+TF)
+      {
+          ET0 = ET0/(ET0+TF)*rain;
+          TF = rain - ET0;
+      }
+      dy[0] = rain - ET0 - TF;
+      if(is >= MD->EleISmax[i] && dy[0] > 0)
+      {
+          TF = TF + dy[0];
+          dy[0] = 0;
+      }
+
+      MD->Ele2IS[i] = rain;
+      MD->EleET[i][0] = ET0;
+      MD->EleTF[i] = TF;
+      MD->EleNetPrep[i] = (1-MD->EleP.VegFrac[i])*rain + MD->EleP.VegFrac[i]*TF + MeltRate;
+}
@@ -51,28 +51,26 @@
 
 #define ABS_TOL    1E-4		/**< Absolute tolerance as defined in control data */
 
-realtype Vic_CALIB;
-realtype rivK_CALIB;
-realtype Kh_CALIB;
-realtype Rec_CALIB;
-realtype et2_CALIB;
-realtype et1_CALIB;
-realtype sat_THRESH;
-realtype mp_MULTFH;
-realtype mp_MULTFV;
-realtype mpArea_CALIB;
-realtype ovl_THRESH_H;
-realtype ovl_THRESH_V;
-realtype rzd_CALIB;
-
-
 /*    Function Declarations    */
 realtype Interpolation(TSD *Data, realtype t);
-realtype returnVal(realtype rArea, realtype rPerem, realtype eqWid, realtype ap_Bool);
-realtype CS_AreaOrPerem(int rivOrder, realtype rivDepth, realtype rivCoeff, realtype a_pBool);
-void OverlandFlow(realtype **flux, int loci, int locj, int surfmode, realtype avg_y, realtype grad_y, realtype avg_sf, realtype alfa, realtype beta, realtype crossA, realtype avg_rough, int eletypeBool, realtype avg_perem);
-void OLflowFromEleToRiv(realtype sideEle_y,realtype sideEle_zmax,realtype rivX,realtype sideEleX,realtype rivY,realtype sideEleY,realtype cwr,realtype rivZmax,realtype loc_yriver,realtype **fluxriv,int loc_i,int loc_j,realtype length);
-void GWflowFromEleToRiv(realtype sideEle_y,realtype sideEle_zmax, realtype sideEle_zmin,realtype rivX,realtype sideEleX,realtype rivY,realtype sideEleY,int loc_McPore,realtype loc_yriver,realtype loc_totyriver,realtype **fluxriv,int loc_i,int loc_j,realtype length, realtype loc_base,realtype loc_gama, realtype loc_perem,realtype loc_ksat,realtype ele_Thresh);
+void EleVertical(Model_Data MD, int i, realtype *y, realtype *dy, realtype *et, realtype *vic);
+realtype EleRecharge(Model_Data MD, int i, realtype *y);
+void updateForcing(Model_Data MD, realtype t);
+void updatePET(Model_Data MD);
+void EleISSnow(Model_Data MD, int i, realtype is, realtype snow, realtype *dy);
+realtype CS_Area(riv_xs *xs, realtype rivDepth);
+realtype CS_Perem(riv_xs *xs, realtype rivDepth);
+realtype CS_EqWid(riv_xs *xs, realtype rivDepth);
+realtype CS_R23(riv_xs *xs, realtype rivDepth);
+realtype SurfFlowKW(realtype avg_y, realtype grad_y, realtype avg_sf, realtype crossA, realtype avg_rough);
+realtype SurfFlowDW(realtype avg_y, realtype grad_y, realtype avg_sf, realtype crossA, realtype avg_rough);
+realtype ChanFlow(realtype grad_y, realtype avg_sf, realtype crossA, realtype avg_rough, realtype avg_perem);
+int EleFacesKW(Model_Data MD, realtype *DummyY, realtype t);
+int EleFacesDW(Model_Data MD, realtype *DummyY, realtype t);
+void DualEleFacesKW(Model_Data MD);
+void DualEleFacesDW(Model_Data MD);
+void OLflowFromEleToRiv(realtype sideEle_y,realtype sideEle_zmax,realtype dist,realtype cwr,realtype rivZmax,realtype loc_yriver,realtype **fluxriv,int loc_i,int loc_j,realtype length);
+void GWflowFromEleToRiv(realtype sideEle_y,realtype sideEle_zmax, realtype sideEle_zmin,realtype dist,int loc_McPore,realtype loc_yriver,realtype loc_totyriver,realtype **fluxriv,int loc_i,int loc_j,realtype length, realtype loc_base,realtype loc_gama, realtype loc_perem,realtype loc_ksat,realtype ele_Thresh,realtype rivK);
 
 
 
@@ -88,11 +86,7 @@ int f(realtype t, N_Vector CV_Y, N_Vector CV_Ydot, void *DS)
     \param DS is pointer to model data structure
 */
 {
-    int i, j;
-
-    realtype Delta, Gamma;
-    realtype Rn, T, Vel, RH, VP,P,LAI,zero_dh,cnpy_h,rl,r_a,r_s,alpha_r,f_r,eta_s,beta_s,Rmax;
-
+    int i, j, k, l, nNaN;
 
     realtype Avg_Y_Surf, Dif_Y_Surf;
     realtype Distance;
@@ -110,40 +104,42 @@ int f(realtype t, N_Vector CV_Y, N_Vector CV_Ydot, void *DS)
     realtype mp_factor,m_factor;
     realtype G, GI;
     realtype Cwr, RivPrep;
-    realtype temp1, temp2;
 
-    realtype Alfa, Beta, CrossA;
+    realtype CrossA;
     realtype bank_ele;
-    realtype AquiferDepth, Deficit, PH,elemSatn,eleSatn;
+    realtype AquiferDepth, PH,elemSatn,eleSatn;
     realtype loc_bcEle, Avg_BedDepth;
 
+    realtype ye[3], dye[3];                 /* states and vertical rates of one element */
     realtype *Y, *DY,*DummyY,*DummyDY;
     Model_Data MD;
 
-    Vic_CALIB=setVic_CALIB();
-    rivK_CALIB=setrivK_CALIB();
-    Kh_CALIB=setKh_CALIB();
-    Rec_CALIB=setRec_CALIB();
-    et2_CALIB=setet2_CALIB();
-    et1_CALIB=setet1_CALIB();
-    sat_THRESH=setsat_THRESH();
-    mp_MULTFH=setmp_MULTFH();
-    mp_MULTFV=setmp_MULTFV();
-    mpArea_CALIB=setmpArea_CALIB();
-    ovl_THRESH_H=setovl_THRESH_H();
-    ovl_THRESH_V=setovl_THRESH_V();
-    rzd_CALIB=setrzd_CALIB();
-
-
     Y = NV_DATA_S(CV_Y);
     DY = NV_DATA_S(CV_Ydot);
     MD = (Model_Data) DS;
 
-    DummyY=(realtype *)malloc((3*MD->NumEle+MD->NumRiv)*sizeof(realtype));
-    DummyDY=(realtype *)malloc((3*MD->NumEle+MD->NumRiv)*sizeof(realtype));
+    /* forcing is interpolated once per series; repeated calls at the same t reuse it */
+    updateForcing(MD, t);
+
+    /* persistent workspaces allocated in initialize(): f() performs no heap allocation */
+    DummyY=MD->DummyY;
+    DummyDY=MD->DummyDY;
+
+    /* interception and snow are states (ISMode 1): their rates and the net precipitation follow the state */
+    if(MD->ISMode == 1)
+    {
+        #pragma omp parallel for private(dye)
+        for(i=0; i<MD->NumEle; i++)
+        {
+            EleISSnow(MD, i, Y[i+3*MD->NumEle+MD->NumRiv], Y[i+4*MD->NumEle+MD->NumRiv], dye);
+            DY[i+3*MD->NumEle+MD->NumRiv] = dye[0]/(60.0*24.0);
+            DY[i+4*MD->NumEle+MD->NumRiv] = dye[1]/(60.0*24.0);
+        }
+    }
 
 
     /* Lateral Flux Calculation Follows */
+    #pragma omp parallel for
     for(i=0; i<3*MD->NumEle+MD->NumRiv; i++)
     {
 
@@ -159,22 +155,23 @@ int f(realtype t, N_Vector CV_Y, N_Vector CV_Ydot, void *DS)
                 DummyY[i]=Y[i];
          }
     }
+    #pragma omp parallel for
     for(i=MD->NumEle; i<2*MD->NumEle; i++)
     {
           //      if((i>=MD->NumEle)&&(i<2*MD->NumEle)){
-        if(Y[i]>(MD->Ele[i-MD->NumEle].zmax-MD->Ele[i-MD->NumEle].zmin))
+        if(Y[i]>MD->EleP.AqDepth[i-MD->NumEle])
         {
-            DummyY[i]=MD->Ele[i-MD->NumEle].zmax - MD->Ele[i-MD->NumEle].zmin;
+            DummyY[i]=MD->EleP.AqDepth[i-MD->NumEle];
         }
-         if(Y[i+MD->NumEle]>(MD->Ele[i-MD->NumEle].zmax-MD->Ele[i-MD->NumEle].zmin))
+         if(Y[i+MD->NumEle]>MD->EleP.AqDepth[i-MD->NumEle])
          {
-            DummyY[i+MD->NumEle]=MD->Ele[i-MD->NumEle].zmax - MD->Ele[i-MD->NumEle].zmin;
+            DummyY[i+MD->NumEle]=MD->EleP.AqDepth[i-MD->NumEle];
         }
-        if(DummyY[i+MD->NumEle]+DummyY[i]>(MD->Ele[i-MD->NumEle].zmax-MD->Ele[i-MD->NumEle].zmin))
+        if(DummyY[i+MD->NumEle]+DummyY[i]>MD->EleP.AqDepth[i-MD->NumEle])
         {
-            if((DummyY[i]<(MD->Ele[i-MD->NumEle].zmax-MD->Ele[i-MD->NumEle].zmin)))
+            if((DummyY[i]<MD->EleP.AqDepth[i-MD->NumEle]))
             {
-                DummyY[i]=1.0*((MD->Ele[i-MD->NumEle].zmax-MD->Ele[i-MD->NumEle].zmin)-DummyY[i+MD->NumEle]);
+                DummyY[i]=1.0*(MD->EleP.AqDepth[i-MD->NumEle]-DummyY[i+MD->NumEle]);
             }
             else //Only possible if DummyY UnSat = Zmax-Zmin : Check to see if this really happens in natural conditions?
             {
@@ -185,127 +182,24 @@ int f(realtype t, N_Vector CV_Y, N_Vector CV_Ydot, void *DS)
       }
 
     /* Lateral Flux Calculation between Triangular elements Follows  */
+    /* Each interior edge (face) is evaluated once from its owner and scattered to the neighbor with opposite sign; */
+    /* the face loop specialized for the SurfMode of the run is selected once by SetModeKernels() */
+    if(MD->EleFaces(MD, DummyY, t) > 0){
+         /* reported after the parallel loop: no thread waits on output inside it */
+         for(k=0; k<MD->NumFace; k++){
+              i = MD->Face[k].owner;
+              j = MD->Face[k].ownerSlot;
+              if(isnan(MD->FluxSurf[i][j])){
+                   printf("\n1: %f %d %d %lf %lf %lf",t,MD->Ele[i].index,MD->Ele[MD->Face[k].nabr].index,DummyY[i],DummyY[MD->Face[k].nabr],MD->FluxSurf[i][j]);
+              }
+         }
+    }
+
+    /* Boundary edges, ET and vertical fluxes of Triangular elements Follows  */
+    #pragma omp parallel for private(j,loc_bcEle,Avg_Y_Surf,Avg_Y_Sub,Distance,Dif_Y_Sub,Avg_Ksat,Grad_Y_Sub,Dif_Y_Surf,Grad_Y_Surf,ye,dye)
     for(i=0; i<MD->NumEle; i++){
          for(j=0; j<3; j++){
-              if(MD->Ele[i].nabr[j] > 0){
-              /* Subsurface Lateral Flux Calculation between Triangular elements Follows */
-                   if(MD->Ele[MD->Ele[i].nabr[j]-1].zmin>MD->Ele[i].zmin){
-                        if(MD->Ele[MD->Ele[i].nabr[j]-1].zmin>MD->Ele[i].zmin+DummyY[i+2*MD->NumEle]){
-                             Avg_Y_Sub=DummyY[MD->Ele[i].nabr[j]-1 + 2*MD->NumEle]/2;
-                        }
-                        else{
-                             Avg_Y_Sub=(DummyY[i+2*MD->NumEle]+MD->Ele[i].zmin-MD->Ele[MD->Ele[i].nabr[j]-1].zmin+DummyY[MD->Ele[i].nabr[j]-1 + 2*MD->NumEle])/2;
-                        }
-                   }
-                   else{
-                        if(MD->Ele[i].zmin>MD->Ele[MD->Ele[i].nabr[j]-1].zmin+DummyY[MD->Ele[i].nabr[j]-1 + 2*MD->NumEle]){
-                             Avg_Y_Sub=DummyY[i+2*MD->NumEle]/2;
-                        }
-                        else{
-                             Avg_Y_Sub=(DummyY[i+2*MD->NumEle]+DummyY[MD->Ele[i].nabr[j]-1 + 2*MD->NumEle]+MD->Ele[MD->Ele[i].nabr[j]-1].zmin-MD->Ele[i].zmin)/2;
-                        }
-                   }
-                   Dif_Y_Sub = (DummyY[i+2*MD->NumEle] + MD->Ele[i].zmin) - (DummyY[MD->Ele[i].nabr[j]-1 + 2*MD->NumEle] + MD->Ele[MD->Ele[i].nabr[j]-1].zmin);
-                   Distance = sqrt(pow((MD->Ele[i].x - MD->Ele[MD->Ele[i].nabr[j] - 1].x), 2) + pow((MD->Ele[i].y - MD->Ele[MD->Ele[i].nabr[j] - 1].y), 2));
-                   Avg_Ksat = (MD->Ele[i].Ksat + MD->Ele[MD->Ele[i].nabr[j] - 1].Ksat)/2.0;
-                   Grad_Y_Sub = Dif_Y_Sub/Distance;
-                      /* #? see the source of -1 in the nabr[j]-1 */
-                   /* take care of macropore effect */
-                   if((MD->Ele[i].zmax-MD->Ele[i].zmin)-DummyY[i+2*MD->NumEle]-DummyY[i+MD->NumEle]<=0){
-                        elemSatn=1.0;
-                   }
-                   else{
-                        elemSatn = DummyY[i+2*MD->NumEle]/(MD->Ele[i].zmax-MD->Ele[i].zmin);   /*  Will have to change this for other formulation */
-                   }
-                   if (MD->Soil[(MD->Ele[i].soil-1)].Macropore == 0){
-                        mp_factor = 1;
-                   }
-                   else if (MD->Soil[(MD->Ele[i].soil-1)].Macropore == 1){
-                        if((elemSatn>=sat_THRESH)&&(DummyY[i]>ovl_THRESH_H)){
-                             temp1=1.0+mp_MULTFH*(elemSatn-sat_THRESH)/(1-sat_THRESH);
-                             temp1=temp1*mpArea_CALIB+1*(1-mpArea_CALIB);
-                        }
-                        else{
-                             temp1 = 1.0;
-                        }
-
-                        if((MD->Ele[MD->Ele[i].nabr[j] - 1].zmax-MD->Ele[MD->Ele[i].nabr[j] - 1].zmin)-DummyY[MD->Ele[i].nabr[j] - 1+2*MD->NumEle]-DummyY[MD->Ele[i].nabr[j] - 1+MD->NumEle]<=0){
-                             elemSatn=1.0;
-                        }
-                        else{
-                             elemSatn = DummyY[MD->Ele[i].nabr[j] - 1+2*MD->NumEle]/(MD->Ele[MD->Ele[i].nabr[j] - 1].zmax-MD->Ele[MD->Ele[i].nabr[j] - 1].zmin);   /*  Will have to change this for other formulation */
-                        }
-                        if((elemSatn>=sat_THRESH)&&(DummyY[MD->Ele[i].nabr[j] - 1]>ovl_THRESH_H)){
-                             temp2=1.0+mp_MULTFH*(elemSatn-sat_THRESH)/(1-sat_THRESH);
-                             temp2=temp2*mpArea_CALIB+1*(1-mpArea_CALIB);
-                        }
-                        else{
-                             temp2 = 1.0;
-                        }
-
-                        mp_factor = (temp1 + temp2)/2.0;
-                   }
-
-                   /* groundwater flow modeled by Darcy's law */
-                   MD->FluxSub[i][j] = mp_factor*Kh_CALIB*Avg_Ksat*Grad_Y_Sub*Avg_Y_Sub*MD->Ele[i].edge[j];
-
-                   /*     Correction is being done in flux terms which can be > 0 even when there is no source water level present */
-
-                   if(DummyY[i + 2*MD->NumEle] <= 0 && MD->FluxSub[i][j] > 0){
-                        MD->FluxSub[i][j] = 0;
-                   }
-                   if(DummyY[MD->Ele[i].nabr[j] - 1 + 2*MD->NumEle] <= 0 && MD->FluxSub[i][j] < 0){
-                        MD->FluxSub[i][j] = 0;
-                   }
-
-                   /* Saturation check */
-
-                   if((DummyY[i + 2*MD->NumEle] >= (MD->Ele[i].zmax - MD->Ele[i].zmin)) && MD->FluxSub[i][j] < 0){
-                        MD->FluxSub[i][j] = 0;
-                   }
-                   if((DummyY[MD->Ele[i].nabr[j] - 1 + 2*MD->NumEle] >= (MD->Ele[MD->Ele[i].nabr[j] - 1].zmax - MD->Ele[MD->Ele[i].nabr[j] - 1].zmin)) && MD->FluxSub[i][j] >0){
-                        MD->FluxSub[i][j] = 0;
-                   }
-
-                   /* Surface Lateral Flux Calculation between Triangular elements Follows */
-                   if(MD->Ele[MD->Ele[i].nabr[j] - 1].zmax>MD->Ele[i].zmax){
-                        if(MD->Ele[MD->Ele[i].nabr[j] - 1].zmax>MD->Ele[i].zmax+DummyY[i]){
-                             Avg_Y_Surf=DummyY[MD->Ele[i].nabr[j]-1]/2;
-                        }
-                        else{
-                             Avg_Y_Surf=(DummyY[i]+MD->Ele[i].zmax-MD->Ele[MD->Ele[i].nabr[j] - 1].zmax+DummyY[MD->Ele[i].nabr[j]-1])/2;
-                        }
-                   }
-                   else{
-                        if(MD->Ele[i].zmax>MD->Ele[MD->Ele[i].nabr[j] - 1].zmax+DummyY[MD->Ele[i].nabr[j]-1]){
-                             Avg_Y_Surf=DummyY[i]/2;
-                        }
-                        else{
-                             Avg_Y_Surf=(DummyY[i]+DummyY[MD->Ele[i].nabr[j]-1]+MD->Ele[MD->Ele[i].nabr[j] - 1].zmax-MD->Ele[i].zmax)/2;
-                        }
-                   }
-                   Dif_Y_Surf = (DummyY[i] + MD->Ele[i].zmax) - (DummyY[MD->Ele[i].nabr[j] - 1] + MD->Ele[MD->Ele[i].nabr[j] - 1].zmax);
-                   Grad_Y_Surf = Dif_Y_Surf/Distance;
-                   Avg_Sf = (MD->Ele[i].Sf + MD->Ele[MD->Ele[i].nabr[j] - 1].Sf)/2.0;
-                   Avg_Rough = 0.5*(MD->Ele[i].Rough + MD->Ele[MD->Ele[i].nabr[j] - 1].Rough);
-                   CrossA = Avg_Y_Surf*MD->Ele[i].edge[j];
-
-                   OverlandFlow(MD->FluxSurf,i,j,MD->SurfMode, Avg_Y_Surf,Grad_Y_Surf,Avg_Sf,Alfa,Beta,CrossA,Avg_Rough,1,1);
-
-                    if(isnan(MD->FluxSurf[i][j])==1){
-                        printf("\n1: %f %d %d %lf %lf %lf",t,MD->Ele[i].index,MD->Ele[MD->Ele[i].nabr[j]-1].index,DummyY[i],DummyY[MD->Ele[i].nabr[j]-1],MD->FluxSurf[i][j]);
-                        getchar();
-                   }
-                   /*     Correction is being done in flux terms which can be > 0 even when there is no source water level present */
-
-                   if(DummyY[i] <= 0 && MD->FluxSurf[i][j] > 0){
-                        MD->FluxSurf[i][j] = 0;
-                   }
-                   if(DummyY[MD->Ele[i].nabr[j] - 1] <= 0 && MD->FluxSurf[i][j] < 0){
-                        MD->FluxSurf[i][j] = 0;
-                   }
-              }
-              else{
+              if(MD->EleEdge[i][j].nabr < 0){
                    /* Handle boundary conditions for elements. No flow (natural) boundary condition is default */
                    if(MD->Ele[i].BC == 0){
                         MD->FluxSurf[i][j] = 0;
@@ -318,32 +212,32 @@ int f(realtype t, N_Vector CV_Y, N_Vector CV_Ydot, void *DS)
                         if(MD->Ele[i].BC > 0){         // Dirichlet BC
                 loc_bcEle = Interpolation(&MD->TSD_EleBC[(MD->Ele[i].BC)-1], t);
 
-                                if( loc_bcEle < MD->Ele[i].zmin ){
+                                if( loc_bcEle < MD->EleP.zmin[i] ){
                                         Avg_Y_Surf = (DummyY[i])/2;
                                         Avg_Y_Sub  = (DummyY[i+2*MD->NumEle])/2;
                                 }
-                                else if(loc_bcEle < MD->Ele[i].zmax){
+                                else if(loc_bcEle < MD->EleP.zmax[i]){
                                         Avg_Y_Surf = (DummyY[i])/2;
-                                        Avg_Y_Sub  = (loc_bcEle - MD->Ele[i].zmin + DummyY[i+2*MD->NumEle])/2.0;
+                                        Avg_Y_Sub  = (loc_bcEle - MD->EleP.zmin[i] + DummyY[i+2*MD->NumEle])/2.0;
                                 }
                                 else{
-                                        Avg_Y_Surf = (DummyY[i] + loc_bcEle - MD->Ele[i].zmax)/2;
-                                        Avg_Y_Sub  = MD->Ele[i].zmax - MD->Ele[i].zmin;
+                                        Avg_Y_Surf = (DummyY[i] + loc_bcEle - MD->EleP.zmax[i])/2;
+                                        Avg_Y_Sub  = MD->EleEdge[i][j].aqDepth;
                                 }
-                                Distance = sqrt(pow(MD->Ele[i].edge[0]*MD->Ele[i].edge[1]*MD->Ele[i].edge[2]/(4*MD->Ele[i].area), 2) - pow(MD->Ele[i].edge[j]/2, 2));
+                                Distance = MD->EleEdge[i][j].bddDist;
 
                                 //Sub
-                                Dif_Y_Sub = DummyY[i+2*MD->NumEle] + MD->Ele[i].zmin - loc_bcEle;
-                                Avg_Ksat = MD->Ele[i].Ksat;
+                                Dif_Y_Sub = DummyY[i+2*MD->NumEle] + MD->EleP.zmin[i] - loc_bcEle;
+                                Avg_Ksat = MD->EleP.Ksat[i];
                                 Grad_Y_Sub = Dif_Y_Sub/Distance;
-                                MD->FluxSub[i][j] = Avg_Ksat * Grad_Y_Sub * Avg_Y_Sub * MD->Ele[i].edge[j];
+                                MD->FluxSub[i][j] = Avg_Ksat * Grad_Y_Sub * Avg_Y_Sub * MD->EleEdge[i][j].length;
 
                                 //Surf
-                                Dif_Y_Surf = DummyY[i] + MD->Ele[i].zmax - loc_bcEle;
+                                Dif_Y_Surf = DummyY[i] + MD->EleP.zmax[i] - loc_bcEle;
                                 Grad_Y_Surf = Dif_Y_Surf / Distance;
-                                MD->FluxSurf[i][j] = 0.1*(Grad_Y_Surf>0?1:-1)* (Avg_Y_Sub * MD->Ele[i].edge[j] ) * (pow(pow(Avg_Y_Surf, 1.0/3.0),2)/(MD->Ele[i].Rough)) * sqrt((Grad_Y_Surf>0?1:-1)*Grad_Y_Surf);
+                                MD->FluxSurf[i][j] = 0.1*(Grad_Y_Surf>0?1:-1)* (Avg_Y_Sub * MD->EleEdge[i][j].length ) * (pow(pow(Avg_Y_Surf, 1.0/3.0),2)/(MD->EleP.Rough[i])) * sqrt((Grad_Y_Surf>0?1:-1)*Grad_Y_Surf);
 
-                                MD->FluxSurf[i][j] = sqrt(DummyY[i]/Distance)*pow(DummyY[i],2.0/3.0)*(DummyY[i]/2)*MD->Ele[i].edge[j]/MD->Ele[i].Rough;
+                                MD->FluxSurf[i][j] = sqrt(DummyY[i]/Distance)*pow(DummyY[i],2.0/3.0)*(DummyY[i]/2)*MD->EleEdge[i][j].length/MD->EleP.Rough[i];
                         }
 
                                  /* Note the distance calculated here is the distance between circumcenter of the triangle and the edge on which BDD. condition is defined
@@ -379,174 +273,14 @@ int f(realtype t, N_Vector CV_Y, N_Vector CV_Ydot, void *DS)
          }
          /************************************************************************************************/
 
-         /**************************************Evaporation from ground*********************************************************/
-         if((MD->Ele[i].zmax-MD->Ele[i].zmin)-DummyY[i+2*MD->NumEle]-DummyY[i+MD->NumEle]<=0){
-              elemSatn=1.0;
-            }
-         else{
-              //elemSatn = 0.5*(1-cos(3.14*(DummyY[i+MD->NumEle]/(MD->Ele[i].zmax-MD->Ele[i].zmin-DummyY[i+2*MD->NumEle]))));    /*  Will have to change this for other formulation */
-              elemSatn = (DummyY[i+2*MD->NumEle]+DummyY[i+MD->NumEle]>(MD->Ele[i].zmax-MD->Ele[i].zmin)-MD->Ele[i].RzD-rzd_CALIB)? 0.5*(1-cos(3.14*(DummyY[i+2*MD->NumEle]/(MD->Ele[i].zmax-MD->Ele[i].zmin)))):0;
-         }
-         Rn = Interpolation(&MD->TSD_Rn[MD->Ele[i].Rn-1], t);
-         //G = Interpolation(&MD->TSD_G[MD->Ele[i].G-1], t);
-         T = Interpolation(&MD->TSD_Temp[MD->Ele[i].temp-1], t);
-         Vel = Interpolation(&MD->TSD_WindVel[MD->Ele[i].WindVel-1], t);
-         RH = Interpolation(&MD->TSD_Humidity[MD->Ele[i].humidity-1], t);
-         VP = Interpolation(&MD->TSD_Pressure[MD->Ele[i].pressure-1], t);
-         P = 101.325*pow(10,3)*pow((293-0.0065*MD->Ele[i].zmax)/293,5.26);
-         Delta = 2503*pow(10,3)*exp(17.27*T/(T+237.3))/(pow(237.3 + T, 2));
-         Gamma = P*1.0035*0.92/(0.622*2441);
-         LAI = Interpolation(&MD->TSD_LAI[MD->Ele[i].LC-1], t);
-         zero_dh=Interpolation(&MD->TSD_DH[MD->Ele[i].LC-1], t);
-         cnpy_h = zero_dh/(1.1*(0.0000001+log(1+pow(0.007*LAI,0.25))));
-
-         /*if(LAI<2.85)
-        {
-        rl= 0.0002 + 0.3*cnpy_h*pow(0.07*LAI,0.5);
-        }
-        else
-        {
-        rl= 0.3*cnpy_h*(1-(zero_dh/cnpy_h));
-        }
-        */
-        rl=Interpolation(&MD->TSD_DH[MD->Ele[i].LC-1], t);
-        r_a = log(MD->Ele[i].windH/rl)*log(10*MD->Ele[i].windH/rl)/(Vel*0.16);
-
- /* $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$ DELETE 0.01 BELOW $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$ */
-
-        MD->EleET[i][2] = (1-MD->Ele[i].VegFrac)*(Rn*(1-MD->Ele[i].Albedo)*Delta+(1.2*1003.5*((VP/RH)-VP)/r_a))/(1000.0*2441000.0*(Delta+Gamma));
-        MD->EleET[i][2]=et2_CALIB*MD->EleET[i][2];
-
-        if(LAI>0.0){
-             Rmax = 5000.0/(24*3600);        /* Unit day_per_m */
-             f_r= 1.1*Rn*(1-exp(-LAI))/(MD->Ele[i].Rs_ref*LAI);
-             alpha_r= (1+f_r)/(1+(MD->Ele[i].Rmin/Rmax));
-             eta_s= 1- 0.0016*(pow((24.85-T),2));
-             beta_s= elemSatn>EPSILON/1000.0?elemSatn:EPSILON/1000.0;
-
-             r_s=(MD->Ele[i].Rmin*alpha_r/(beta_s*LAI*pow(eta_s,4)))> Rmax?Rmax:(MD->Ele[i].Rmin*alpha_r/(beta_s*LAI*pow(eta_s,4)));
-
-             MD->EleET[i][1] = (LAI/MD->Ele[i].LAImax)*MD->Ele[i].VegFrac*(1-pow((MD->EleIS[i]<0?0:MD->EleIS[i])/MD->EleISmax[i],2.0/3))*(Rn*(1-MD->Ele[i].Albedo)*Delta+(1.2*1003.5*((VP/RH)-VP)/r_a))/(1000*2441000.0*(Delta+Gamma*(1+r_s/r_a)));
-        }
-        else{
-             MD->EleET[i][1] =0.0;
-        }
-
-
-        /**********************************************************************************************************************/
-
-        MD->EleET[i][1]=et1_CALIB*MD->EleET[i][1];
-
-
-        AquiferDepth = MD->Ele[i].zmax - MD->Ele[i].zmin;
-
-        if(DummyY[i+2*MD->NumEle]+DummyY[i+MD->NumEle] >= AquiferDepth){
-             Deficit = 0;
-             MD->EleVic[i] = 0;
-        }
-        else if(DummyY[i+2*MD->NumEle]+DummyY[i+MD->NumEle]>AquiferDepth-MD->Ele[i].RzD){
-               Deficit = AquiferDepth - DummyY[i+2*MD->NumEle];
-               MD->EleVic[i] = MD->Ele[i].Ksat*(1+(DummyY[i]/MD->Ele[i].RzD));
-        }
-        else{
-             Deficit = AquiferDepth - DummyY[i+2*MD->NumEle];
-             MD->EleVic[i] = MD->Ele[i].Ksat*(1+(DummyY[i]-log((DummyY[i+MD->NumEle]+EPSILON/10000.0)/(Deficit-MD->Ele[i].RzD+EPSILON/10000.0))/MD->Ele[i].Alpha)/(MD->Ele[i].RzD));/* Interpolation(&MD->TSD_Inc[MD->Soil[(MD->Ele[i].soil-1)].Inf-1], t);*/    /* ## Take care of this using saturation rate instead of */
-        }
-
-        MD->EleVic[i]=MD->EleVic[i]/Vic_CALIB;
-
-        if(DummyY[i+MD->NumEle] < Deficit){                                     /*  ## redo this condition with only phi and z */
-             if(DummyY[i] > 0){
-             /***************************Addn***************************/
-                  if((MD->Ele[i].zmax-MD->Ele[i].zmin)-DummyY[i+2*MD->NumEle]-DummyY[i+MD->NumEle]<=0){
-                       elemSatn=1.0;
-                  }
-                  else{
-                       elemSatn = DummyY[i+2*MD->NumEle]/(MD->Ele[i].zmax-MD->Ele[i].zmin);   /*  Will have to change this for other formulation */
-                  }
-
-                  if (MD->Soil[(MD->Ele[i].soil-1)].Macropore == 0){
-                       mp_factor = 1.0;
-                  }
-                  else if (MD->Soil[(MD->Ele[i].soil-1)].Macropore == 1){
-                       if((elemSatn>=sat_THRESH)&&(DummyY[i]>ovl_THRESH_V)){
-                            mp_factor=1.0+mp_MULTFV*(elemSatn-sat_THRESH)/(1-sat_THRESH);
-                            mp_factor=mp_factor*mpArea_CALIB+1*(1-mpArea_CALIB);
-                       }
-                       else{
-                            mp_factor = 1.0;
-                       }
-                  }
-
-                  /*********************************************************/
-                  if((MD->Ele[i].zmax-MD->Ele[i].zmin)-DummyY[i+2*MD->NumEle]-DummyY[i+MD->NumEle]<=0){
-                       elemSatn=1.0;
-                  }
-                  else{
-                       elemSatn = (DummyY[i+2*MD->NumEle]+DummyY[i+MD->NumEle]>(MD->Ele[i].zmax-MD->Ele[i].zmin)-MD->Ele[i].RzD-rzd_CALIB)? 0.5*(1-cos(3.14*(DummyY[i+2*MD->NumEle]/(MD->Ele[i].zmax-MD->Ele[i].zmin)))):0;
-                  }
-
-                  DummyDY[i] = MD->EleNetPrep[i] - mp_factor*MD->EleVic[i] - MD->EleET[i][2];
-                  DummyDY[i+MD->NumEle] = (1.0-mpArea_CALIB)*MD->EleVic[i];                    /* ##Clean DY variables to some dummy for defining right hand side */
-                  DummyDY[i+2*MD->NumEle] = DummyDY[i+2*MD->NumEle]+(mp_factor-1*(1-mpArea_CALIB))*MD->EleVic[i];
-             }
-             else if((MD->EleNetPrep[i] > MD->EleVic[i]+MD->EleET[i][2])){
-                  DummyDY[i] = MD->EleNetPrep[i] - (MD->EleVic[i]+MD->EleET[i][2]);
-                  DummyDY[i+MD->NumEle] = MD->EleVic[i];
-             }
-             else if((MD->EleNetPrep[i] < MD->EleVic[i]+MD->EleET[i][2])){       /* ##Think abt putting <= here */
-
-                  if(MD->EleNetPrep[i] < MD->EleVic[i]){
-                       DummyDY[i] = 0;
-                         DummyDY[i+MD->NumEle] = MD->EleNetPrep[i]-elemSatn*MD->EleET[i][2];
-                //BHATT
-                MD->EleET[i][2]=elemSatn*MD->EleET[i][2];
-                  }
-                  else{
-                         DummyDY[i] = 0;
-                         DummyDY[i+MD->NumEle] = MD->EleVic[i];
-                  }
-             }
-             else{
-                  DummyDY[i] = 0;
-                  DummyDY[i+MD->NumEle] = MD->EleNetPrep[i]-elemSatn*MD->EleET[i][2];
-            //BHATT
-            MD->EleET[i][2]=elemSatn*MD->EleET[i][2];
-             }
-        }
-        else{                                    /*  ## redo this condition */
-
-             /* The reason of this happening is not clear, therefore the treatment is not secure
-             Fortranately, this will not happen in most cases. */
-             if(DummyY[i]>0){
-                  DummyDY[i] = MD->EleNetPrep[i]-MD->EleET[i][2];
-                   DummyDY[i+2*MD->NumEle] = 0;
-             }
-              else{
-                  if(MD->EleNetPrep[i]>0){
-                       if(MD->EleNetPrep[i]>MD->EleET[i][2]){
-                            DummyDY[i] =MD->EleNetPrep[i]-MD->EleET[i][2];
-                         }
-                          else{
-                               DummyDY[i] = 0;
-                          }
-                          DummyDY[i+2*MD->NumEle] = 0;
-                  }
-                   else{
-                        DummyDY[i] = 0;
-                        DummyDY[i+2*MD->NumEle] = 0-elemSatn*MD->EleET[i][2];
-                    //BHATT
-                    MD->EleET[i][2]=elemSatn*MD->EleET[i][2];
-                  }
-             }
-        }
-
-        if(DummyY[i+2*MD->NumEle]>=AquiferDepth-MD->Ele[i].RzD){
-             DummyDY[i+2*MD->NumEle]=DummyDY[i+2*MD->NumEle] - MD->EleET[i][1];
-        }
-        else{
-              DummyDY[i+MD->NumEle]=DummyDY[i+MD->NumEle] - MD->EleET[i][1];
-        }
+         /* ET, infiltration and vertical fluxes depend on the states of element i only */
+         ye[0] = DummyY[i];
+         ye[1] = DummyY[i+MD->NumEle];
+         ye[2] = DummyY[i+2*MD->NumEle];
+         EleVertical(MD, i, ye, dye, MD->EleET[i], &MD->EleVic[i]);
+         DummyDY[i] = dye[0];
+         DummyDY[i+MD->NumEle] = dye[1];
+         DummyDY[i+2*MD->NumEle] = dye[2];
 
         /*for(j=0; j<3; j++)
         {
@@ -562,6 +296,7 @@ int f(realtype t, N_Vector CV_Y, N_Vector CV_Ydot, void *DS)
 
 
     /* initialize river flux */
+    #pragma omp parallel for private(j)
     for(i=0; i<MD->NumRiv; i++){
          for(j=0; j<6; j++){
               MD->FluxRiv[i][j] = 0;
@@ -569,48 +304,49 @@ int f(realtype t, N_Vector CV_Y, N_Vector CV_Ydot, void *DS)
     }
 
     /* Lateral Flux Calculation between River-River and River-Triangular elements Follows */
+    #pragma omp parallel for private(TotalY_Riv,Perem,TotalY_Riv_down,Perem_down,Avg_Perem,Avg_Y_Riv,Avg_Rough,Distance,Dif_Y_Riv,Avg_Sf,CrossA,elemSatn,mp_factor,loc_perem)
     for(i=0; i<MD->NumRiv; i++){
 
-         /* Note: the ordering of river segment in input file has to be: from UP to DOWN */
-         TotalY_Riv = DummyY[i + 3*MD->NumEle] + MD->Riv[i].zmin;
-         Perem = CS_AreaOrPerem(MD->Riv_Shape[MD->Riv[i].shape - 1].interpOrd,DummyY[i + 3*MD->NumEle],MD->Riv_Shape[MD->Riv[i].shape - 1].coeff,2);
+         /* Note: segments may be listed in any order; inflow from upstream is gathered after this loop */
+         TotalY_Riv = DummyY[i + 3*MD->NumEle] + MD->RivP.zmin[i];
+         Perem = CS_Perem(MD->RivP.xs[i],DummyY[i + 3*MD->NumEle]);
          /*    if(DummyY[10 + 3*MD->NumEle]>0)
          {
-               printf("\n%lf %e %e %e %e area",t,DummyY[10 + 3*MD->NumEle],MD->Riv_Shape[MD->Riv[10].shape - 1].coeff,Perem,CS_AreaOrPerem(MD->Riv_Shape[MD->Riv[10].shape - 1].interpOrd,DummyY[10 + 3*MD->NumEle],MD->Riv_Shape[MD->Riv[10].shape - 1].coeff,1));
+               printf("\n%lf %e %e %e %e area",t,DummyY[10 + 3*MD->NumEle],MD->Riv_Shape[MD->Riv[10].shape - 1].coeff,Perem,CS_Area(MD->Riv_Shape[MD->Riv[10].shape - 1].interpOrd,DummyY[10 + 3*MD->NumEle],MD->Riv_Shape[MD->Riv[10].shape - 1].coeff));
                getchar();
          }
          */
          /* Lateral Flux Calculation between River-River element Follows */
          if(MD->Riv[i].down > 0){
-              TotalY_Riv_down = DummyY[MD->Riv[i].down - 1 + 3*MD->NumEle] + MD->Riv[MD->Riv[i].down - 1].zmin;
-              Perem_down = CS_AreaOrPerem(MD->Riv_Shape[MD->Riv[MD->Riv[i].down - 1].shape - 1].interpOrd,DummyY[MD->Riv[i].down - 1 + 3*MD->NumEle],MD->Riv_Shape[MD->Riv[MD->Riv[i].down - 1].shape - 1].coeff,2);
+              TotalY_Riv_down = DummyY[MD->Riv[i].down - 1 + 3*MD->NumEle] + MD->RivP.zmin[MD->Riv[i].down - 1];
+              Perem_down = CS_Perem(MD->RivP.xs[MD->Riv[i].down - 1],DummyY[MD->Riv[i].down - 1 + 3*MD->NumEle]);
               Avg_Perem = (Perem + Perem_down)/2.0;    /* Avg perimeter */
-              if(MD->Riv[MD->Riv[i].down - 1].zmin>MD->Riv[i].zmin){
-                   if(MD->Riv[MD->Riv[i].down - 1].zmin>MD->Riv[i].zmin+DummyY[i + 3*MD->NumEle]){
+              if(MD->RivP.zmin[MD->Riv[i].down - 1]>MD->RivP.zmin[i]){
+                   if(MD->RivP.zmin[MD->Riv[i].down - 1]>MD->RivP.zmin[i]+DummyY[i + 3*MD->NumEle]){
                         Avg_Y_Riv=DummyY[MD->Riv[i].down - 1 + 3*MD->NumEle]/2;
                    }
                    else{
-                        Avg_Y_Riv=(DummyY[i + 3*MD->NumEle]+MD->Riv[i].zmin-MD->Riv[MD->Riv[i].down - 1].zmin+DummyY[MD->Riv[i].down - 1 + 3*MD->NumEle])/2;
+                        Avg_Y_Riv=(DummyY[i + 3*MD->NumEle]+MD->RivP.zmin[i]-MD->RivP.zmin[MD->Riv[i].down - 1]+DummyY[MD->Riv[i].down - 1 + 3*MD->NumEle])/2;
                    }
               }
               else{
-                   if(MD->Riv[i].zmin>MD->Riv[MD->Riv[i].down - 1].zmin+DummyY[MD->Riv[i].down - 1 + 3*MD->NumEle]){
+                   if(MD->RivP.zmin[i]>MD->RivP.zmin[MD->Riv[i].down - 1]+DummyY[MD->Riv[i].down - 1 + 3*MD->NumEle]){
                         Avg_Y_Riv=DummyY[i + 3*MD->NumEle]/2;
                    }
                    else{
-                        Avg_Y_Riv=(DummyY[i + 3*MD->NumEle]+DummyY[MD->Riv[i].down - 1 + 3*MD->NumEle]+MD->Riv[MD->Riv[i].down - 1].zmin-MD->Riv[i].zmin)/2;
+                        Avg_Y_Riv=(DummyY[i + 3*MD->NumEle]+DummyY[MD->Riv[i].down - 1 + 3*MD->NumEle]+MD->RivP.zmin[MD->Riv[i].down - 1]-MD->RivP.zmin[i])/2;
                    }
               }
-             Avg_Rough = (MD->Riv_Mat[MD->Riv[i].material - 1].Rough + MD->Riv_Mat[MD->Riv[MD->Riv[i].down - 1].material-1].Rough)/2.0;
+             Avg_Rough = (MD->RivP.Rough[i] + MD->RivP.Rough[MD->Riv[i].down - 1])/2.0;
              //Distance = sqrt(pow(MD->Riv[i].x - MD->Riv[MD->Riv[i].down - 1].x, 2) + pow(MD->Riv[i].y - MD->Riv[MD->Riv[i].down - 1].y, 2));
-             Distance = (MD->Riv[i].Length+MD->Riv[MD->Riv[i].down - 1].Length)/2;
+             Distance = (MD->RivP.Length[i]+MD->RivP.Length[MD->Riv[i].down - 1])/2;
 
              Dif_Y_Riv = (TotalY_Riv - TotalY_Riv_down)/Distance;
-             Avg_Sf = (MD->Riv_Mat[MD->Riv[i].material - 1].Sf + MD->Riv_Mat[MD->Riv[MD->Riv[i].down - 1].material-1].Sf)/2.0;
-             /*CrossA = 0.5*(CS_AreaOrPerem(MD->Riv_Shape[MD->Riv[i].shape - 1].interpOrd,DummyY[i + 3*MD->NumEle],MD->Riv_Shape[MD->Riv[i].shape - 1].coeff,1)+CS_AreaOrPerem(MD->Riv_Shape[MD->Riv[MD->Riv[i].down - 1].shape - 1].interpOrd,DummyY[MD->Riv[i].down - 1 + 3*MD->NumEle],MD->Riv_Shape[MD->Riv[MD->Riv[i].down - 1].shape - 1].coeff,1));
+             Avg_Sf = (MD->RivP.Sf[i] + MD->RivP.Sf[MD->Riv[i].down - 1])/2.0;
+             /*CrossA = 0.5*(CS_Area(MD->Riv_Shape[MD->Riv[i].shape - 1].interpOrd,DummyY[i + 3*MD->NumEle],MD->Riv_Shape[MD->Riv[i].shape - 1].coeff)+CS_Area(MD->Riv_Shape[MD->Riv[MD->Riv[i].down - 1].shape - 1].interpOrd,DummyY[MD->Riv[i].down - 1 + 3*MD->NumEle],MD->Riv_Shape[MD->Riv[MD->Riv[i].down - 1].shape - 1].coeff));
              */
-             CrossA = CS_AreaOrPerem(MD->Riv_Shape[MD->Riv[i].shape - 1].interpOrd,Avg_Y_Riv,MD->Riv_Shape[MD->Riv[i].shape - 1].coeff,1);
-             OverlandFlow(MD->FluxRiv,i,1,MD->RivMode, Avg_Y_Riv,Dif_Y_Riv,Avg_Sf,Alfa,Beta,CrossA,Avg_Rough,0,Avg_Perem);
+             CrossA = CS_Area(MD->RivP.xs[i],Avg_Y_Riv);
+             MD->FluxRiv[i][1] = ChanFlow(Dif_Y_Riv,Avg_Sf,CrossA,Avg_Rough,Avg_Perem);
 
              /* Correction is being done in flux terms which can be > 0 even when there is no source water level present */
              if(DummyY[i + 3*MD->NumEle] <= 0 && MD->FluxRiv[i][1] > 0){
@@ -619,9 +355,6 @@ int f(realtype t, N_Vector CV_Y, N_Vector CV_Ydot, void *DS)
              else if(DummyY[MD->Riv[i].down - 1 + 3*MD->NumEle] <= 0 && MD->FluxRiv[i][1] < 0){
                   MD->FluxRiv[i][1] = 0;
              }
-
-             /* accumulate to get in-flow for down segments: [0] for inflow, [1] for outflow */
-             MD->FluxRiv[MD->Riv[i].down - 1][0] = MD->FluxRiv[MD->Riv[i].down - 1][0] + MD->FluxRiv[i][1];
          }
          /* Here the if statement ends for if there is a downstream river segment or not */
          else{
@@ -629,16 +362,16 @@ int f(realtype t, N_Vector CV_Y, N_Vector CV_Ydot, void *DS)
                    case -1:
 
                         /* Dirichlet boundary condition */
-                        TotalY_Riv_down = Interpolation(&MD->TSD_Riv[(MD->Riv[i].BC)-1], t) + MD->Node[MD->Riv[i].ToNode-1].zmin + MD->Riv_Shape[MD->Riv[i].shape-1].bed;
-                        Distance = (MD->Riv[i].Length)*0.5;
+                        TotalY_Riv_down = Interpolation(&MD->TSD_Riv[(MD->Riv[i].BC)-1], t) + MD->Node[MD->Riv[i].ToNode-1].zmin + MD->RivP.bed[i];
+                        Distance = (MD->RivP.Length[i])*0.5;
                         Dif_Y_Riv = (TotalY_Riv - TotalY_Riv_down)/Distance;
-                        Avg_Sf = MD->Riv_Mat[MD->Riv[i].material - 1].Sf;
-                        Avg_Rough = MD->Riv_Mat[MD->Riv[i].material-1].Rough;
+                        Avg_Sf = MD->RivP.Sf[i];
+                        Avg_Rough = MD->RivP.Rough[i];
                         Avg_Y_Riv = DummyY[i + 3*MD->NumEle];
                         Avg_Perem = Perem;
-                        CrossA = CS_AreaOrPerem(MD->Riv_Shape[MD->Riv[i].shape - 1].interpOrd,DummyY[i + 3*MD->NumEle],MD->Riv_Shape[MD->Riv[i].shape - 1].coeff,1);
+                        CrossA = CS_Area(MD->RivP.xs[i],DummyY[i + 3*MD->NumEle]);
 
-                        OverlandFlow(MD->FluxRiv,i,1,MD->RivMode, Avg_Y_Riv,Dif_Y_Riv,Avg_Sf,Alfa,Beta,CrossA,Avg_Rough,0,Avg_Perem);
+                        MD->FluxRiv[i][1] = ChanFlow(Dif_Y_Riv,Avg_Sf,CrossA,Avg_Rough,Avg_Perem);
 
                         break;
 
@@ -651,20 +384,20 @@ int f(realtype t, N_Vector CV_Y, N_Vector CV_Ydot, void *DS)
                    case -3:
 
                         /* zero-depth-gradient boundary conditions */
-                        Distance = (MD->Riv[i].Length)*0.5;
+                        Distance = (MD->RivP.Length[i])*0.5;
                         //Dif_Y_Riv = (MD->Riv[i].zmin - (MD->Node[MD->Riv[i].ToNode-1].zmax -MD->Riv[i].depth+ MD->Riv_Shape[MD->Riv[i].shape-1].bed))/Distance;
                           Dif_Y_Riv=0.1/Distance;
-                        Avg_Rough = MD->Riv_Mat[MD->Riv[i].material-1].Rough;
+                        Avg_Rough = MD->RivP.Rough[i];
                         Avg_Y_Riv = DummyY[i + 3*MD->NumEle];
                         Avg_Perem = Perem;
-                        CrossA = CS_AreaOrPerem(MD->Riv_Shape[MD->Riv[i].shape - 1].interpOrd,DummyY[i + 3*MD->NumEle],MD->Riv_Shape[MD->Riv[i].shape - 1].coeff,1);
-                        MD->FluxRiv[i][1] = sqrt(Dif_Y_Riv)*CrossA*(Perem>0?pow(CrossA/Perem,2.0/3.0):0)/Avg_Rough;
+                        CrossA = CS_Area(MD->RivP.xs[i],DummyY[i + 3*MD->NumEle]);
+                        MD->FluxRiv[i][1] = sqrt(Dif_Y_Riv)*CrossA*CS_R23(MD->RivP.xs[i],DummyY[i + 3*MD->NumEle])/Avg_Rough;
                         break;
                         /* #? How is critical dept being defined */
                    case -4:
 
                         /* Critical Depth boundary conditions */
-                        CrossA = CS_AreaOrPerem(MD->Riv_Shape[MD->Riv[i].shape - 1].interpOrd,DummyY[i + 3*MD->NumEle],MD->Riv_Shape[MD->Riv[i].shape - 1].coeff,1);
+                        CrossA = CS_Area(MD->RivP.xs[i],DummyY[i + 3*MD->NumEle]);
                         MD->FluxRiv[i][1] = CrossA*sqrt(GRAV*DummyY[i + 3*MD->NumEle]);
                         break;
 
@@ -682,72 +415,52 @@ int f(realtype t, N_Vector CV_Y, N_Vector CV_Ydot, void *DS)
                       MD->FluxRiv[i][1] = 0;
                        }  */            /* ######## Does this need to be commented */
 
-              /* #? Have to take care of this before it can be implemented on ny basin other than ShaleHIlls */
-              /* need some work to take care of multiple output Q */
-              MD->Q = MD->FluxRiv[i][1];
-
          }
 
          /* Lateral Surface Flux Calculation between River-Triangular element Follows */
-         if (MD->Riv[i].LeftEle > 0){
-              OLflowFromEleToRiv(DummyY[MD->Riv[i].LeftEle - 1],MD->Ele[MD->Riv[i].LeftEle - 1].zmax,MD->Riv[i].x,MD->Ele[MD->Riv[i].LeftEle - 1].x,MD->Riv[i].y,MD->Ele[MD->Riv[i].LeftEle - 1].y,MD->Riv_Mat[MD->Riv[i].material-1].Cwr, MD->Riv[i].zmax,TotalY_Riv,MD->FluxRiv,i,2,MD->Riv[i].Length);
+         if (MD->RivGeom[i].left >= 0){
+              OLflowFromEleToRiv(DummyY[MD->RivGeom[i].left],MD->EleP.zmax[MD->RivGeom[i].left],MD->RivGeom[i].leftDist,MD->RivP.Cwr[i], MD->RivP.zmax[i],TotalY_Riv,MD->FluxRiv,i,2,MD->RivP.Length[i]);
 
               /*     Correction is being done in flux terms which can be > 0 even when there is no source water level present */
               if(DummyY[i + 3*MD->NumEle] <= 0 && MD->FluxRiv[i][2] > 0){
                    MD->FluxRiv[i][2] = 0;
               }
 
-              if(DummyY[MD->Riv[i].LeftEle - 1] <= 0 && MD->FluxRiv[i][2] < 0){
+              if(DummyY[MD->RivGeom[i].left] <= 0 && MD->FluxRiv[i][2] < 0){
                    MD->FluxRiv[i][2] = 0;
               }
-
-              /* replace overland flux item */
-              for(j=0; j < 3; j++){
-                   /* this may cause trouble when there are 2 boundary side and one is not neutral.*/
-                   if(MD->Ele[MD->Riv[i].LeftEle - 1].nabr[j] == MD->Riv[i].RightEle){
-                        MD->FluxSurf[MD->Riv[i].LeftEle - 1][j] = -MD->FluxRiv[i][2];
-                   }
-              }
          }
 
-         if (MD->Riv[i].RightEle > 0){
-              OLflowFromEleToRiv(DummyY[MD->Riv[i].RightEle - 1],MD->Ele[MD->Riv[i].RightEle - 1].zmax,MD->Riv[i].x,MD->Ele[MD->Riv[i].RightEle - 1].x,MD->Riv[i].y,MD->Ele[MD->Riv[i].RightEle - 1].y,MD->Riv_Mat[MD->Riv[i].material-1].Cwr, MD->Riv[i].zmax,TotalY_Riv,MD->FluxRiv,i,3,MD->Riv[i].Length);
+         if (MD->RivGeom[i].right >= 0){
+              OLflowFromEleToRiv(DummyY[MD->RivGeom[i].right],MD->EleP.zmax[MD->RivGeom[i].right],MD->RivGeom[i].rightDist,MD->RivP.Cwr[i], MD->RivP.zmax[i],TotalY_Riv,MD->FluxRiv,i,3,MD->RivP.Length[i]);
 
               /*     Correction is being done in flux terms which can be > 0 even when there is no source water level present */
               if(DummyY[i + 3*MD->NumEle] <= 0 && MD->FluxRiv[i][3] > 0){
                    MD->FluxRiv[i][3] = 0;
               }
 
-              if(DummyY[MD->Riv[i].RightEle - 1] <= 0 && MD->FluxRiv[i][3] < 0){
+              if(DummyY[MD->RivGeom[i].right] <= 0 && MD->FluxRiv[i][3] < 0){
                    MD->FluxRiv[i][3] = 0;
               }
-
-              /* replace overland flux item */
-              for(j=0; j < 3; j++){
-                   if(MD->Ele[MD->Riv[i].RightEle - 1].nabr[j] == MD->Riv[i].LeftEle){
-                        MD->FluxSurf[MD->Riv[i].RightEle - 1][j] = -MD->FluxRiv[i][3];
-                        break;
-                   }
-              }
          }
          /* Lateral Sub-surface Flux Calculation between River-Triangular element Follows */
-         if (MD->Riv[i].LeftEle > 0){
+         if (MD->RivGeom[i].left >= 0){
               /* Left Neighbor Groundwater Head */
               /*********************TRANSFER THIS INSIDE FUNC*****************************/
-              if((MD->Ele[MD->Riv[i].LeftEle - 1].zmax-MD->Ele[MD->Riv[i].LeftEle - 1].zmin)-DummyY[MD->Riv[i].LeftEle - 1+2*MD->NumEle]-DummyY[MD->Riv[i].LeftEle - 1+MD->NumEle]<=0){
+              if(MD->EleP.AqDepth[MD->RivGeom[i].left]-DummyY[MD->RivGeom[i].left+2*MD->NumEle]-DummyY[MD->RivGeom[i].left+MD->NumEle]<=0){
                    elemSatn=1.0;
               }
               else{
-                   elemSatn = DummyY[MD->Riv[i].LeftEle - 1+2*MD->NumEle]/(MD->Ele[MD->Riv[i].LeftEle - 1].zmax-MD->Ele[MD->Riv[i].LeftEle - 1].zmin);   /*  Will have to change this for other formulation */
+                   elemSatn = DummyY[MD->RivGeom[i].left+2*MD->NumEle]/MD->EleP.AqDepth[MD->RivGeom[i].left];   /*  Will have to change this for other formulation */
               }
 
-              if (MD->Soil[(MD->Ele[MD->Riv[i].LeftEle - 1].soil-1)].Macropore == 0){
+              if (MD->EleP.Macropore[MD->RivGeom[i].left] == 0){
                    mp_factor = 1;
               }
-              else if (MD->Soil[(MD->Ele[MD->Riv[i].LeftEle - 1].soil-1)].Macropore == 1){
-                   if((elemSatn>=sat_THRESH)&&(DummyY[MD->Riv[i].LeftEle - 1]>ovl_THRESH_H)){
-                        mp_factor=1.0+mp_MULTFH*(elemSatn-sat_THRESH)/(1-sat_THRESH);
-                        mp_factor=mp_factor*mpArea_CALIB+1*(1-mpArea_CALIB);
+              else if (MD->EleP.Macropore[MD->RivGeom[i].left] == 1){
+                   if((elemSatn>=MD->Cal.satThresh)&&(DummyY[MD->RivGeom[i].left]>MD->Cal.ovlThreshH)){
+                        mp_factor=1.0+MD->Cal.mpSlopeH*(elemSatn-MD->Cal.satThresh);
+                        mp_factor=mp_factor*MD->Cal.mpArea+1*(1-MD->Cal.mpArea);
                    }
                    else{
                         mp_factor = 1.0;
@@ -756,33 +469,33 @@ int f(realtype t, N_Vector CV_Y, N_Vector CV_Ydot, void *DS)
               /**************************************************************************/
 
 
-              if( (MD->Riv[i].zmin + DummyY[i+3*MD->NumEle] - (DummyY[MD->Riv[i].LeftEle - 1 + 2*MD->NumEle]+MD->Ele[MD->Riv[i].LeftEle - 1].zmin))>0 ){
+              if( (MD->RivP.zmin[i] + DummyY[i+3*MD->NumEle] - (DummyY[MD->RivGeom[i].left + 2*MD->NumEle]+MD->EleP.zmin[MD->RivGeom[i].left]))>0 ){
                       loc_perem=Perem;
               }
               else{
-                    if(MD->Ele[MD->Riv[i].LeftEle - 1].zmin < MD->Riv[i].zmin){
-                          if( (DummyY[MD->Riv[i].LeftEle - 1 + 2*MD->NumEle] + MD->Ele[MD->Riv[i].LeftEle - 1].zmin - MD->Riv[i].zmin) > MD->Riv[i].depth ){
-                              loc_perem = CS_AreaOrPerem(MD->Riv_Shape[MD->Riv[i].shape - 1].interpOrd,MD->Riv[i].depth,MD->Riv_Shape[MD->Riv[i].shape - 1].coeff,2);
+                    if(MD->EleP.zmin[MD->RivGeom[i].left] < MD->RivP.zmin[i]){
+                          if( (DummyY[MD->RivGeom[i].left + 2*MD->NumEle] + MD->EleP.zmin[MD->RivGeom[i].left] - MD->RivP.zmin[i]) > MD->RivP.depth[i] ){
+                              loc_perem = CS_Perem(MD->RivP.xs[i],MD->RivP.depth[i]);
 
                         }
                           else{
-                              loc_perem = CS_AreaOrPerem(MD->Riv_Shape[MD->Riv[i].shape - 1].interpOrd,(DummyY[MD->Riv[i].LeftEle - 1 + 2*MD->NumEle] + MD->Ele[MD->Riv[i].LeftEle - 1].zmin - MD->Riv[i].zmin),MD->Riv_Shape[MD->Riv[i].shape - 1].coeff,2);
+                              loc_perem = CS_Perem(MD->RivP.xs[i],(DummyY[MD->RivGeom[i].left + 2*MD->NumEle] + MD->EleP.zmin[MD->RivGeom[i].left] - MD->RivP.zmin[i]));
                         }
                     }
                     else{
-                        if( DummyY[MD->Riv[i].LeftEle - 1 + 2*MD->NumEle] > MD->Riv[i].depth){
-                            loc_perem = CS_AreaOrPerem(MD->Riv_Shape[MD->Riv[i].shape - 1].interpOrd,MD->Riv[i].depth,MD->Riv_Shape[MD->Riv[i].shape - 1].coeff,2);
+                        if( DummyY[MD->RivGeom[i].left + 2*MD->NumEle] > MD->RivP.depth[i]){
+                            loc_perem = CS_Perem(MD->RivP.xs[i],MD->RivP.depth[i]);
                         }
                         else{
-                            loc_perem = CS_AreaOrPerem(MD->Riv_Shape[MD->Riv[i].shape - 1].interpOrd,DummyY[MD->Riv[i].LeftEle - 1 + 2*MD->NumEle],MD->Riv_Shape[MD->Riv[i].shape - 1].coeff,2);
+                            loc_perem = CS_Perem(MD->RivP.xs[i],DummyY[MD->RivGeom[i].left + 2*MD->NumEle]);
                         }
                     }
               }
 
-              GWflowFromEleToRiv(DummyY[MD->Riv[i].LeftEle - 1 + 2*MD->NumEle],MD->Ele[MD->Riv[i].LeftEle - 1].zmax,MD->Ele[MD->Riv[i].LeftEle - 1].zmin,MD->Riv[i].x,MD->Ele[MD->Riv[i].LeftEle - 1].x,MD->Riv[i].y,MD->Ele[MD->Riv[i].LeftEle - 1].y,MD->Soil[(MD->Ele[MD->Riv[i].LeftEle - 1].soil-1)].Macropore,DummyY[i+3*MD->NumEle],TotalY_Riv,MD->FluxRiv,i,4,MD->Riv[i].Length,MD->Soil[(MD->Ele[MD->Riv[i].LeftEle - 1].soil-1)].base,mp_factor,loc_perem,MD->Ele[MD->Riv[i].LeftEle - 1].Ksat,MD->Ele[MD->Riv[i].LeftEle-1].RzD); /* delete replace Wid by 0.5*avg_perim */
+              GWflowFromEleToRiv(DummyY[MD->RivGeom[i].left + 2*MD->NumEle],MD->EleP.zmax[MD->RivGeom[i].left],MD->EleP.zmin[MD->RivGeom[i].left],MD->RivGeom[i].leftDist,MD->EleP.Macropore[MD->RivGeom[i].left],DummyY[i+3*MD->NumEle],TotalY_Riv,MD->FluxRiv,i,4,MD->RivP.Length[i],MD->EleP.base[MD->RivGeom[i].left],mp_factor,loc_perem,MD->EleP.Ksat[MD->RivGeom[i].left],MD->EleP.RzD[MD->RivGeom[i].left],MD->Cal.rivK); /* delete replace Wid by 0.5*avg_perim */
 
               /* Saturation check */
-              if((DummyY[MD->Riv[i].LeftEle - 1 + 2*MD->NumEle] >= MD->Ele[MD->Riv[i].LeftEle - 1 + 2*MD->NumEle].zmax-MD->Ele[MD->Riv[i].LeftEle - 1 + 2*MD->NumEle].zmin) && MD->FluxRiv[i][4] > 0){
+              if((DummyY[MD->RivGeom[i].left + 2*MD->NumEle] >= MD->EleP.AqDepth[MD->RivGeom[i].left]) && MD->FluxRiv[i][4] > 0){
                    MD->FluxRiv[i][4]  = 0;
               }
 
@@ -791,93 +504,60 @@ int f(realtype t, N_Vector CV_Y, N_Vector CV_Ydot, void *DS)
               if(DummyY[i+3*MD->NumEle] <= 0 && MD->FluxRiv[i][4] > 0){
                    MD->FluxRiv[i][4] = 0;
               }
-              if(DummyY[MD->Riv[i].LeftEle - 1 + 2*MD->NumEle] <= 0 && MD->FluxRiv[i][4] < 0){
+              if(DummyY[MD->RivGeom[i].left + 2*MD->NumEle] <= 0 && MD->FluxRiv[i][4] < 0){
                    MD->FluxRiv[i][4] = 0;
               }
-
-              /* modify groundwater flux item */
-              for(j=0; j < 3; j++){
-                   if(MD->Ele[MD->Riv[i].LeftEle - 1].nabr[j] == MD->Riv[i].RightEle){
-                        if(MD->Ele[MD->Ele[MD->Riv[i].LeftEle - 1].nabr[j]-1].zmin>MD->Ele[MD->Riv[i].LeftEle - 1].zmin){
-                                if(MD->Ele[MD->Ele[MD->Riv[i].LeftEle - 1].nabr[j]-1].zmin>MD->Ele[MD->Riv[i].LeftEle - 1].zmin+DummyY[MD->Riv[i].LeftEle - 1+2*MD->NumEle]){
-                                   Avg_Y_Sub=DummyY[MD->Ele[MD->Riv[i].LeftEle - 1].nabr[j]-1 + 2*MD->NumEle]/2;
-                             }
-                                else{
-                                      Avg_Y_Sub=(DummyY[MD->Riv[i].LeftEle - 1+2*MD->NumEle]+MD->Ele[MD->Riv[i].LeftEle - 1].zmin-MD->Ele[MD->Ele[MD->Riv[i].LeftEle - 1].nabr[j]-1].zmin+DummyY[MD->Ele[MD->Riv[i].LeftEle - 1].nabr[j]-1 + 2*MD->NumEle])/2;
-                             }
-                        }
-                           else{
-                                if(MD->Ele[MD->Riv[i].LeftEle - 1].zmin>MD->Ele[MD->Ele[MD->Riv[i].LeftEle - 1].nabr[j]-1].zmin+DummyY[MD->Ele[MD->Riv[i].LeftEle - 1].nabr[j]-1 + 2*MD->NumEle]){
-                                   Avg_Y_Sub=DummyY[MD->Riv[i].LeftEle - 1+2*MD->NumEle]/2;
-                                }
-                                else{
-                                      Avg_Y_Sub=(DummyY[MD->Riv[i].LeftEle - 1+2*MD->NumEle]+DummyY[MD->Ele[MD->Riv[i].LeftEle - 1].nabr[j]-1 + 2*MD->NumEle]+MD->Ele[MD->Ele[MD->Riv[i].LeftEle - 1].nabr[j]-1].zmin-MD->Ele[MD->Riv[i].LeftEle - 1].zmin)/2;
-                                }
-                           }
-                        Avg_BedDepth = (MD->Ele[MD->Riv[i].RightEle-1].zmax-MD->Ele[MD->Riv[i].RightEle-1].zmin + MD->Ele[MD->Riv[i].LeftEle-1].zmax-MD->Ele[MD->Riv[i].LeftEle-1].zmin)*0.5;
-                        if(Avg_BedDepth - MD->Riv[i].depth <= 0)
-                        {
-                            MD->FluxSub[MD->Riv[i].LeftEle - 1][j] = 0.0;
-                        }
-                        else{
-                            if (Avg_Y_Sub > Avg_BedDepth - MD->Riv[i].depth){
-                                MD->FluxSub[MD->Riv[i].LeftEle - 1][j] = MD->FluxSub[MD->Riv[i].LeftEle - 1][j] * (Avg_BedDepth - MD->Riv[i].depth) / Avg_Y_Sub;
-                            }
-                        }
-                        break;
-                   }
-              }
          }
 
-         if (MD->Riv[i].RightEle > 0){
+         if (MD->RivGeom[i].right >= 0){
          /************************TRANSFER THIS INSIDE FUNC*******************/
-              if((MD->Ele[MD->Riv[i].RightEle - 1].zmax-MD->Ele[MD->Riv[i].RightEle - 1].zmin)-DummyY[MD->Riv[i].RightEle - 1+2*MD->NumEle]-DummyY[MD->Riv[i].RightEle - 1+MD->NumEle]<=0){
+              if(MD->EleP.AqDepth[MD->RivGeom[i].right]-DummyY[MD->RivGeom[i].right+2*MD->NumEle]-DummyY[MD->RivGeom[i].right+MD->NumEle]<=0){
                    elemSatn=1.0;
               }
               else{
-                   elemSatn = DummyY[MD->Riv[i].RightEle - 1+2*MD->NumEle]/(MD->Ele[MD->Riv[i].RightEle - 1].zmax-MD->Ele[MD->Riv[i].RightEle - 1].zmin);   /*  Will have to change this for other formulation */
+                   elemSatn = DummyY[MD->RivGeom[i].right+2*MD->NumEle]/MD->EleP.AqDepth[MD->RivGeom[i].right];   /*  Will have to change this for other formulation */
               }
 
-              if (MD->Soil[(MD->Ele[MD->Riv[i].RightEle - 1].soil-1)].Macropore == 0){
+              if (MD->EleP.Macropore[MD->RivGeom[i].right] == 0){
                    mp_factor = 1;
               }
-              else if (MD->Soil[(MD->Ele[MD->Riv[i].RightEle - 1].soil-1)].Macropore == 1){
-                   if((elemSatn>=sat_THRESH)&&(DummyY[MD->Riv[i].RightEle - 1]>ovl_THRESH_H)){
-                        mp_factor=1.0+mp_MULTFH*(elemSatn-sat_THRESH)/(1-sat_THRESH);
-                        mp_factor=mp_factor*mpArea_CALIB+1*(1-mpArea_CALIB);
+              else if (MD->EleP.Macropore[MD->RivGeom[i].right] == 1){
+                   if((elemSatn>=MD->Cal.satThresh)&&(DummyY[MD->RivGeom[i].right]>MD->Cal.ovlThreshH)){
+                        mp_factor=1.0+MD->Cal.mpSlopeH*(elemSatn-MD->Cal.satThresh);
+                        mp_factor=mp_factor*MD->Cal.mpArea+1*(1-MD->Cal.mpArea);
                    }
                    else{
                         mp_factor = 1.0;
                    }
               }
               /*******************************************************************/
-              if( (MD->Riv[i].zmin + DummyY[i+3*MD->NumEle] - (DummyY[MD->Riv[i].RightEle - 1 + 2*MD->NumEle]+MD->Ele[MD->Riv[i].RightEle - 1].zmin))>0 ){
+              if( (MD->RivP.zmin[i] + DummyY[i+3*MD->NumEle] - (DummyY[MD->RivGeom[i].right + 2*MD->NumEle]+MD->EleP.zmin[MD->RivGeom[i].right]))>0 ){
                       loc_perem=Perem;
               }
               else{
-                    if(MD->Ele[MD->Riv[i].RightEle - 1].zmin < MD->Riv[i].zmin){
-                          if( (DummyY[MD->Riv[i].RightEle - 1 + 2*MD->NumEle] + MD->Ele[MD->Riv[i].RightEle - 1].zmin - MD->Riv[i].zmin) > MD->Riv[i].depth ){
-                              loc_perem = CS_AreaOrPerem(MD->Riv_Shape[MD->Riv[i].shape - 1].interpOrd,MD->Riv[i].depth,MD->Riv_Shape[MD->Riv[i].shape - 1].coeff,2);
+                    if(MD->EleP.zmin[MD->RivGeom[i].right] < MD->RivP.zmin[i]){
+                          if( (DummyY[MD->RivGeom[i].right + 2*MD->NumEle] + MD->EleP.zmin[MD->RivGeom[i].right] - MD->RivP.zmin[i]) > MD->RivP.depth[i] ){
+                              loc_perem = CS_Perem(MD->RivP.xs[i],MD->RivP.depth[i]);
 
                         }
                           else{
-                              loc_perem = CS_AreaOrPerem(MD->Riv_Shape[MD->Riv[i].shape - 1].interpOrd,(DummyY[MD->Riv[i].RightEle - 1 + 2*MD->NumEle] + MD->Ele[MD->Riv[i].RightEle - 1].zmin - MD->Riv[i].zmin),MD->Riv_Shape[MD->Riv[i].shape - 1].coeff,2);
+                              loc_perem = CS_Perem(MD->RivP.xs[i],(DummyY[MD->RivGeom[i].right + 2*MD->NumEle] + MD->EleP.zmin[MD->RivGeom[i].right] - MD->RivP.zmin[i]));
                         }
                     }
                     else{
-                        if( DummyY[MD->Riv[i].RightEle - 1 + 2*MD->NumEle] > MD->Riv[i].depth){
-                            loc_perem = CS_AreaOrPerem(MD->Riv_Shape[MD->Riv[i].shape - 1].interpOrd,MD->Riv[i].depth,MD->Riv_Shape[MD->Riv[i].shape - 1].coeff,2);
+                        if( DummyY[MD->RivGeom[i].right + 2*MD->NumEle] > MD->RivP.depth[i]){
+                            loc_perem = CS_Perem(MD->RivP.xs[i],MD->RivP.depth[i]);
                         }
                         else{
-                            loc_perem = CS_AreaOrPerem(MD->Riv_Shape[MD->Riv[i].shape - 1].interpOrd,DummyY[MD->Riv[i].RightEle - 1 + 2*MD->NumEle],MD->Riv_Shape[MD->Riv[i].shape - 1].coeff,2);
+                            loc_perem = CS_Perem(MD->RivP.xs[i],DummyY[MD->RivGeom[i].right + 2*MD->NumEle]);
                         }
                     }
               }
 
-              GWflowFromEleToRiv(DummyY[MD->Riv[i].RightEle - 1 + 2*MD->NumEle],MD->Ele[MD->Riv[i].RightEle - 1].zmax,MD->Ele[MD->Riv[i].RightEle - 1].zmin,MD->Riv[i].x,MD->Ele[MD->Riv[i].RightEle - 1].x,MD->Riv[i].y,MD->Ele[MD->Riv[i].RightEle - 1].y,MD->Soil[(MD->Ele[MD->Riv[i].RightEle - 1].soil-1)].Macropore,DummyY[i+3*MD->NumEle],TotalY_Riv,MD->FluxRiv,i,5,MD->Riv[i].Length,MD->Soil[(MD->Ele[MD->Riv[i].RightEle - 1].soil-1)].base,mp_factor,loc_perem,MD->Ele[MD->Riv[i].RightEle - 1].Ksat,MD->Ele[MD->Riv[i].RightEle-1].RzD); /* delete replace Wid by 0.5*avg_perim */
+              GWflowFromEleToRiv(DummyY[MD->RivGeom[i].right + 2*MD->NumEle],MD->EleP.zmax[MD->RivGeom[i].right],MD->EleP.zmin[MD->RivGeom[i].right],MD->RivGeom[i].rightDist,MD->EleP.Macropore[MD->RivGeom[i].right],DummyY[i+3*MD->NumEle],TotalY_Riv,MD->FluxRiv,i,5,MD->RivP.Length[i],MD->EleP.base[MD->RivGeom[i].right],mp_factor,loc_perem,MD->EleP.Ksat[MD->RivGeom[i].right],MD->EleP.RzD[MD->RivGeom[i].right],MD->Cal.rivK); /* delete replace Wid by 0.5*avg_perim */
 
               /* Saturation check */
-              if((DummyY[MD->Riv[i].RightEle - 1 + 2*MD->NumEle] >= MD->Ele[MD->Riv[i].RightEle - 1 + 2*MD->NumEle].zmax-MD->Ele[MD->Riv[i].RightEle - 1 + 2*MD->NumEle].zmin) && MD->FluxRiv[i][5] > 0){
+              if((DummyY[MD->RivGeom[i].right + 2*MD->NumEle] >= MD->EleP.AqDepth[MD->RivGeom[i].right]) && MD->FluxRiv[i][5] > 0){
                    MD->FluxRiv[i][5]  = 0;
               }
 
@@ -885,63 +565,139 @@ int f(realtype t, N_Vector CV_Y, N_Vector CV_Ydot, void *DS)
               if(DummyY[i + 3*MD->NumEle] <= 0 && MD->FluxRiv[i][5] > 0){
                    MD->FluxRiv[i][5] = 0;
               }
-              if(DummyY[MD->Riv[i].RightEle - 1 + 2*MD->NumEle] <= 0 && MD->FluxRiv[i][5] < 0){
+              if(DummyY[MD->RivGeom[i].right + 2*MD->NumEle] <= 0 && MD->FluxRiv[i][5] < 0){
                    MD->FluxRiv[i][5] = 0;
               }
+         }
+    }
+
+    /* Inflow of each segment is gathered from its upstream segments (ascending order, built in initialize()) */
+    nNaN = 0;
+    #pragma omp parallel for private(k) reduction(+:nNaN)
+    for(i=0; i<MD->NumRiv; i++){
+         /* accumulate to get in-flow for down segments: [0] for inflow, [1] for outflow */
+         for(k=MD->RivUpPtr[i]; k<MD->RivUpPtr[i+1]; k++){
+              MD->FluxRiv[i][0] = MD->FluxRiv[i][0] + MD->FluxRiv[MD->RivUp[k]][1];
+         }
+
+          if(isnan(MD->FluxRiv[i][0])||isnan(MD->FluxRiv[i][1])||isnan(MD->FluxRiv[i][2])||isnan(MD->FluxRiv[i][3])||isnan(MD->FluxRiv[i][4])||isnan(MD->FluxRiv[i][5])){
+              nNaN++;
+         }
+    }
+    if(nNaN > 0){
+         /* reported after the parallel loop; an outlet segment (down < 0) has no downstream segment to print */
+         for(i=0; i<MD->NumRiv; i++){
+              if(isnan(MD->FluxRiv[i][0])||isnan(MD->FluxRiv[i][1])||isnan(MD->FluxRiv[i][2])||isnan(MD->FluxRiv[i][3])||isnan(MD->FluxRiv[i][4])||isnan(MD->FluxRiv[i][5])){
+                   k = MD->Riv[i].down > 0 ? MD->Riv[i].down-1 : i;
+                   printf("\n2: %d %d %d %d :%lf %lf: %lf %lf: %lf %lf: %lf %lf %lf %lf %lf %lf",MD->Riv[i].index,MD->Riv[i].down > 0 ? MD->Riv[k].index : MD->Riv[i].down,MD->Riv[i].LeftEle,MD->Riv[i].RightEle,DummyY[i+3*MD->NumEle],DummyY[k+3*MD->NumEle],DummyY[MD->RivGeom[i].left + 2*MD->NumEle],DummyY[MD->RivGeom[i].left + 0*MD->NumEle],DummyY[MD->RivGeom[i].right + 2*MD->NumEle],DummyY[MD->RivGeom[i].right + 0*MD->NumEle],MD->FluxRiv[i][0],MD->FluxRiv[i][1],MD->FluxRiv[i][2],MD->FluxRiv[i][3],MD->FluxRiv[i][4],MD->FluxRiv[i][5]);
+              }
+         }
+    }
+
+    /* #? Have to take care of this before it can be implemented on ny basin other than ShaleHIlls */
+    /* need some work to take care of multiple output Q */
+    if(MD->RivOutlet >= 0){
+         MD->Q = MD->FluxRiv[MD->RivOutlet][1];
+    }
 
-              /* modify groundwater flux item */
-              for(j=0; j < 3; j++){
-                  if(MD->Ele[MD->Riv[i].RightEle - 1].nabr[j] == MD->Riv[i].LeftEle){
-                        if(MD->Ele[MD->Ele[MD->Riv[i].RightEle - 1].nabr[j]-1].zmin>MD->Ele[MD->Riv[i].RightEle - 1].zmin){
-                                if(MD->Ele[MD->Ele[MD->Riv[i].RightEle - 1].nabr[j]-1].zmin>MD->Ele[MD->Riv[i].RightEle - 1].zmin+DummyY[MD->Riv[i].RightEle - 1+2*MD->NumEle]){
-                                   Avg_Y_Sub=DummyY[MD->Ele[MD->Riv[i].RightEle - 1].nabr[j]-1 + 2*MD->NumEle]/2;
+    /* Bank elements gather the exchange with their river segments, in ascending segment order */
+    #pragma omp parallel for private(i,j,l,Avg_Y_Sub,Avg_BedDepth)
+    for(k=0; k<MD->NumEle; k++){
+         for(l=MD->EleRivPtr[k]; l<MD->EleRivPtr[k+1]; l++){
+              i = MD->EleRiv[l]/2;
+              if(MD->EleRiv[l]%2 == 0){
+                   /* replace overland flux item */
+                   if(MD->RivGeom[i].leftSlot >= 0){
+                        MD->FluxSurf[MD->RivGeom[i].left][MD->RivGeom[i].leftSlot] = -MD->FluxRiv[i][2];
+                   }
+                   else{
+                        DummyDY[MD->RivGeom[i].left] = DummyDY[MD->RivGeom[i].left] + MD->FluxRiv[i][2]/MD->EleP.area[MD->RivGeom[i].left];
+                   }
+
+                   /* modify groundwater flux item (the face shared with the right bank) */
+                   j = MD->RivGeom[i].leftSlot;
+                   if(j >= 0 && MD->RivGeom[i].right >= 0){
+                        if(MD->EleP.zmin[MD->RivGeom[i].right]>MD->EleP.zmin[MD->RivGeom[i].left]){
+                                if(MD->EleP.zmin[MD->RivGeom[i].right]>MD->EleP.zmin[MD->RivGeom[i].left]+DummyY[MD->RivGeom[i].left+2*MD->NumEle]){
+                                   Avg_Y_Sub=DummyY[MD->RivGeom[i].right + 2*MD->NumEle]/2;
                              }
                                 else{
-                                      Avg_Y_Sub=(DummyY[MD->Riv[i].RightEle - 1+2*MD->NumEle]+MD->Ele[MD->Riv[i].RightEle - 1].zmin-MD->Ele[MD->Ele[MD->Riv[i].RightEle - 1].nabr[j]-1].zmin+DummyY[MD->Ele[MD->Riv[i].RightEle - 1].nabr[j]-1 + 2*MD->NumEle])/2;
+                                      Avg_Y_Sub=(DummyY[MD->RivGeom[i].left+2*MD->NumEle]+MD->EleP.zmin[MD->RivGeom[i].left]-MD->EleP.zmin[MD->RivGeom[i].right]+DummyY[MD->RivGeom[i].right + 2*MD->NumEle])/2;
                              }
                         }
                            else{
-                                if(MD->Ele[MD->Riv[i].RightEle - 1].zmin>MD->Ele[MD->Ele[MD->Riv[i].RightEle - 1].nabr[j]-1].zmin+DummyY[MD->Ele[MD->Riv[i].RightEle - 1].nabr[j]-1 + 2*MD->NumEle]){
-                                   Avg_Y_Sub=DummyY[MD->Riv[i].RightEle - 1+2*MD->NumEle]/2;
+                                if(MD->EleP.zmin[MD->RivGeom[i].left]>MD->EleP.zmin[MD->RivGeom[i].right]+DummyY[MD->RivGeom[i].right + 2*MD->NumEle]){
+                                   Avg_Y_Sub=DummyY[MD->RivGeom[i].left+2*MD->NumEle]/2;
                                 }
                                 else{
-                                      Avg_Y_Sub=(DummyY[MD->Riv[i].RightEle - 1+2*MD->NumEle]+DummyY[MD->Ele[MD->Riv[i].RightEle - 1].nabr[j]-1 + 2*MD->NumEle]+MD->Ele[MD->Ele[MD->Riv[i].RightEle - 1].nabr[j]-1].zmin-MD->Ele[MD->Riv[i].RightEle - 1].zmin)/2;
+                                      Avg_Y_Sub=(DummyY[MD->RivGeom[i].left+2*MD->NumEle]+DummyY[MD->RivGeom[i].right + 2*MD->NumEle]+MD->EleP.zmin[MD->RivGeom[i].right]-MD->EleP.zmin[MD->RivGeom[i].left])/2;
                                 }
                            }
-                          Avg_BedDepth = (MD->Ele[MD->Riv[i].LeftEle-1].zmax-MD->Ele[MD->Riv[i].LeftEle-1].zmin + MD->Ele[MD->Riv[i].RightEle-1].zmax-MD->Ele[MD->Riv[i].RightEle-1].zmin)*0.5;
-                        if(Avg_BedDepth - MD->Riv[i].depth <= 0){
-                            MD->FluxSub[MD->Riv[i].RightEle - 1][j] = 0.0;
+                        Avg_BedDepth = (MD->EleP.AqDepth[MD->RivGeom[i].right] + MD->EleP.AqDepth[MD->RivGeom[i].left])*0.5;
+                        if(Avg_BedDepth - MD->RivP.depth[i] <= 0)
+                        {
+                            MD->FluxSub[MD->RivGeom[i].left][j] = 0.0;
                         }
                         else{
-                              if (Avg_Y_Sub > Avg_BedDepth - MD->Riv[i].depth){
-                                  MD->FluxSub[MD->Riv[i].RightEle - 1][j] = MD->FluxSub[MD->Riv[i].RightEle - 1][j] * (Avg_BedDepth - MD->Riv[i].depth) / Avg_Y_Sub;
+                            if (Avg_Y_Sub > Avg_BedDepth - MD->RivP.depth[i]){
+                                MD->FluxSub[MD->RivGeom[i].left][j] = MD->FluxSub[MD->RivGeom[i].left][j] * (Avg_BedDepth - MD->RivP.depth[i]) / Avg_Y_Sub;
                             }
-                          }
-                        break;
-                  }
+                        }
+                   }
+
+                   DummyDY[MD->RivGeom[i].left + 2*MD->NumEle] = DummyDY[MD->RivGeom[i].left + 2*MD->NumEle] + MD->FluxRiv[i][4]/MD->EleP.area[MD->RivGeom[i].left];
               }
-         }
-         /**************************************************************************************************/
-         if (MD->Riv[i].LeftEle > 0){
-              DummyDY[MD->Riv[i].LeftEle-1 + 2*MD->NumEle] = DummyDY[MD->Riv[i].LeftEle-1 + 2*MD->NumEle] + MD->FluxRiv[i][4]/MD->Ele[MD->Riv[i].LeftEle-1].area;
-         }
-         if (MD->Riv[i].RightEle > 0){
-              DummyDY[MD->Riv[i].RightEle-1 + 2*MD->NumEle] = DummyDY[MD->Riv[i].RightEle-1 + 2*MD->NumEle]
-                                 + MD->FluxRiv[i][5]/MD->Ele[MD->Riv[i].RightEle-1].area;
-         }
+              else{
+                   /* replace overland flux item */
+                   if(MD->RivGeom[i].rightSlot >= 0){
+                        MD->FluxSurf[MD->RivGeom[i].right][MD->RivGeom[i].rightSlot] = -MD->FluxRiv[i][3];
+                   }
+                   else{
+                        DummyDY[MD->RivGeom[i].right] = DummyDY[MD->RivGeom[i].right] + MD->FluxRiv[i][3]/MD->EleP.area[MD->RivGeom[i].right];
+                   }
 
-         /**************************************************************************************************/
-          if((isnan(MD->FluxRiv[i][0])==1)||(isnan(MD->FluxRiv[i][1])==1)||(isnan(MD->FluxRiv[i][2])==1)||(isnan(MD->FluxRiv[i][3])==1)||(isnan(MD->FluxRiv[i][4])==1)||(isnan(MD->FluxRiv[i][5])==1)){
-              printf("\n2: %d %d %d %d :%lf %lf: %lf %lf: %lf %lf: %lf %lf %lf %lf %lf %lf",MD->Riv[i].index,MD->Riv[MD->Riv[i].down-1].index,MD->Riv[i].LeftEle,MD->Riv[i].RightEle,DummyY[i+3*MD->NumEle],DummyY[MD->Riv[i].down-1+3*MD->NumEle],DummyY[MD->Riv[i].LeftEle-1 + 2*MD->NumEle],DummyY[MD->Riv[i].LeftEle-1 + 0*MD->NumEle],DummyY[MD->Riv[i].RightEle-1 + 2*MD->NumEle],DummyY[MD->Riv[i].RightEle-1 + 0*MD->NumEle],MD->FluxRiv[i][0],MD->FluxRiv[i][1],MD->FluxRiv[i][2],MD->FluxRiv[i][3],MD->FluxRiv[i][4],MD->FluxRiv[i][5]);
-              getchar();
+                   /* modify groundwater flux item (the face shared with the left bank) */
+                   j = MD->RivGeom[i].rightSlot;
+                   if(j >= 0 && MD->RivGeom[i].left >= 0){
+                        if(MD->EleP.zmin[MD->RivGeom[i].left]>MD->EleP.zmin[MD->RivGeom[i].right]){
+                                if(MD->EleP.zmin[MD->RivGeom[i].left]>MD->EleP.zmin[MD->RivGeom[i].right]+DummyY[MD->RivGeom[i].right+2*MD->NumEle]){
+                                   Avg_Y_Sub=DummyY[MD->RivGeom[i].left + 2*MD->NumEle]/2;
+                             }
+                                else{
+                                      Avg_Y_Sub=(DummyY[MD->RivGeom[i].right+2*MD->NumEle]+MD->EleP.zmin[MD->RivGeom[i].right]-MD->EleP.zmin[MD->RivGeom[i].left]+DummyY[MD->RivGeom[i].left + 2*MD->NumEle])/2;
+                             }
+                        }
+                           else{
+                                if(MD->EleP.zmin[MD->RivGeom[i].right]>MD->EleP.zmin[MD->RivGeom[i].left]+DummyY[MD->RivGeom[i].left + 2*MD->NumEle]){
+                                   Avg_Y_Sub=DummyY[MD->RivGeom[i].right+2*MD->NumEle]/2;
+                                }
+                                else{
+                                      Avg_Y_Sub=(DummyY[MD->RivGeom[i].right+2*MD->NumEle]+DummyY[MD->RivGeom[i].left + 2*MD->NumEle]+MD->EleP.zmin[MD->RivGeom[i].left]-MD->EleP.zmin[MD->RivGeom[i].right])/2;
+                                }
+                           }
+                          Avg_BedDepth = (MD->EleP.AqDepth[MD->RivGeom[i].left] + MD->EleP.AqDepth[MD->RivGeom[i].right])*0.5;
+                        if(Avg_BedDepth - MD->RivP.depth[i] <= 0){
+                            MD->FluxSub[MD->RivGeom[i].right][j] = 0.0;
+                        }
+                        else{
+                              if (Avg_Y_Sub > Avg_BedDepth - MD->RivP.depth[i]){
+                                  MD->FluxSub[MD->RivGeom[i].right][j] = MD->FluxSub[MD->RivGeom[i].right][j] * (Avg_BedDepth - MD->RivP.depth[i]) / Avg_Y_Sub;
+                            }
+                          }
+                   }
+
+                   DummyDY[MD->RivGeom[i].right + 2*MD->NumEle] = DummyDY[MD->RivGeom[i].right + 2*MD->NumEle]
+                                      + MD->FluxRiv[i][5]/MD->EleP.area[MD->RivGeom[i].right];
+              }
          }
     }
 
 
+    #pragma omp parallel for private(j,AquiferDepth,ye)
     for(i=0; i<MD->NumEle; i++){
          for(j=0; j<3; j++){
-              DummyDY[i] =  DummyDY[i] - MD->FluxSurf[i][j]/MD->Ele[i].area;
-              DummyDY[i+2*MD->NumEle] = DummyDY[i+2*MD->NumEle] - MD->FluxSub[i][j]/MD->Ele[i].area;
+              DummyDY[i] =  DummyDY[i] - MD->FluxSurf[i][j]/MD->EleP.area[i];
+              DummyDY[i+2*MD->NumEle] = DummyDY[i+2*MD->NumEle] - MD->FluxSub[i][j]/MD->EleP.area[i];
          }
          /*
          if(i==144){
@@ -966,29 +722,14 @@ int f(realtype t, N_Vector CV_Y, N_Vector CV_Ydot, void *DS)
         */
         //DummyDY[i+MD->NumEle] = DummyDY[i+MD->NumEle]/MD->Ele[i].Porosity;        /* ## Explicitly define porosity */
 
-        AquiferDepth = MD->Ele[i].zmax - MD->Ele[i].zmin;
-        Deficit = AquiferDepth - DummyY[i+2*MD->NumEle];
-        //      PH = 1 - exp(-MD->Ele[i].Alpha*Deficit);
-
-        //     elemSatn = Deficit-DummyY[i+MD->NumEle]>0?DummyY[i+MD->NumEle]/Deficit:(Deficit==0?1.0:0.0);
-        if((MD->Ele[i].zmax-MD->Ele[i].zmin)-DummyY[i+2*MD->NumEle]-DummyY[i+MD->NumEle]<=0){
-                elemSatn=1.0;
-        }
-        else{
-             elemSatn = 0.5*(1-cos(3.14*(DummyY[i+MD->NumEle]/(MD->Ele[i].zmax-MD->Ele[i].zmin-DummyY[i+2*MD->NumEle]))));    /*  Will have to change this for other formulation */
-        }
-
-        MD->Recharge[i] = elemSatn==0.0?0:Rec_CALIB*(-MD->Ele[i].Ksat*elemSatn*AquiferDepth*(1-(2*log(elemSatn)/(AquiferDepth*MD->Ele[i].Alpha)))/((AquiferDepth-DummyY[i+2*MD->NumEle])+DummyY[i+2*MD->NumEle]*elemSatn));
-
-        if(DummyY[i+MD->NumEle]<=0 && MD->Recharge[i] < 0){
-             MD->Recharge[i] = 0;
-        }
-        if(DummyY[i+2*MD->NumEle]<=0 && MD->Recharge[i] > 0){
-             MD->Recharge[i] = 0;
-        }
+        AquiferDepth = MD->EleP.AqDepth[i];
+        ye[0] = DummyY[i];
+        ye[1] = DummyY[i+MD->NumEle];
+        ye[2] = DummyY[i+2*MD->NumEle];
+        MD->Recharge[i] = EleRecharge(MD, i, ye);
 
         DummyDY[i+MD->NumEle] = DummyDY[i+MD->NumEle] + MD->Recharge[i];
-        DummyDY[i+MD->NumEle] = DummyDY[i+MD->NumEle]/MD->Ele[i].Porosity;
+        DummyDY[i+MD->NumEle] = DummyDY[i+MD->NumEle]/MD->EleP.Porosity[i];
 
         /* Source check */
         /*      if(DummyY[i+MD->NumEle]>=Deficit-EPSILON && DummyDY[i+MD->NumEle]>0)
@@ -1001,7 +742,7 @@ int f(realtype t, N_Vector CV_Y, N_Vector CV_Ydot, void *DS)
         }
         */
         DummyDY[i+2*MD->NumEle] = DummyDY[i+2*MD->NumEle]-MD->Recharge[i];
-        DummyDY[i+2*MD->NumEle] = DummyDY[i+2*MD->NumEle]/MD->Ele[i].Porosity;
+        DummyDY[i+2*MD->NumEle] = DummyDY[i+2*MD->NumEle]/MD->EleP.Porosity[i];
 
         if(DummyY[i+2*MD->NumEle]>=AquiferDepth && DummyDY[i+2*MD->NumEle]>0){
              DummyDY[i+2*MD->NumEle] = 0;
@@ -1036,11 +777,12 @@ int f(realtype t, N_Vector CV_Y, N_Vector CV_Ydot, void *DS)
         }
         */
     }
+    #pragma omp parallel for
     for(i=0; i<MD->NumRiv; i++){
          DummyDY[i+3*MD->NumEle] = MD->FluxRiv[i][0] - MD->FluxRiv[i][1];
          DummyDY[i+3*MD->NumEle] = DummyDY[i+3*MD->NumEle] - MD->FluxRiv[i][2] - MD->FluxRiv[i][3];
          DummyDY[i+3*MD->NumEle] = DummyDY[i+3*MD->NumEle] - MD->FluxRiv[i][4] - MD->FluxRiv[i][5];
-         DummyDY[i+3*MD->NumEle] = DummyDY[i+3*MD->NumEle]/(MD->Riv[i].Length*CS_AreaOrPerem(MD->Riv_Shape[MD->Riv[i].shape - 1].interpOrd,DummyY[i + 3*MD->NumEle],MD->Riv_Shape[MD->Riv[i].shape - 1].coeff,3)); /* delete derive denominator to be replace by volume */
+         DummyDY[i+3*MD->NumEle] = DummyDY[i+3*MD->NumEle]/(MD->RivP.Length[i]*CS_EqWid(MD->RivP.xs[i],DummyY[i + 3*MD->NumEle])); /* delete derive denominator to be replace by volume */
          if(DummyY[i+3*MD->NumEle]<=0 && DummyDY[i+3*MD->NumEle]<0){
               DummyDY[i+3*MD->NumEle] = 0;
          }
@@ -1066,18 +808,397 @@ int f(realtype t, N_Vector CV_Y, N_Vector CV_Ydot, void *DS)
     */
 
     //printf("Flux: %lf %lf %lf %lf %lf %lf\n", MD->FluxSub[5067-2*MD->NumEle][0], MD->FluxSub[5067-2*MD->NumEle][1], MD->FluxSub[5067-2*MD->NumEle][2], MD->Recharge[5067-2*MD->NumEle],MD->FluxRiv[386][4], MD->FluxRiv[386][5]);
+    #pragma omp parallel for
     for(i=0; i<3*MD->NumEle+MD->NumRiv; i++){
          /* Y[i]=DummyY[i]; */
            DY[i]=DummyDY[i]/(60.0*24.0);
     //printf("%d\t%lf\n", i, DY[i]);
     }
 
-    free(DummyY);
-    free(DummyDY);
     return(0);
 }
 
 
+static inline int EleFaceFlux(Model_Data MD, realtype *DummyY, realtype t, int k, const int surfmode)
+//! Function calculates the subsurface and surface fluxes across interior face k and scatters them to both elements; returns 1 if the surface flux is NaN
+/*! \param MD is pointer to model data structure
+    \param DummyY is the bounded state
+    \param t is the time of simulation
+    \param k is the index of the face
+    \param surfmode is the Surface Overland Mode; a literal constant in every caller
+*/
+{
+    int i, j, inabr, jnabr, nan;
+    realtype Avg_Y_Sub, Dif_Y_Sub, Distance, Avg_Ksat, Grad_Y_Sub;
+    realtype mp_factor, mp_nabr, elemSatn, temp1, temp2;
+    realtype Avg_Y_Surf, Dif_Y_Surf, Grad_Y_Surf, Avg_Sf, Avg_Rough, CrossA;
+
+    i = MD->Face[k].owner;
+    j = MD->Face[k].ownerSlot;
+    inabr = MD->Face[k].nabr;
+    jnabr = MD->Face[k].nabrSlot;
+
+    /* Subsurface Lateral Flux Calculation between Triangular elements Follows */
+    if(MD->EleP.zmin[inabr]>MD->EleP.zmin[i]){
+         if(MD->EleP.zmin[inabr]>MD->EleP.zmin[i]+DummyY[i+2*MD->NumEle]){
+              Avg_Y_Sub=DummyY[inabr + 2*MD->NumEle]/2;
+         }
+         else{
+              Avg_Y_Sub=(DummyY[i+2*MD->NumEle]+MD->EleP.zmin[i]-MD->EleP.zmin[inabr]+DummyY[inabr + 2*MD->NumEle])/2;
+         }
+    }
+    else{
+         if(MD->EleP.zmin[i]>MD->EleP.zmin[inabr]+DummyY[inabr + 2*MD->NumEle]){
+              Avg_Y_Sub=DummyY[i+2*MD->NumEle]/2;
+         }
+         else{
+              Avg_Y_Sub=(DummyY[i+2*MD->NumEle]+DummyY[inabr + 2*MD->NumEle]+MD->EleP.zmin[inabr]-MD->EleP.zmin[i])/2;
+         }
+    }
+    Dif_Y_Sub = (DummyY[i+2*MD->NumEle] + MD->EleP.zmin[i]) - (DummyY[inabr + 2*MD->NumEle] + MD->EleP.zmin[inabr]);
+    Distance = MD->EleEdge[i][j].distance;
+    Avg_Ksat = (MD->EleP.KsatH[i] + MD->EleP.KsatH[inabr])/2.0;
+    Grad_Y_Sub = Dif_Y_Sub/Distance;
+    /* take care of macropore effect: the factor is shared by the face, but only applied on the side(s) with macropores */
+    mp_factor = 1;
+    mp_nabr = 1;
+    if (MD->EleP.Macropore[i] == 1 || MD->EleP.Macropore[inabr] == 1){
+         if(MD->EleEdge[i][j].aqDepth-DummyY[i+2*MD->NumEle]-DummyY[i+MD->NumEle]<=0){
+              elemSatn=1.0;
+         }
+         else{
+              elemSatn = DummyY[i+2*MD->NumEle]/MD->EleEdge[i][j].aqDepth;   /*  Will have to change this for other formulation */
+         }
+         if((elemSatn>=MD->Cal.satThresh)&&(DummyY[i]>MD->Cal.ovlThreshH)){
+              temp1=1.0+MD->Cal.mpSlopeH*(elemSatn-MD->Cal.satThresh);
+              temp1=temp1*MD->Cal.mpArea+1*(1-MD->Cal.mpArea);
+         }
+         else{
+              temp1 = 1.0;
+         }
+
+         if(MD->EleEdge[i][j].nabrAqDepth-DummyY[inabr+2*MD->NumEle]-DummyY[inabr+MD->NumEle]<=0){
+              elemSatn=1.0;
+         }
+         else{
+              elemSatn = DummyY[inabr+2*MD->NumEle]/MD->EleEdge[i][j].nabrAqDepth;   /*  Will have to change this for other formulation */
+         }
+         if((elemSatn>=MD->Cal.satThresh)&&(DummyY[inabr]>MD->Cal.ovlThreshH)){
+              temp2=1.0+MD->Cal.mpSlopeH*(elemSatn-MD->Cal.satThresh);
+              temp2=temp2*MD->Cal.mpArea+1*(1-MD->Cal.mpArea);
+         }
+         else{
+              temp2 = 1.0;
+         }
+
+         if (MD->EleP.Macropore[i] == 1){
+              mp_factor = (temp1 + temp2)/2.0;
+         }
+         if (MD->EleP.Macropore[inabr] == 1){
+              mp_nabr = (temp1 + temp2)/2.0;
+         }
+    }
+
+    /* groundwater flow modeled by Darcy's law */
+    MD->FluxSub[i][j] = mp_factor*Avg_Ksat*Grad_Y_Sub*Avg_Y_Sub*MD->EleEdge[i][j].length;
+    MD->FluxSub[inabr][jnabr] = -mp_nabr*Avg_Ksat*Grad_Y_Sub*Avg_Y_Sub*MD->EleEdge[i][j].length;
+
+    /*     Correction is being done in flux terms which can be > 0 even when there is no source water level present */
+
+    if(DummyY[i + 2*MD->NumEle] <= 0 && MD->FluxSub[i][j] > 0){
+         MD->FluxSub[i][j] = 0;
+    }
+    if(DummyY[inabr + 2*MD->NumEle] <= 0 && MD->FluxSub[i][j] < 0){
+         MD->FluxSub[i][j] = 0;
+    }
+
+    /* Saturation check */
+
+    if((DummyY[i + 2*MD->NumEle] >= MD->EleEdge[i][j].aqDepth) && MD->FluxSub[i][j] < 0){
+         MD->FluxSub[i][j] = 0;
+    }
+    if((DummyY[inabr + 2*MD->NumEle] >= MD->EleEdge[i][j].nabrAqDepth) && MD->FluxSub[i][j] >0){
+         MD->FluxSub[i][j] = 0;
+    }
+    if(MD->FluxSub[i][j] == 0){
+         MD->FluxSub[inabr][jnabr] = 0;
+    }
+
+    /* Surface Lateral Flux Calculation between Triangular elements Follows */
+    if(MD->EleP.zmax[inabr]>MD->EleP.zmax[i]){
+         if(MD->EleP.zmax[inabr]>MD->EleP.zmax[i]+DummyY[i]){
+              Avg_Y_Surf=DummyY[inabr]/2;
+         }
+         else{
+              Avg_Y_Surf=(DummyY[i]+MD->EleP.zmax[i]-MD->EleP.zmax[inabr]+DummyY[inabr])/2;
+         }
+    }
+    else{
+         if(MD->EleP.zmax[i]>MD->EleP.zmax[inabr]+DummyY[inabr]){
+              Avg_Y_Surf=DummyY[i]/2;
+         }
+         else{
+              Avg_Y_Surf=(DummyY[i]+DummyY[inabr]+MD->EleP.zmax[inabr]-MD->EleP.zmax[i])/2;
+         }
+    }
+    Dif_Y_Surf = (DummyY[i] + MD->EleP.zmax[i]) - (DummyY[inabr] + MD->EleP.zmax[inabr]);
+    Grad_Y_Surf = Dif_Y_Surf/Distance;
+    Avg_Sf = (MD->EleP.Sf[i] + MD->EleP.Sf[inabr])/2.0;
+    Avg_Rough = 0.5*(MD->EleP.Rough[i] + MD->EleP.Rough[inabr]);
+    CrossA = Avg_Y_Surf*MD->EleEdge[i][j].length;
+
+    /* surfmode is a constant in each specialized copy of this function: the branch is folded away */
+    MD->FluxSurf[i][j] = surfmode == 1 ? SurfFlowKW(Avg_Y_Surf,Grad_Y_Surf,Avg_Sf,CrossA,Avg_Rough) : SurfFlowDW(Avg_Y_Surf,Grad_Y_Surf,Avg_Sf,CrossA,Avg_Rough);
+
+    /* a NaN is only counted here, inside the parallel face loop; f() reports it after the loop */
+    nan = isnan(MD->FluxSurf[i][j]) ? 1 : 0;
+    /*     Correction is being done in flux terms which can be > 0 even when there is no source water level present */
+
+    if(DummyY[i] <= 0 && MD->FluxSurf[i][j] > 0){
+         MD->FluxSurf[i][j] = 0;
+    }
+    if(DummyY[inabr] <= 0 && MD->FluxSurf[i][j] < 0){
+         MD->FluxSurf[i][j] = 0;
+    }
+    MD->FluxSurf[inabr][jnabr] = -MD->FluxSurf[i][j];
+    return nan;
+}
+
+
+/* One copy of the face loop per Surface Overland Mode: no mode dispatch is left inside the loop */
+#define ELE_FACES(NAME, SURFMODE)                                              \
+int NAME(Model_Data MD, realtype *DummyY, realtype t)                          \
+{                                                                              \
+    int k, nNaN = 0;                                                           \
+                                                                               \
+    _Pragma("omp parallel for reduction(+:nNaN)")                              \
+    for(k=0; k<MD->NumFace; k++){                                              \
+         nNaN += EleFaceFlux(MD, DummyY, t, k, SURFMODE);                      \
+    }                                                                          \
+    return nNaN;                                                               \
+}
+
+ELE_FACES(EleFacesKW, 1)                  /* Kinematic Wave */
+ELE_FACES(EleFacesDW, 2)                  /* Diffusion Wave */
+
+
+void SetModeKernels(Model_Data MD)
+//! Function selects the RHS kernels specialized for the flow modes of the run; called once after read_alloc()
+/*! \param MD is pointer to model data structure
+*/
+{
+    switch(MD->SurfMode){
+         case 1:
+              MD->EleFaces = EleFacesKW;
+              MD->DualEleFaces = DualEleFacesKW;
+              break;
+         case 2:
+              MD->EleFaces = EleFacesDW;
+              MD->DualEleFaces = DualEleFacesDW;
+              break;
+         default:
+              printf("\n  Fatal Error: Surface Overland Mode Type Is Wrong!\n");
+              exit(1);
+    }
+    /* both River Routing Modes use Manning's equation with the hydraulic radius: see ChanFlow() */
+    if(MD->RivMode != 1 && MD->RivMode != 2){
+         printf("\n  Fatal Error: River Routing Mode Type Is Wrong!\n");
+         exit(1);
+    }
+}
+
+
+void EleVertical(Model_Data MD, int i, realtype *y, realtype *dy, realtype *et, realtype *vic)
+//! Function calculates ET, infiltration and the vertical fluxes of an element from its own states
+/*! \param MD is pointer to model data structure
+    \param i is the index of the element
+    \param y is the bounded state of the element: surface, unsaturated and saturated storage
+    \param dy is the rate of change of the three states due to the vertical fluxes (output)
+    \param et is the ET of the element; transpiration [1] and ground evaporation [2] are set
+    \param vic is the infiltration capacity of the element (output)
+*/
+{
+    realtype LAI,r_s,beta_s,Rmax;
+    realtype mp_factor, Vic;
+    realtype AquiferDepth, Deficit, elemSatn;
+
+    dy[0] = 0.0;
+    dy[1] = 0.0;
+    dy[2] = 0.0;
+
+     /**************************************Evaporation from ground*********************************************************/
+     if(MD->EleP.AqDepth[i]-y[2]-y[1]<=0){
+          elemSatn=1.0;
+        }
+     else{
+          //elemSatn = 0.5*(1-cos(3.14*(y[1]/(MD->Ele[i].zmax-MD->Ele[i].zmin-y[2]))));    /*  Will have to change this for other formulation */
+          elemSatn = (y[2]+y[1]>MD->EleP.RzBase[i])? 0.5*(1-cos(3.14*(y[2]/MD->EleP.AqDepth[i]))):0;
+     }
+     /* the forcing dependent Penman-Monteith terms are cached per element by updatePET() */
+     LAI = MD->Forc.LAI[MD->Ele[i].LC-1];
+     et[2] = MD->PET.et2[i];
+
+    if(LAI>0.0){
+         Rmax = 5000.0/(24*3600);        /* Unit day_per_m */
+         beta_s= elemSatn>EPSILON/1000.0?elemSatn:EPSILON/1000.0;
+
+         r_s=(MD->PET.rsNum[i]/(beta_s*LAI*MD->PET.eta4[i]))> Rmax?Rmax:(MD->PET.rsNum[i]/(beta_s*LAI*MD->PET.eta4[i]));
+
+         et[1] = LAI*MD->EleP.et1Frac[i]*(1-pow((MD->EleIS[i]<0?0:MD->EleIS[i])/MD->EleISmax[i],2.0/3))*MD->PET.num[i]/(1000*2441000.0*(MD->PET.Delta[i]+MD->EleP.Gamma[i]*(1+r_s/MD->PET.r_a[i])));
+    }
+    else{
+         et[1] =0.0;
+    }
+
+
+    /**********************************************************************************************************************/
+
+
+    AquiferDepth = MD->EleP.AqDepth[i];
+
+    if(y[2]+y[1] >= AquiferDepth){
+         Deficit = 0;
+         Vic = 0;
+    }
+    else if(y[2]+y[1]>AquiferDepth-MD->EleP.RzD[i]){
+           Deficit = AquiferDepth - y[2];
+           Vic = MD->EleP.KsatInf[i]*(1+(y[0]/MD->EleP.RzD[i]));
+    }
+    else{
+         Deficit = AquiferDepth - y[2];
+         Vic = MD->EleP.KsatInf[i]*(1+(y[0]-log((y[1]+EPSILON/10000.0)/(Deficit-MD->EleP.RzD[i]+EPSILON/10000.0))/MD->EleP.Alpha[i])/(MD->EleP.RzD[i]));/* Interpolation(&MD->TSD_Inc[MD->Soil[(MD->Ele[i].soil-1)].Inf-1], t);*/    /* ## Take care of this using saturation rate instead of */
+    }
+
+    if(y[1] < Deficit){                                     /*  ## redo this condition with only phi and z */
+         if(y[0] > 0){
+         /***************************Addn***************************/
+              if(MD->EleP.AqDepth[i]-y[2]-y[1]<=0){
+                   elemSatn=1.0;
+              }
+              else{
+                   elemSatn = y[2]/MD->EleP.AqDepth[i];   /*  Will have to change this for other formulation */
+              }
+
+              if (MD->EleP.Macropore[i] == 0){
+                   mp_factor = 1.0;
+              }
+              else if (MD->EleP.Macropore[i] == 1){
+                   if((elemSatn>=MD->Cal.satThresh)&&(y[0]>MD->Cal.ovlThreshV)){
+                        mp_factor=1.0+MD->Cal.mpSlopeV*(elemSatn-MD->Cal.satThresh);
+                        mp_factor=mp_factor*MD->Cal.mpArea+1*(1-MD->Cal.mpArea);
+                   }
+                   else{
+                        mp_factor = 1.0;
+                   }
+              }
+
+              /*********************************************************/
+              if(MD->EleP.AqDepth[i]-y[2]-y[1]<=0){
+                   elemSatn=1.0;
+              }
+              else{
+                   elemSatn = (y[2]+y[1]>MD->EleP.RzBase[i])? 0.5*(1-cos(3.14*(y[2]/MD->EleP.AqDepth[i]))):0;
+              }
+
+              dy[0] = MD->EleNetPrep[i] - mp_factor*Vic - et[2];
+              dy[1] = (1.0-MD->Cal.mpArea)*Vic;                    /* ##Clean DY variables to some dummy for defining right hand side */
+              dy[2] = dy[2]+(mp_factor-1*(1-MD->Cal.mpArea))*Vic;
+         }
+         else if((MD->EleNetPrep[i] > Vic+et[2])){
+              dy[0] = MD->EleNetPrep[i] - (Vic+et[2]);
+              dy[1] = Vic;
+         }
+         else if((MD->EleNetPrep[i] < Vic+et[2])){       /* ##Think abt putting <= here */
+
+              if(MD->EleNetPrep[i] < Vic){
+                   dy[0] = 0;
+                     dy[1] = MD->EleNetPrep[i]-elemSatn*et[2];
+            //BHATT
+            et[2]=elemSatn*et[2];
+              }
+              else{
+                     dy[0] = 0;
+                     dy[1] = Vic;
+              }
+         }
+         else{
+              dy[0] = 0;
+              dy[1] = MD->EleNetPrep[i]-elemSatn*et[2];
+        //BHATT
+        et[2]=elemSatn*et[2];
+         }
+    }
+    else{                                    /*  ## redo this condition */
+
+         /* The reason of this happening is not clear, therefore the treatment is not secure
+         Fortranately, this will not happen in most cases. */
+         if(y[0]>0){
+              dy[0] = MD->EleNetPrep[i]-et[2];
+               dy[2] = 0;
+         }
+          else{
+              if(MD->EleNetPrep[i]>0){
+                   if(MD->EleNetPrep[i]>et[2]){
+                        dy[0] =MD->EleNetPrep[i]-et[2];
+                     }
+                      else{
+                           dy[0] = 0;
+                      }
+                      dy[2] = 0;
+              }
+               else{
+                    dy[0] = 0;
+                    dy[2] = 0-elemSatn*et[2];
+                //BHATT
+                et[2]=elemSatn*et[2];
+              }
+         }
+    }
+
+    if(y[2]>=AquiferDepth-MD->EleP.RzD[i]){
+         dy[2]=dy[2] - et[1];
+    }
+    else{
+          dy[1]=dy[1] - et[1];
+    }
+
+    *vic = Vic;
+}
+
+
+realtype EleRecharge(Model_Data MD, int i, realtype *y)
+//! Function calculates the recharge from the unsaturated to the saturated zone of an element
+/*! \param MD is pointer to model data structure
+    \param i is the index of the element
+    \param y is the bounded state of the element: surface, unsaturated and saturated storage
+*/
+{
+    realtype AquiferDepth, elemSatn, Recharge;
+
+    AquiferDepth = MD->EleP.AqDepth[i];
+    //      PH = 1 - exp(-MD->Ele[i].Alpha*Deficit);
+
+    //     elemSatn = Deficit-y[1]>0?y[1]/Deficit:(Deficit==0?1.0:0.0);
+    if(MD->EleP.AqDepth[i]-y[2]-y[1]<=0){
+            elemSatn=1.0;
+    }
+    else{
+         elemSatn = 0.5*(1-cos(3.14*(y[1]/(MD->EleP.AqDepth[i]-y[2]))));    /*  Will have to change this for other formulation */
+    }
+
+    Recharge = elemSatn==0.0?0:(-MD->EleP.KsatRec[i]*elemSatn*AquiferDepth*(1-(2*log(elemSatn)/(AquiferDepth*MD->EleP.Alpha[i])))/((AquiferDepth-y[2])+y[2]*elemSatn));
+
+    if(y[1]<=0 && Recharge < 0){
+         Recharge = 0;
+    }
+    if(y[2]<=0 && Recharge > 0){
+         Recharge = 0;
+    }
+
+    return Recharge;
+}
+
+
 realtype Interpolation(TSD *Data, realtype t)
 //! Function interpolates the data value at time t from a given Time Series
 /*! \param Data is the pointer to a time series data
@@ -1117,166 +1238,166 @@ realtype Interpolation(TSD *Data, realtype t)
 }
 
 
-realtype returnVal(realtype rArea, realtype rPerem, realtype eqWid, realtype ap_Bool)
-//! Function returns Area, Peremeter or Equivalent Width depending on the ap_Bool identifier
-/*! \param rArea is the area
-    \param rPerem is the peremeter
-    \param eqWid is the equivalent width
-    \param ap_Bool is the identifier to return type
+void updateForcing(Model_Data MD, realtype t)
+//! Function interpolates every unique forcing Time Series once at time t and stores the values in MD->Forc
+/*! \param MD is pointer to model data structure
+    \param t is the time of simulation
 */
 {
-    if(ap_Bool==1)
-    {
-        return rArea;
+    int k;
+
+    if(MD->Forc.valid == 1 && MD->Forc.t == t){
+         return;
     }
-    else if(ap_Bool==2)
-    {
-        return rPerem;
+    for(k=0; k<MD->NumPrep; k++){
+         MD->Forc.Prep[k] = Interpolation(&MD->TSD_Prep[k], t);
     }
-    else
-    {
-        return eqWid;
+    for(k=0; k<MD->NumTemp; k++){
+         MD->Forc.Temp[k] = Interpolation(&MD->TSD_Temp[k], t);
+    }
+    for(k=0; k<MD->NumHumidity; k++){
+         MD->Forc.Humidity[k] = Interpolation(&MD->TSD_Humidity[k], t);
+    }
+    for(k=0; k<MD->NumWindVel; k++){
+         MD->Forc.WindVel[k] = Interpolation(&MD->TSD_WindVel[k], t);
+    }
+    for(k=0; k<MD->NumRn; k++){
+         MD->Forc.Rn[k] = Interpolation(&MD->TSD_Rn[k], t);
+    }
+    for(k=0; k<MD->NumP; k++){
+         MD->Forc.Pressure[k] = Interpolation(&MD->TSD_Pressure[k], t);
+    }
+    for(k=0; k<MD->NumLC; k++){
+         MD->Forc.LAI[k] = Interpolation(&MD->TSD_LAI[k], t);
+         MD->Forc.DH[k] = Interpolation(&MD->TSD_DH[k], t);
     }
+    for(k=0; k<MD->NumMeltF; k++){
+         MD->Forc.MeltF[k] = Interpolation(&MD->TSD_MeltF[k], t);
+    }
+    updatePET(MD);
+    MD->Forc.t = t;
+    MD->Forc.valid = 1;
 }
 
-/*    Area or Peremeter of River Segment's cross-section    */
-realtype CS_AreaOrPerem(int rivOrder, realtype rivDepth, realtype rivCoeff, realtype a_pBool)
-//! returns Area or Peremeter of a river segment cross-section
-/*! \param rivOrder is the interpolation order of the river segment
-    \param rivDepth is the depth of water in the river segment
-    \param rivCoeff is the interpolation factor of the river segment
-    \param a_pBool is identifer for either Area or Peremeter
+
+void updatePET(Model_Data MD)
+//! Function calculates the state-independent Penman-Monteith terms of every element from the forcing cache
+/*! Only the soil saturation (r_s) and the interception storage ratio depend on the states; everything else is
+    evaluated here once per forcing update instead of in every RHS, Jacobian-vector and preconditioner call.
+    \param MD is pointer to model data structure
 */
 {
-    realtype rivArea, rivPerem, eq_Wid;
-    switch(rivOrder)
-    {
-        case 1:
-            rivArea = rivDepth*rivCoeff;
-            rivPerem= 2.0*rivDepth+rivCoeff;
-            eq_Wid=rivCoeff;
-            return returnVal(rivArea, rivPerem, eq_Wid, a_pBool);
-        case 2:
-            rivArea = pow(rivDepth,2)/rivCoeff;
-            rivPerem = 2.0*rivDepth*pow(1+pow(rivCoeff,2),0.5)/rivCoeff;
-            eq_Wid=2.0*pow(rivDepth+EPSILON,1/(rivOrder-1))/pow(rivCoeff,1/(rivOrder-1));
-            return returnVal(rivArea, rivPerem, eq_Wid, a_pBool);
-        case 3:
-            rivArea = 4*pow(rivDepth,1.5)/(3*pow(rivCoeff,0.5));
-            rivPerem =(pow(rivDepth*(1+4*rivCoeff*rivDepth)/rivCoeff,0.5))+(log(2*pow(rivCoeff*rivDepth,0.5)+pow(1+4*rivCoeff*rivDepth,0.5))/(2*rivCoeff));
-            eq_Wid=2.0*pow(rivDepth+EPSILON,1/(rivOrder-1))/pow(rivCoeff,1/(rivOrder-1));
-            return returnVal(rivArea, rivPerem, eq_Wid, a_pBool);
-        case 4:
-            rivArea = 3*pow(rivDepth,4.0/3.0)/(2*pow(rivCoeff,1.0/3.0));
-            rivPerem = 2*((pow(rivDepth*(1+9*pow(rivCoeff,2.0/3.0)*rivDepth),0.5)/3)+(log(3*pow(rivCoeff,1.0/3.0)*pow(rivDepth,0.5)+pow(1+9*pow(rivCoeff,2.0/3.0)*rivDepth,0.5))/(9*pow(rivCoeff,1.0/3.0))));
-            eq_Wid=2.0*pow(rivDepth+EPSILON,1/(rivOrder-1))/pow(rivCoeff,1/(rivOrder-1));
-            return returnVal(rivArea, rivPerem, eq_Wid, a_pBool);
-        default:
-            printf("\n Relevant Values entered are wrong");
-            printf("\n Depth: %lf\tCoeff: %lf\tOrder: %d\t");
-            return 0;
+    int i;
+    realtype Rn, T, Vel, RH, VP, LAI, rl, f_r, alpha_r, eta_s, Rmax;
+
+    Rmax = 5000.0/(24*3600);        /* Unit day_per_m */
+    #pragma omp parallel for private(Rn,T,Vel,RH,VP,LAI,rl,f_r,alpha_r,eta_s)
+    for(i=0; i<MD->NumEle; i++){
+         Rn = MD->Forc.Rn[MD->Ele[i].Rn-1];
+         T = MD->Forc.Temp[MD->Ele[i].temp-1];
+         Vel = MD->Forc.WindVel[MD->Ele[i].WindVel-1];
+         RH = MD->Forc.Humidity[MD->Ele[i].humidity-1];
+         VP = MD->Forc.Pressure[MD->Ele[i].pressure-1];
+         LAI = MD->Forc.LAI[MD->Ele[i].LC-1];
+         rl = MD->Forc.DH[MD->Ele[i].LC-1];
+
+         MD->PET.Delta[i] = 2503*pow(10,3)*exp(17.27*T/(T+237.3))/(pow(237.3 + T, 2));
+         MD->PET.r_a[i] = log(MD->EleP.windH[i]/rl)*log(10*MD->EleP.windH[i]/rl)/(Vel*0.16);
+         MD->PET.num[i] = Rn*(1-MD->EleP.Albedo[i])*MD->PET.Delta[i]+(1.2*1003.5*((VP/RH)-VP)/MD->PET.r_a[i]);
+         MD->PET.et2[i] = MD->EleP.et2Frac[i]*MD->PET.num[i]/(1000.0*2441000.0*(MD->PET.Delta[i]+MD->EleP.Gamma[i]));
+
+         if(LAI>0.0){
+              f_r = 1.1*Rn*(1-exp(-LAI))/(MD->EleP.Rs_ref[i]*LAI);
+              alpha_r = (1+f_r)/(1+(MD->EleP.Rmin[i]/Rmax));
+              eta_s = 1- 0.0016*(pow((24.85-T),2));
+              MD->PET.rsNum[i] = MD->EleP.Rmin[i]*alpha_r;
+              MD->PET.eta4[i] = pow(eta_s,4);
+         }
+         else{
+              MD->PET.rsNum[i] = 0.0;
+              MD->PET.eta4[i] = 1.0;
+         }
     }
 }
 
-/*    Function to compute surface-flux between elements    */
-void OverlandFlow(realtype **flux, int loci, int locj, int surfmode, realtype avg_y, realtype grad_y, realtype avg_sf, realtype alfa, realtype beta, realtype crossA, realtype avg_rough, int eletypeBool, realtype avg_perem) /* delete perimeter should be passed */
-//! Computes surface flux across the edge between two elements or two river segments
-/*! \param flux is the pointer to FluxSurf or FluxRiv
-    \param loci is Element/River Segment Number
-    \param locj is the Neighbour Number of the Element / 1 for River outflow
-    \param surfmode is identifier to the Surface Flow mode
-    \param avg_y is the avarage head between the elements
+
+/*    Surface flux between elements: one function per Surface Overland Mode    */
+realtype SurfFlowKW(realtype avg_y, realtype grad_y, realtype avg_sf, realtype crossA, realtype avg_rough)
+//! Computes surface flux across the edge between two elements with the Kinematic Wave approximation (SurfMode 1)
+/*! \param avg_y is the avarage head between the elements
     \param grad_y is the hydraulic gradient between the elements
     \param avg_sf is the avarage friction slope of the elements
-    \param alfa is dummy variable
-    \param beta is dummy variable
     \param crossA is average area of cross-section
     \param avg_rough is avarage manning's roughness coefficient
-    \param eletypeBool is an identifier to element mode 1: Element 0: River
-    \param avg_perem is the avarage wetted perimeter
 */
 {
     int locBool;
-    float hydRadius;
+    realtype alfa, beta;
+
     /* if surface gradient is not enough to overcome the friction */
     if(fabs(grad_y) <= avg_sf)
     {
-         flux[loci][locj] = 0;
+         return 0;
     }
-    else
+    locBool = grad_y > 0 ? 1 : -1;
+    /* Kinematic Wave Approximation constitutive relationship: Manning Equation */
+    alfa = sqrt(locBool*grad_y)/avg_rough;
+    beta = pow(avg_y, 2.0/3.0);
+    return locBool*alfa*beta*crossA;
+}
+
+realtype SurfFlowDW(realtype avg_y, realtype grad_y, realtype avg_sf, realtype crossA, realtype avg_rough)
+//! Computes surface flux across the edge between two elements with the Diffusion Wave approximation (SurfMode 2)
+/*! \param avg_y is the avarage head between the elements
+    \param grad_y is the hydraulic gradient between the elements
+    \param avg_sf is the avarage friction slope of the elements
+    \param crossA is average area of cross-section
+    \param avg_rough is avarage manning's roughness coefficient
+*/
+{
+    int locBool;
+    realtype alfa, beta;
+
+    if(fabs(grad_y) <= avg_sf)
     {
-         if(grad_y > 0)
-         {
-              locBool=1;
-         }
-         else if(grad_y < 0)
-         {
-              locBool=-1;
-         }
-         switch(surfmode)
-         {
-                case 1:
-                  if(eletypeBool==1)
-                  {
-                       /* Kinematic Wave Approximation constitutive relationship: Manning Equation */
-                       alfa = sqrt(locBool*grad_y)/avg_rough;
-                       beta = pow(avg_y, 2.0/3.0);
-                       flux[loci][locj] = locBool*alfa*beta*crossA;
-                       break;
-                  }
-                  else
-                  {
-                       /*alfa = sqrt(locBool*grad_y)/(avg_rough*pow((avg_perem>0?avg_perem:0), 2.0/3.0));
-                       beta = 5.0/3.0;
-                       flux[loci][1] = locBool*alfa*pow(crossA, beta);
-                       */
-                       hydRadius = (avg_perem>0?crossA/avg_perem:0);
-                       flux[loci][1] = locBool*sqrt(locBool*grad_y)*crossA*pow(hydRadius,2.0/3.0)/avg_rough;
-                       break;
-                  }
-                case 2:
-                  if(eletypeBool==1)
-                  {
-                       /* Diffusion Wave Approximation constitutive relationship: Gottardi & Venutelli, 1993 */
-                       alfa = pow(pow(avg_y, 1.0/3.0),2)/(1.0*avg_rough);
-                       beta = alfa;
-                       flux[loci][locj] = locBool*crossA*beta*sqrt(locBool*grad_y);
-                       break;
-                  }
-                  else
-                  {
-                       /*alfa = pow(pow(avg_y, 1.0/3.0),2)/(1.0*avg_rough);
-                       beta = alfa;
-                       flux[loci][1] = locBool*crossA*beta*sqrt(locBool*grad_y);
-                       */
-                       hydRadius = (avg_perem>0?crossA/avg_perem:0);
-                       flux[loci][1] = locBool*sqrt(locBool*grad_y)*crossA*pow(hydRadius,2.0/3.0)/(1.0*avg_rough);
-                       break;
-                  }
-                default:
-                  if(eletypeBool==1)
-                  {
-                          printf("Fatal Error: Surface Overland Mode Type Is Wrong!");
-                  }
-                  else
-                  {
-                       printf("Fatal Error: River Routing Mode Type Is Wrong!");
-                  }
-                  exit(1);
-        }
+         return 0;
+    }
+    locBool = grad_y > 0 ? 1 : -1;
+    /* Diffusion Wave Approximation constitutive relationship: Gottardi & Venutelli, 1993 */
+    alfa = pow(pow(avg_y, 1.0/3.0),2)/(1.0*avg_rough);
+    beta = alfa;
+    return locBool*crossA*beta*sqrt(locBool*grad_y);
+}
+
+/*    Flux between river segments: the same for both River Routing Modes    */
+realtype ChanFlow(realtype grad_y, realtype avg_sf, realtype crossA, realtype avg_rough, realtype avg_perem)
+//! Computes flux between two river segments with Manning's equation and the hydraulic radius
+/*! \param grad_y is the hydraulic gradient between the segments
+    \param avg_sf is the avarage friction slope of the segments
+    \param crossA is average area of cross-section
+    \param avg_rough is avarage manning's roughness coefficient
+    \param avg_perem is the avarage wetted perimeter
+*/
+{
+    int locBool;
+    float hydRadius;
+
+    if(fabs(grad_y) <= avg_sf)
+    {
+         return 0;
     }
+    locBool = grad_y > 0 ? 1 : -1;
+    hydRadius = (avg_perem>0?crossA/avg_perem:0);
+    return locBool*sqrt(locBool*grad_y)*crossA*pow(hydRadius,2.0/3.0)/avg_rough;
 }
 
 
 /*    Surface Interaction between Element and River Segment    */
-void OLflowFromEleToRiv(realtype sideEle_y,realtype sideEle_zmax,realtype rivX,realtype sideEleX,realtype rivY,realtype sideEleY,realtype cwr,realtype rivZmax,realtype loc_yriver,realtype **fluxriv,int loc_i,int loc_j,realtype length)
+void OLflowFromEleToRiv(realtype sideEle_y,realtype sideEle_zmax,realtype dist,realtype cwr,realtype rivZmax,realtype loc_yriver,realtype **fluxriv,int loc_i,int loc_j,realtype length)
 //! Computes surface flux interaction between an element and a river segment
 /*! \param sideEle_y is the surface water head at the side element
     \param sideEle_zmax is surface elevation of the side element
-    \param rivX is x co-ordinate of the river segment
-    \param sideEleX is y co-ordinate of the side element
-    \param rivY is the y co-ordinate of the river segment
-    \param sideEleY is the y co-ordinate of the side element
+    \param dist is the distance between the river segment and the side element centroid
     \param cwr is the coefficient of discharge
     \param rivZmax is the full bank elevation of the river segment
     \param loc_yriver is the river water head in the river
@@ -1287,10 +1408,9 @@ void OLflowFromEleToRiv(realtype sideEle_y,realtype sideEle_zmax,realtype rivX,r
 
 */
 {
-      realtype loc_cwr,dist,ele_YH,ele_Y,loc_bele;
+      realtype loc_cwr,ele_YH,ele_Y,loc_bele;
       ele_Y = sideEle_y;
       ele_YH = sideEle_y + sideEle_zmax;
-      dist = sqrt(pow(rivX - sideEleX, 2) + pow(rivY - sideEleY, 2));
       loc_cwr = cwr;
       if (rivZmax < sideEle_zmax)
       {
@@ -1345,15 +1465,12 @@ void OLflowFromEleToRiv(realtype sideEle_y,realtype sideEle_zmax,realtype rivX,r
 }
 
 /*    SubSurface Interaction between Element and River Segment    */
-void GWflowFromEleToRiv(realtype sideEle_y,realtype sideEle_zmax, realtype sideEle_zmin,realtype rivX,realtype sideEleX,realtype rivY,realtype sideEleY,int loc_McPore,realtype loc_yriver,realtype loc_totyriver,realtype **fluxriv,int loc_i,int loc_j,realtype length, realtype loc_base,realtype loc_gama, realtype loc_perem,realtype loc_ksat,realtype ele_Thresh) /* delete 0.5 perimeter */
+void GWflowFromEleToRiv(realtype sideEle_y,realtype sideEle_zmax, realtype sideEle_zmin,realtype dist,int loc_McPore,realtype loc_yriver,realtype loc_totyriver,realtype **fluxriv,int loc_i,int loc_j,realtype length, realtype loc_base,realtype loc_gama, realtype loc_perem,realtype loc_ksat,realtype ele_Thresh,realtype rivK) /* delete 0.5 perimeter */
 //! Computes subsurface flux interaction between an element and a river segment
 /*! \param sideEle_y is the surface water head at the side element
     \param sideEle_zmax is surface elevation of the side element
     \param sideEle_zmin is bed elevation of the side element
-    \param rivX is x co-ordinate of the river segment
-    \param sideEleX is y co-ordinate of the side element
-    \param rivY is the y co-ordinate of the river segment
-    \param sideEleY is the y co-ordinate of the side element
+    \param dist is the distance between the river segment and the side element centroid
     \param loc_McPore is the identifier for Macropore
     \param loc_yriver is the river water head
     \param loc_totyriver is the river water elevation
@@ -1366,18 +1483,18 @@ void GWflowFromEleToRiv(realtype sideEle_y,realtype sideEle_zmax, realtype sideE
     \param loc_perem is the wetted perimeter
     \param loc_ksat is the saturated hydraulic conductivity
     \param ele_Thresh is the
+    \param rivK is the calibration factor of conductivity at the river-element interface
 */
 {
-     realtype loc_mpfactor,dist,ele_YH,ele_Y;
+     realtype loc_mpfactor,ele_YH,ele_Y;
 
     realtype loc_sat, loc_rivK_CALIB, mp_Rzd=0.8;
     mp_Rzd = ((sideEle_zmax - sideEle_zmin - mp_Rzd) < 0)?(sideEle_zmax-sideEle_zmin):mp_Rzd;
     loc_sat = (sideEle_y-(sideEle_zmax-sideEle_zmin-mp_Rzd))/mp_Rzd;
-    loc_rivK_CALIB = loc_sat>=0?(1.0+loc_sat*rivK_CALIB):1.0;
+    loc_rivK_CALIB = loc_sat>=0?(1.0+loc_sat*rivK):1.0;
 
      ele_Y = sideEle_y;
      ele_YH = sideEle_y + sideEle_zmin;
-     dist = sqrt(pow(rivX - sideEleX, 2) + pow(rivY - sideEleY, 2));
 
 
      if (loc_McPore == 0){
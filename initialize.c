@@ -43,6 +43,27 @@ realtype rivEle_CALIB;
 
 int lbool;    /**< Optional: To find Sinks    */
 
+void ForcingBreakpoints(Model_Data DS, Control_Data *CS);
+void XSInit(Model_Data DS);
+
+/*******************************************************************************
+*    Aligned Allocation of the arrays used in the hot loops
+********************************************************************************/
+void *alignedMalloc(size_t size)
+//! Allocates size bytes aligned to PIHM_ALIGN; the memory is released with free()
+/*! \param size is the number of bytes to be allocated
+*/
+{
+    void *ptr;
+
+    if(posix_memalign(&ptr, PIHM_ALIGN, size > 0 ? size : PIHM_ALIGN) != 0)
+    {
+        printf("\n  Fatal Error: out of memory in aligned allocation of %lu bytes!\n", (unsigned long)size);
+        exit(1);
+    }
+    return ptr;
+}
+
 /*******************************************************************************
 *    Initialize Model & Control Data
 ********************************************************************************/
@@ -54,10 +75,10 @@ void initialize(char *filename, Model_Data DS, Control_Data *CS, N_Vector CV_Y)
     \param CV_Y	is state variable vector
 */
 {
-      int i,j,counterMin, counterMax, MINCONST, domcounter;
+      int i,j,k,l,pad,*count,*slotUsed,counterMin, counterMax, MINCONST, domcounter;
       realtype a_x, a_y, b_x, b_y, c_x, c_y, MAXCONST;
       realtype a_zmin, a_zmax, b_zmin, b_zmax, c_zmin, c_zmax;
-      realtype tempvalue;
+      realtype tempvalue, P;
       FILE *int_file;
       char *fn;
 
@@ -114,6 +135,7 @@ void initialize(char *filename, Model_Data DS, Control_Data *CS, N_Vector CV_Y)
         //printf("\n%lf",DS->Ele[i].area);
         DS->Ele[i].zmax = (a_zmax + b_zmax + c_zmax)/3.0;                             /*    Mean Surface Elevation of an element    */
         DS->Ele[i].zmin = (a_zmin + b_zmin + c_zmin)/3.0;                             /*    Mean Bed Elevation of an element        */
+        DS->Ele[i].AqDepth = DS->Ele[i].zmax - DS->Ele[i].zmin;                       /*    Aquifer Depth of an element             */
 
          //DS->Ele[i].zmin =DS->Ele[i].zmax-br_CALIB;
 
@@ -188,6 +210,11 @@ void initialize(char *filename, Model_Data DS, Control_Data *CS, N_Vector CV_Y)
       DS->Ele2IS = (realtype *)malloc(DS->NumEle*sizeof(realtype));          /* Memory allocation for Interception Storage Rate       */
       DS->EleNetPrep = (realtype *)malloc(DS->NumEle*sizeof(realtype));      /* Memory allocation for Net Precipitation to Element    */
 
+      DS->DummyY = (realtype *)alignedMalloc((3*DS->NumEle+DS->NumRiv)*sizeof(realtype));   /* RHS workspace: bounded states      */
+      DS->DummyDY = (realtype *)alignedMalloc((3*DS->NumEle+DS->NumRiv)*sizeof(realtype));  /* RHS workspace: rate of change      */
+      DS->EleISSave = (realtype *)malloc(DS->NumEle*sizeof(realtype));       /* One-step driver: IS at the start of a step            */
+      DS->EleSnowSave = (realtype *)malloc(DS->NumEle*sizeof(realtype));     /* One-step driver: snow at the start of a step          */
+
       for(i=0; i<DS->NumEle; i++)
       {
         DS->Ele[i].Ksat = DS->Soil[(DS->Ele[i].soil-1)].Ksat;                /* Saturation Hydraulic Conductivity of an Element       */
@@ -223,6 +250,262 @@ void initialize(char *filename, Model_Data DS, Control_Data *CS, N_Vector CV_Y)
                              pow(DS->Node[DS->Riv[i].FromNode-1].y -
                                  DS->Node[DS->Riv[i].ToNode-1].y, 2));       /* Length of a River Segment                             */
       }
+
+      /*    Static edge geometry of elements: f() reads these instead of recomputing them at every call    */
+      DS->EleEdge = (edge_geom **)malloc(DS->NumEle*sizeof(edge_geom *));
+      DS->EleEdge[0] = (edge_geom *)malloc(3*DS->NumEle*sizeof(edge_geom));
+
+      for(i=0; i<DS->NumEle; i++)
+      {
+        DS->EleEdge[i] = DS->EleEdge[0] + 3*i;
+        for(j=0; j<3; j++)
+        {
+            DS->EleEdge[i][j].nabr = DS->Ele[i].nabr[j] - 1;                          /* 0-based neighbor, -1 on boundary      */
+            DS->EleEdge[i][j].length = DS->Ele[i].edge[j];
+            DS->EleEdge[i][j].aqDepth = DS->Ele[i].AqDepth;
+            DS->EleEdge[i][j].bddDist = sqrt(pow(DS->Ele[i].edge[0]*DS->Ele[i].edge[1]*DS->Ele[i].edge[2]/(4*DS->Ele[i].area), 2) - pow(DS->Ele[i].edge[j]/2, 2));
+                                                                                      /* Circumcenter to edge distance         */
+            if(DS->Ele[i].nabr[j] > 0)
+            {
+                DS->EleEdge[i][j].distance = sqrt(pow((DS->Ele[i].x - DS->Ele[DS->Ele[i].nabr[j] - 1].x), 2) + pow((DS->Ele[i].y - DS->Ele[DS->Ele[i].nabr[j] - 1].y), 2));
+                DS->EleEdge[i][j].nabrAqDepth = DS->Ele[DS->Ele[i].nabr[j] - 1].AqDepth;
+            }
+            else
+            {
+                DS->EleEdge[i][j].nabr = -1;
+                DS->EleEdge[i][j].distance = DS->EleEdge[i][j].bddDist;
+                DS->EleEdge[i][j].nabrAqDepth = 0.0;
+            }
+        }
+      }
+
+      /*    Interior edge list: every edge shared by two elements is listed once, owned by the lower index    */
+      DS->NumFace = 0;
+      for(i=0; i<DS->NumEle; i++)
+      {
+        for(j=0; j<3; j++)
+        {
+            if(DS->EleEdge[i][j].nabr > i)
+            {
+                DS->NumFace++;
+            }
+        }
+      }
+      DS->Face = (face *)malloc(DS->NumFace*sizeof(face));
+
+      DS->NumFace = 0;
+      for(i=0; i<DS->NumEle; i++)
+      {
+        for(j=0; j<3; j++)
+        {
+            if(DS->EleEdge[i][j].nabr < 0)
+            {
+                continue;
+            }
+            /* slot of this edge as seen from the neighbor */
+            l = -1;
+            for(k=0; k<3; k++)
+            {
+                if(DS->EleEdge[DS->EleEdge[i][j].nabr][k].nabr == i && l < 0)
+                {
+                    l = k;
+                }
+            }
+            if(l < 0 || DS->EleEdge[i][j].nabr == i)
+            {
+                printf("\n  Fatal Error: inconsistent neighbor %d of element %d in .mesh file!\n", DS->Ele[i].nabr[j], DS->Ele[i].index);
+                exit(1);
+            }
+            if(DS->EleEdge[i][j].nabr > i)
+            {
+                DS->Face[DS->NumFace].owner = i;
+                DS->Face[DS->NumFace].ownerSlot = j;
+                DS->Face[DS->NumFace].nabr = DS->EleEdge[i][j].nabr;
+                DS->Face[DS->NumFace].nabrSlot = l;
+                DS->NumFace++;
+            }
+        }
+      }
+
+      /*    Static geometry of river segments w.r.t. their left and right elements    */
+      DS->RivGeom = (riv_geom *)malloc(DS->NumRiv*sizeof(riv_geom));
+      slotUsed = (int *)malloc(3*DS->NumEle*sizeof(int));
+      for(i=0; i<3*DS->NumEle; i++)
+      {
+        slotUsed[i] = 0;
+      }
+
+      for(i=0; i<DS->NumRiv; i++)
+      {
+        DS->RivGeom[i].left = DS->Riv[i].LeftEle > 0 ? DS->Riv[i].LeftEle - 1 : -1;
+        DS->RivGeom[i].right = DS->Riv[i].RightEle > 0 ? DS->Riv[i].RightEle - 1 : -1;
+        DS->RivGeom[i].leftSlot = -1;
+        DS->RivGeom[i].rightSlot = -1;
+        DS->RivGeom[i].leftDist = 0.0;
+        DS->RivGeom[i].rightDist = 0.0;
+
+        if(DS->RivGeom[i].left >= 0)
+        {
+            DS->RivGeom[i].leftDist = sqrt(pow(DS->Riv[i].x - DS->Ele[DS->RivGeom[i].left].x, 2) + pow(DS->Riv[i].y - DS->Ele[DS->RivGeom[i].left].y, 2));
+        }
+        if(DS->RivGeom[i].right >= 0)
+        {
+            DS->RivGeom[i].rightDist = sqrt(pow(DS->Riv[i].x - DS->Ele[DS->RivGeom[i].right].x, 2) + pow(DS->Riv[i].y - DS->Ele[DS->RivGeom[i].right].y, 2));
+        }
+        /* Edge of each bank facing the other bank (the boundary edge, nabr 0, of a single bank): its element-element */
+        /* or boundary flux is replaced by the river exchange. An edge is taken by one segment only; a bank left */
+        /* without one (slot -1) takes the overland exchange on its surface directly in f() */
+        for(j=0; j<3; j++)
+        {
+            if(DS->RivGeom[i].left >= 0 && DS->Ele[DS->RivGeom[i].left].nabr[j] == DS->Riv[i].RightEle
+               && DS->RivGeom[i].leftSlot < 0 && slotUsed[3*DS->RivGeom[i].left+j] == 0)
+            {
+                DS->RivGeom[i].leftSlot = j;
+                slotUsed[3*DS->RivGeom[i].left+j] = 1;
+            }
+            if(DS->RivGeom[i].right >= 0 && DS->Ele[DS->RivGeom[i].right].nabr[j] == DS->Riv[i].LeftEle
+               && DS->RivGeom[i].rightSlot < 0 && slotUsed[3*DS->RivGeom[i].right+j] == 0)
+            {
+                DS->RivGeom[i].rightSlot = j;
+                slotUsed[3*DS->RivGeom[i].right+j] = 1;
+            }
+        }
+      }
+      free(slotUsed);
+
+      /*    River network: upstream segments of each segment in CSR form, so that inflow is gathered    */
+      DS->RivUpPtr = (int *)malloc((DS->NumRiv+1)*sizeof(int));
+      DS->RivUp = (int *)malloc((DS->NumRiv > 0 ? DS->NumRiv : 1)*sizeof(int));
+      count = (int *)malloc((DS->NumRiv+DS->NumEle+1)*sizeof(int));
+      DS->RivOutlet = -1;
+
+      for(i=0; i<=DS->NumRiv; i++)
+      {
+        DS->RivUpPtr[i] = 0;
+      }
+      for(i=0; i<DS->NumRiv; i++)
+      {
+        if(DS->Riv[i].down > DS->NumRiv || DS->Riv[i].down == i+1)
+        {
+            printf("\n  Fatal Error: invalid downstream segment %d of river segment %d in .riv file!\n", DS->Riv[i].down, DS->Riv[i].index);
+            exit(1);
+        }
+        if(DS->Riv[i].down > 0)
+        {
+            DS->RivUpPtr[DS->Riv[i].down]++;
+        }
+        else
+        {
+            DS->RivOutlet = i;      /* the last outlet in the file is reported as Q */
+        }
+      }
+      for(i=0; i<DS->NumRiv; i++)
+      {
+        DS->RivUpPtr[i+1] = DS->RivUpPtr[i+1] + DS->RivUpPtr[i];
+        count[i] = DS->RivUpPtr[i];
+      }
+      /* ascending segment order within each list keeps the inflow sum independent of the threads */
+      for(i=0; i<DS->NumRiv; i++)
+      {
+        if(DS->Riv[i].down > 0)
+        {
+            DS->RivUp[count[DS->Riv[i].down-1]++] = i;
+        }
+      }
+
+      /* topological sort (from headwaters down): every segment must drain to an outlet */
+      for(i=0; i<DS->NumRiv; i++)
+      {
+        count[i] = DS->RivUpPtr[i+1] - DS->RivUpPtr[i];
+      }
+      l = 0;
+      for(i=0; i<DS->NumRiv; i++)
+      {
+        k = i;
+        while(k >= 0 && count[k] == 0)
+        {
+            count[k] = -1;          /* sorted */
+            l++;
+            k = DS->Riv[k].down - 1;
+            if(k >= 0)
+            {
+                count[k]--;
+            }
+        }
+      }
+      if(l < DS->NumRiv)
+      {
+        printf("\n  Fatal Error: river network in .riv file contains a loop!\n");
+        exit(1);
+      }
+
+      /*    Preconditioner storage; segments of equal RivColor never drain into each other    */
+      DS->Prec.EleJac = (realtype *)alignedMalloc(9*DS->NumEle*sizeof(realtype));
+      DS->Prec.EleLU = (realtype *)alignedMalloc(9*DS->NumEle*sizeof(realtype));
+      DS->Prec.ElePiv = (int *)malloc((3*DS->NumEle > 0 ? 3*DS->NumEle : 1)*sizeof(int));
+      DS->Prec.RivJac = (realtype *)alignedMalloc(DS->NumRiv*sizeof(realtype));
+      DS->Prec.RivDiag = (realtype *)alignedMalloc(DS->NumRiv*sizeof(realtype));
+      DS->Prec.RivColor = (int *)malloc((DS->NumRiv > 0 ? DS->NumRiv : 1)*sizeof(int));
+      DS->Prec.ISJac = (realtype *)alignedMalloc(2*DS->NumEle*sizeof(realtype));
+      DS->Prec.ISDiag = (realtype *)alignedMalloc(2*DS->NumEle*sizeof(realtype));
+
+      for(i=0; i<DS->NumRiv; i++)
+      {
+        DS->Prec.RivColor[i] = -1;
+      }
+      for(i=0; i<DS->NumRiv; i++)
+      {
+        /* walk down to the first colored segment (or past the outlet), then color the path */
+        l = 0;
+        for(k=i; k>=0 && DS->Prec.RivColor[k]<0; k=DS->Riv[k].down-1)
+        {
+            l++;
+        }
+        j = k >= 0 ? DS->Prec.RivColor[k] : 1;
+        for(k=i; k>=0 && DS->Prec.RivColor[k]<0; k=DS->Riv[k].down-1)
+        {
+            DS->Prec.RivColor[k] = (j + l) % 2;
+            l--;
+        }
+      }
+
+      /*    Bank elements: river segments each element exchanges water with, as 2*segment+side (0: left, 1: right)    */
+      DS->EleRivPtr = (int *)malloc((DS->NumEle+1)*sizeof(int));
+      DS->EleRiv = (int *)malloc((2*DS->NumRiv > 0 ? 2*DS->NumRiv : 1)*sizeof(int));
+
+      for(i=0; i<=DS->NumEle; i++)
+      {
+        DS->EleRivPtr[i] = 0;
+      }
+      for(i=0; i<DS->NumRiv; i++)
+      {
+        if(DS->RivGeom[i].left >= 0)
+        {
+            DS->EleRivPtr[DS->RivGeom[i].left+1]++;
+        }
+        if(DS->RivGeom[i].right >= 0)
+        {
+            DS->EleRivPtr[DS->RivGeom[i].right+1]++;
+        }
+      }
+      for(i=0; i<DS->NumEle; i++)
+      {
+        DS->EleRivPtr[i+1] = DS->EleRivPtr[i+1] + DS->EleRivPtr[i];
+        count[i] = DS->EleRivPtr[i];
+      }
+      for(i=0; i<DS->NumRiv; i++)
+      {
+        if(DS->RivGeom[i].left >= 0)
+        {
+            DS->EleRiv[count[DS->RivGeom[i].left]++] = 2*i;
+        }
+        if(DS->RivGeom[i].right >= 0)
+        {
+            DS->EleRiv[count[DS->RivGeom[i].right]++] = 2*i+1;
+        }
+      }
+      free(count);
+
       /************************************************/
     /* Optional : Routine to see River Bed Slope    */
       /************************************************/
@@ -246,6 +529,7 @@ void initialize(char *filename, Model_Data DS, Control_Data *CS, N_Vector CV_Y)
         for(i=0; i<DS->NumEle; i++)
         {
               DS->EleIS[i] = 0;                             /* Initialize Interception Storage         */
+              DS->EleSnow[i] = 0;                           /* Initialize Snow Storage                 */
               NV_Ith_S(CV_Y, i) = 0;                        /* Initialize Surface State                */
               NV_Ith_S(CV_Y, i + DS->NumEle) = (1/DS->Ele[i].Alpha)*(1-exp(-DS->Ele[i].Alpha*(0.1+0.05)));
                                                             /* Initialize Unsaturated Zone State       */
@@ -428,6 +712,316 @@ void initialize(char *filename, Model_Data DS, Control_Data *CS, N_Vector CV_Y)
         }
     }
 
+    /*    Interception and snow storage follow the river states in the state vector (ISMode 1)    */
+    if(DS->ISMode == 1)
+    {
+        for(i=0; i<DS->NumEle; i++)
+        {
+            NV_Ith_S(CV_Y, i + 3*DS->NumEle + DS->NumRiv) = DS->EleIS[i];
+            NV_Ith_S(CV_Y, i + 4*DS->NumEle + DS->NumRiv) = DS->EleSnow[i];
+        }
+    }
+
+    /*    Calibration parameters of the time stepping routines: read once from calib.c    */
+    DS->Cal.Vic        = setVic_CALIB();
+    DS->Cal.rivK       = setrivK_CALIB();
+    DS->Cal.Kh         = setKh_CALIB();
+    DS->Cal.Rec        = setRec_CALIB();
+    DS->Cal.et2        = setet2_CALIB();
+    DS->Cal.et1        = setet1_CALIB();
+    DS->Cal.satThresh  = setsat_THRESH();
+    DS->Cal.mpMultFH   = setmp_MULTFH();
+    DS->Cal.mpMultFV   = setmp_MULTFV();
+    DS->Cal.mpArea     = setmpArea_CALIB();
+    DS->Cal.ovlThreshH = setovl_THRESH_H();
+    DS->Cal.ovlThreshV = setovl_THRESH_V();
+    DS->Cal.rzd        = setrzd_CALIB();
+    DS->Cal.is         = setis_CALIB();
+    DS->Cal.et0        = setet0_CALIB();
+    DS->Cal.mf         = setmf_CALIB();
+    DS->Cal.tf         = settf_CALIB();
+    DS->Cal.mpSlopeH   = DS->Cal.mpMultFH/(1-DS->Cal.satThresh);
+    DS->Cal.mpSlopeV   = DS->Cal.mpMultFV/(1-DS->Cal.satThresh);
+    DS->Cal.tfCoeff    = DS->Cal.tf*5.65*pow(10,-2);
+
+    /*    Structure-of-Arrays views of the element and river parameters read by f() and calET_IS()    */
+    /*    Every array starts on a PIHM_ALIGN boundary: the length is padded to a whole number of lines   */
+    pad = (DS->NumEle + PIHM_ALIGN/sizeof(realtype) - 1)/(PIHM_ALIGN/sizeof(realtype))*(PIHM_ALIGN/sizeof(realtype));
+    DS->EleP.block = (realtype *)alignedMalloc(27*pad*sizeof(realtype));
+    DS->EleP.zmin     = DS->EleP.block;
+    DS->EleP.zmax     = DS->EleP.block + pad;
+    DS->EleP.AqDepth  = DS->EleP.block + 2*pad;
+    DS->EleP.area     = DS->EleP.block + 3*pad;
+    DS->EleP.Ksat     = DS->EleP.block + 4*pad;
+    DS->EleP.Porosity = DS->EleP.block + 5*pad;
+    DS->EleP.Alpha    = DS->EleP.block + 6*pad;
+    DS->EleP.Beta     = DS->EleP.block + 7*pad;
+    DS->EleP.Sf       = DS->EleP.block + 8*pad;
+    DS->EleP.RzD      = DS->EleP.block + 9*pad;
+    DS->EleP.Rough    = DS->EleP.block + 10*pad;
+    DS->EleP.LAImax   = DS->EleP.block + 11*pad;
+    DS->EleP.VegFrac  = DS->EleP.block + 12*pad;
+    DS->EleP.Albedo   = DS->EleP.block + 13*pad;
+    DS->EleP.Rs_ref   = DS->EleP.block + 14*pad;
+    DS->EleP.Rmin     = DS->EleP.block + 15*pad;
+    DS->EleP.windH    = DS->EleP.block + 16*pad;
+    DS->EleP.base     = DS->EleP.block + 17*pad;
+    DS->EleP.KsatH    = DS->EleP.block + 18*pad;
+    DS->EleP.KsatInf  = DS->EleP.block + 19*pad;
+    DS->EleP.KsatRec  = DS->EleP.block + 20*pad;
+    DS->EleP.RzBase   = DS->EleP.block + 21*pad;
+    DS->EleP.et0Frac  = DS->EleP.block + 22*pad;
+    DS->EleP.et1Frac  = DS->EleP.block + 23*pad;
+    DS->EleP.et2Frac  = DS->EleP.block + 24*pad;
+    DS->EleP.ISFactor = DS->EleP.block + 25*pad;
+    DS->EleP.Gamma    = DS->EleP.block + 26*pad;
+    DS->EleP.Macropore = (int *)alignedMalloc(pad*sizeof(int));
+
+    for(i=0; i<DS->NumEle; i++)
+    {
+        DS->EleP.zmin[i]     = DS->Ele[i].zmin;
+        DS->EleP.zmax[i]     = DS->Ele[i].zmax;
+        DS->EleP.AqDepth[i]  = DS->Ele[i].AqDepth;
+        DS->EleP.area[i]     = DS->Ele[i].area;
+        DS->EleP.Ksat[i]     = DS->Ele[i].Ksat;
+        DS->EleP.Porosity[i] = DS->Ele[i].Porosity;
+        DS->EleP.Alpha[i]    = DS->Ele[i].Alpha;
+        DS->EleP.Beta[i]     = DS->Ele[i].Beta;
+        DS->EleP.Sf[i]       = DS->Ele[i].Sf;
+        DS->EleP.RzD[i]      = DS->Ele[i].RzD;
+        DS->EleP.Rough[i]    = DS->Ele[i].Rough;
+        DS->EleP.LAImax[i]   = DS->Ele[i].LAImax;
+        DS->EleP.VegFrac[i]  = DS->Ele[i].VegFrac;
+        DS->EleP.Albedo[i]   = DS->Ele[i].Albedo;
+        DS->EleP.Rs_ref[i]   = DS->Ele[i].Rs_ref;
+        DS->EleP.Rmin[i]     = DS->Ele[i].Rmin;
+        DS->EleP.windH[i]    = DS->Ele[i].windH;
+        DS->EleP.base[i]     = DS->Soil[(DS->Ele[i].soil-1)].base;
+        DS->EleP.Macropore[i] = DS->Soil[(DS->Ele[i].soil-1)].Macropore;
+
+        /* calibration factors are applied once here, not in every RHS call */
+        DS->EleP.KsatH[i]    = DS->Cal.Kh*DS->Ele[i].Ksat;
+        DS->EleP.KsatInf[i]  = DS->Ele[i].Ksat/DS->Cal.Vic;
+        DS->EleP.KsatRec[i]  = DS->Cal.Rec*DS->Ele[i].Ksat;
+        DS->EleP.RzBase[i]   = DS->Ele[i].AqDepth-DS->Ele[i].RzD-DS->Cal.rzd;
+        DS->EleP.et0Frac[i]  = DS->Cal.et0/DS->Ele[i].LAImax;
+        DS->EleP.et1Frac[i]  = DS->Cal.et1*DS->Ele[i].VegFrac/DS->Ele[i].LAImax;
+        DS->EleP.et2Frac[i]  = DS->Cal.et2*(1-DS->Ele[i].VegFrac);
+        DS->EleP.ISFactor[i] = DS->Cal.is*DS->SIFactor[DS->Ele[i].LC-1];
+
+        /* the air pressure follows from the elevation only */
+        P = 101.325*pow(10,3)*pow((293-0.0065*DS->EleP.zmax[i])/293,5.26);
+        DS->EleP.Gamma[i]    = P*1.0035*0.92/(0.622*2441);
+    }
+
+    pad = (DS->NumRiv + PIHM_ALIGN/sizeof(realtype) - 1)/(PIHM_ALIGN/sizeof(realtype))*(PIHM_ALIGN/sizeof(realtype));
+    DS->RivP.block = (realtype *)alignedMalloc(9*pad*sizeof(realtype));
+    DS->RivP.zmin   = DS->RivP.block;
+    DS->RivP.zmax   = DS->RivP.block + pad;
+    DS->RivP.depth  = DS->RivP.block + 2*pad;
+    DS->RivP.Length = DS->RivP.block + 3*pad;
+    DS->RivP.coeff  = DS->RivP.block + 4*pad;
+    DS->RivP.bed    = DS->RivP.block + 5*pad;
+    DS->RivP.Rough  = DS->RivP.block + 6*pad;
+    DS->RivP.Sf     = DS->RivP.block + 7*pad;
+    DS->RivP.Cwr    = DS->RivP.block + 8*pad;
+    DS->RivP.interpOrd = (int *)alignedMalloc(pad*sizeof(int));
+    DS->RivP.xs = (riv_xs **)alignedMalloc(pad*sizeof(riv_xs *));
+
+    for(i=0; i<DS->NumRiv; i++)
+    {
+        DS->RivP.zmin[i]      = DS->Riv[i].zmin;
+        DS->RivP.zmax[i]      = DS->Riv[i].zmax;
+        DS->RivP.depth[i]     = DS->Riv[i].depth;
+        DS->RivP.Length[i]    = DS->Riv[i].Length;
+        DS->RivP.coeff[i]     = DS->Riv_Shape[DS->Riv[i].shape - 1].coeff;
+        DS->RivP.bed[i]       = DS->Riv_Shape[DS->Riv[i].shape - 1].bed;
+        DS->RivP.interpOrd[i] = DS->Riv_Shape[DS->Riv[i].shape - 1].interpOrd;
+        DS->RivP.Rough[i]     = DS->Riv_Mat[DS->Riv[i].material - 1].Rough;
+        DS->RivP.Sf[i]        = DS->Riv_Mat[DS->Riv[i].material - 1].Sf;
+        DS->RivP.Cwr[i]       = DS->Riv_Mat[DS->Riv[i].material - 1].Cwr;
+    }
+
+    /* closed form factors and depth tables of the river shapes */
+    XSInit(DS);
+
+    /*    Forcing cache: one value per unique time series, refilled whenever the time changes    */
+    DS->Forc.block = (realtype *)alignedMalloc((DS->NumPrep + DS->NumTemp + DS->NumHumidity + DS->NumWindVel + DS->NumRn + DS->NumP + 2*DS->NumLC + DS->NumMeltF)*sizeof(realtype));
+    DS->Forc.Prep     = DS->Forc.block;
+    DS->Forc.Temp     = DS->Forc.Prep + DS->NumPrep;
+    DS->Forc.Humidity = DS->Forc.Temp + DS->NumTemp;
+    DS->Forc.WindVel  = DS->Forc.Humidity + DS->NumHumidity;
+    DS->Forc.Rn       = DS->Forc.WindVel + DS->NumWindVel;
+    DS->Forc.Pressure = DS->Forc.Rn + DS->NumRn;
+    DS->Forc.LAI      = DS->Forc.Pressure + DS->NumP;
+    DS->Forc.DH       = DS->Forc.LAI + DS->NumLC;
+    DS->Forc.MeltF    = DS->Forc.DH + DS->NumLC;
+    DS->Forc.valid = 0;
+    DS->Forc.t = 0.0;
+
+    /*    Potential ET terms of the elements: refilled together with the forcing cache    */
+    pad = (DS->NumEle + PIHM_ALIGN/sizeof(realtype) - 1)/(PIHM_ALIGN/sizeof(realtype))*(PIHM_ALIGN/sizeof(realtype));
+    DS->PET.block = (realtype *)alignedMalloc(6*pad*sizeof(realtype));
+    DS->PET.Delta = DS->PET.block;
+    DS->PET.r_a   = DS->PET.block + pad;
+    DS->PET.num   = DS->PET.block + 2*pad;
+    DS->PET.et2   = DS->PET.block + 3*pad;
+    DS->PET.rsNum = DS->PET.block + 4*pad;
+    DS->PET.eta4  = DS->PET.block + 5*pad;
+
+    ForcingBreakpoints(DS, CS);
+
     printf("done.\n");
 }
 
+
+/*******************************************************************************
+*    Breakpoints of the Forcing
+********************************************************************************/
+int compareTime(const void *a, const void *b)
+//! Function compares two times for qsort()
+{
+    realtype ta, tb;
+
+    ta = *(const realtype *)a;
+    tb = *(const realtype *)b;
+    return (ta > tb) - (ta < tb);
+}
+
+
+int countRecords(TSD *Data, int num)
+//! Function returns the number of records of num time series
+/*! \param Data is the array of time series
+    \param num is the number of time series
+*/
+{
+    int k, n;
+
+    n = 0;
+    for(k=0; k<num; k++)
+    {
+        n = n + Data[k].length;
+    }
+    return n;
+}
+
+
+int addBreakpoints(TSD *Data, int num, int *used, realtype *tb, int n, Control_Data *CS)
+//! Function appends the record times (in minutes) inside the simulation of every time series in use; returns the new count
+/*! \param Data is the array of time series
+    \param num is the number of time series
+    \param used is 1 for a time series in use (NULL: all are used)
+    \param tb is the list of breakpoints
+    \param n is the number of breakpoints already in the list
+    \param CS is pointer to control data structure
+*/
+{
+    int j, k;
+    realtype t;
+
+    for(k=0; k<num; k++)
+    {
+        if(used != NULL && used[k] == 0)
+        {
+            continue;
+        }
+        for(j=0; j<Data[k].length; j++)
+        {
+            t = Data[k].TS[j][0]*24.0*60.0;
+            if(t > CS->StartTime && t < CS->EndTime)
+            {
+                tb[n++] = t;
+            }
+        }
+    }
+    return n;
+}
+
+
+void ForcingBreakpoints(Model_Data DS, Control_Data *CS)
+//! Merges the record times of every forcing time series in use into the sorted list CS->Tbreak
+/*! Interpolation() is linear between records, so the forcing seen by f() and calET_IS() has a kink
+    (or a step, for two records at the same time) at every record. The driver in pihm.c stops CVODE
+    exactly on these times instead of stepping across them.
+    \param DS is pointer to model data structure
+    \param CS is pointer to control data structure
+*/
+{
+    int i, k, n;
+    int *usedPrep, *usedTemp, *usedHumidity, *usedWindVel, *usedRn, *usedP, *usedLC, *usedEleBC, *usedRiv;
+    realtype *tb;
+
+    /* a series is in use if an element or a segment refers to it */
+    usedPrep     = (int *)calloc(DS->NumPrep + DS->NumTemp + DS->NumHumidity + DS->NumWindVel + DS->NumRn + DS->NumP
+                                 + DS->NumLC + DS->Num1BC + DS->Num2BC + DS->NumRivBC + 1, sizeof(int));
+    usedTemp     = usedPrep + DS->NumPrep;
+    usedHumidity = usedTemp + DS->NumTemp;
+    usedWindVel  = usedHumidity + DS->NumHumidity;
+    usedRn       = usedWindVel + DS->NumWindVel;
+    usedP        = usedRn + DS->NumRn;
+    usedLC       = usedP + DS->NumP;
+    usedEleBC    = usedLC + DS->NumLC;
+    usedRiv      = usedEleBC + DS->Num1BC + DS->Num2BC;
+    for(i=0; i<DS->NumEle; i++)
+    {
+        usedPrep[DS->Ele[i].prep - 1] = 1;
+        usedTemp[DS->Ele[i].temp - 1] = 1;
+        usedHumidity[DS->Ele[i].humidity - 1] = 1;
+        usedWindVel[DS->Ele[i].WindVel - 1] = 1;
+        usedRn[DS->Ele[i].Rn - 1] = 1;
+        usedP[DS->Ele[i].pressure - 1] = 1;
+        usedLC[DS->Ele[i].LC - 1] = 1;
+        if(DS->Ele[i].BC > 0)
+        {
+            usedEleBC[DS->Ele[i].BC - 1] = 1;
+        }
+        if(DS->Ele[i].BC < 0)
+        {
+            usedEleBC[-DS->Ele[i].BC - 1 + DS->Num1BC] = 1;
+        }
+    }
+    for(i=0; i<DS->NumRiv; i++)
+    {
+        if(DS->Riv[i].down < 0 && DS->Riv[i].BC > 0)
+        {
+            usedRiv[DS->Riv[i].BC - 1] = 1;
+        }
+    }
+
+    n = countRecords(DS->TSD_Prep, DS->NumPrep) + countRecords(DS->TSD_Temp, DS->NumTemp)
+      + countRecords(DS->TSD_Humidity, DS->NumHumidity) + countRecords(DS->TSD_WindVel, DS->NumWindVel)
+      + countRecords(DS->TSD_Rn, DS->NumRn) + countRecords(DS->TSD_Pressure, DS->NumP)
+      + countRecords(DS->TSD_LAI, DS->NumLC) + countRecords(DS->TSD_DH, DS->NumLC)
+      + countRecords(DS->TSD_MeltF, DS->NumMeltF) + countRecords(DS->TSD_EleBC, DS->Num1BC + DS->Num2BC)
+      + countRecords(DS->TSD_Riv, DS->NumRivBC);
+    tb = (realtype *)malloc((n + 1)*sizeof(realtype));
+
+    n = 0;
+    n = addBreakpoints(DS->TSD_Prep, DS->NumPrep, usedPrep, tb, n, CS);
+    n = addBreakpoints(DS->TSD_Temp, DS->NumTemp, usedTemp, tb, n, CS);
+    n = addBreakpoints(DS->TSD_Humidity, DS->NumHumidity, usedHumidity, tb, n, CS);
+    n = addBreakpoints(DS->TSD_WindVel, DS->NumWindVel, usedWindVel, tb, n, CS);
+    n = addBreakpoints(DS->TSD_Rn, DS->NumRn, usedRn, tb, n, CS);
+    n = addBreakpoints(DS->TSD_Pressure, DS->NumP, usedP, tb, n, CS);
+    n = addBreakpoints(DS->TSD_LAI, DS->NumLC, usedLC, tb, n, CS);
+    n = addBreakpoints(DS->TSD_DH, DS->NumLC, usedLC, tb, n, CS);
+    n = addBreakpoints(DS->TSD_MeltF, DS->NumMeltF, NULL, tb, n, CS);      /* et_is.c uses the first melt factor everywhere */
+    n = addBreakpoints(DS->TSD_EleBC, DS->Num1BC + DS->Num2BC, usedEleBC, tb, n, CS);
+    n = addBreakpoints(DS->TSD_Riv, DS->NumRivBC, usedRiv, tb, n, CS);
+    free(usedPrep);
+
+    /* sorted unique times */
+    qsort(tb, n, sizeof(realtype), compareTime);
+    k = 0;
+    for(i=0; i<n; i++)
+    {
+        if(k == 0 || tb[i] - tb[k-1] > 1E-6)
+        {
+            tb[k++] = tb[i];
+        }
+    }
+
+    CS->NumBreak = k;
+    CS->Tbreak = tb;
+    printf("\n  %d forcing breakpoints in the simulation period ... ", CS->NumBreak);
+}
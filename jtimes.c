@@ -0,0 +1,1144 @@
+/*******************************************************************************
+ * File        : jtimes.c                                                      *
+ * Function    : Jacobian-times-vector of the right hand side by forward mode  *
+ *               automatic differentiation                                     *
+ * Programmers : Yizhong Qu   @ Pennsylvania State Univeristy                  *
+ *               Mukesh Kumar @ Pennsylvania State Univeristy                  *
+ *               Gopal Bhatt  @ Pennsylvania State Univeristy                  *
+ * Version     : 2.0 (July 10, 2007)                                           *
+ *-----------------------------------------------------------------------------*
+ *                                                                             *
+ * The Krylov solvers need J*v in every linear iteration. Differencing f()     *
+ * along v is badly scaled by the clamps and thresholds of the kernel (the     *
+ * bounds of DummyY, fabs(grad_y) <= avg_sf in the flow laws, the saturation   *
+ * checks): a perturbation that crosses one of them gives a meaningless slope. *
+ * Here the kernel is evaluated once in dual numbers, a value and its          *
+ * derivative along v, so that                                                 *
+ *   1. J*v is exact for the branch taken at y, at about twice the cost of     *
+ *      f();                                                                   *
+ *   2. the value part reproduces f() operation by operation; every branch is  *
+ *      decided on values exactly as in f(). When f() changes, fDual() must    *
+ *      follow it. With Debug 1 in .para, Jtimes() compares the value part     *
+ *      with the f() passed in by CVODE on every call and stops at the first   *
+ *      state that differs.                                                    *
+ * Where the slope is infinite (sqrt or a fractional power of a zero depth)    *
+ * the derivative is taken as zero, as for a depth that stays at zero.         *
+ * Fluxes, ET and recharge stored in Model_Data are not touched.               *
+ *                                                                             *
+ * This code is free for users with research purpose only, if appropriate      *
+ * citation is refered. However, there is no warranty in any format for this   *
+ * product.                                                                    *
+ *                                                                             *
+ * For questions or comments, please contact the authors of the reference.     *
+ * One who want to use it for other consideration may also contact Dr.Duffy    *
+ * at cxd11@psu.edu.                                                           *
+ *******************************************************************************/
+
+//! @file jtimes.c Exact Jacobian-times-vector (dual numbers) registered through CVSpils
+
+/*    C Header Files    */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+/*    SUNDIALS Header Files    */
+#include "nvector_serial.h"
+#include "sundials_types.h"
+
+/*    PIHM Header Files    */
+#include "pihm.h"
+
+#define EPSILON 0.05		/**< as in f.c */
+#define GRAV  73231257600.0	/**< Gravitational Accelaration in m/day^2 */
+#define ABS_TOL    1E-4		/**< Bound of the states as used in f()              */
+#define CHECK_TOL  1E-10	/**< Relative difference of fDual() and f() allowed by the Debug check */
+
+/*    Function Declarations    */
+void *alignedMalloc(size_t size);
+realtype Interpolation(TSD *Data, realtype t);
+void updateForcing(Model_Data MD, realtype t);
+void JtimesInit(Model_Data MD, int check);
+int Jtimes(N_Vector CV_V, N_Vector CV_JV, realtype t, N_Vector CV_Y, N_Vector CV_F, void *DS, N_Vector tmp);
+void fDual(realtype t, realtype *Y, realtype *V, Model_Data MD);
+void DualVertical(Model_Data MD, int i, dual *y, dual *dy);
+dual DualRecharge(Model_Data MD, int i, dual *y);
+int CS_Table(riv_xs *xs, int a_pBool, realtype rivDepth, realtype *val, realtype *slope);
+dual DualAreaOrPerem(riv_xs *xs, dual rivDepth, int a_pBool);
+dual DualSurfFlowKW(dual avg_y, dual grad_y, realtype avg_sf, dual crossA, realtype avg_rough);
+dual DualSurfFlowDW(dual avg_y, dual grad_y, realtype avg_sf, dual crossA, realtype avg_rough);
+dual DualChanFlow(dual grad_y, realtype avg_sf, dual crossA, realtype avg_rough, dual avg_perem);
+void DualEleFacesKW(Model_Data MD);
+void DualEleFacesDW(Model_Data MD);
+dual DualOLflowFromEleToRiv(dual sideEle_y, realtype sideEle_zmax, realtype cwr, realtype rivZmax, dual loc_yriver, realtype length);
+dual DualGWflowFromEleToRiv(dual sideEle_y, realtype sideEle_zmax, realtype sideEle_zmin, realtype dist, int loc_McPore, dual loc_yriver, dual loc_totyriver,
+                            realtype length, dual loc_gama, dual loc_perem, realtype loc_ksat, realtype ele_Thresh, realtype rivK);
+dual DualMacropore(Model_Data MD, realtype aqDepth, dual ySurf, dual yUnsat, dual ySat, realtype slope, realtype ovlThresh);
+dual DualAvgHead(dual y1, realtype z1, dual y2, realtype z2);
+
+
+
+/*******************************************************************************
+*    Dual Arithmetic: value v and derivative d along the direction of J*v
+********************************************************************************/
+static dual DVal(realtype v, realtype d)
+{
+    dual a;
+    a.v = v;
+    a.d = d;
+    return a;
+}
+
+static dual DAdd(dual a, dual b)    { return DVal(a.v + b.v, a.d + b.d); }
+static dual DSub(dual a, dual b)    { return DVal(a.v - b.v, a.d - b.d); }
+static dual DAddC(dual a, realtype c)    { return DVal(a.v + c, a.d); }
+static dual DSubC(dual a, realtype c)    { return DVal(a.v - c, a.d); }
+static dual DCSub(realtype c, dual a)    { return DVal(c - a.v, -a.d); }
+static dual DMul(dual a, dual b)    { return DVal(a.v*b.v, a.d*b.v + a.v*b.d); }
+static dual DScale(realtype c, dual a)   { return DVal(c*a.v, c*a.d); }
+static dual DDivC(dual a, realtype c)    { return DVal(a.v/c, a.d/c); }
+
+static dual DDiv(dual a, dual b)
+{
+    realtype v = a.v/b.v;
+    return DVal(v, (a.d - v*b.d)/b.v);
+}
+
+static dual DCDiv(realtype c, dual a)
+{
+    realtype v = c/a.v;
+    return DVal(v, -v*a.d/a.v);
+}
+
+static dual DPow(dual a, realtype p)
+{
+    /* the slope of a fractional power is infinite at zero: taken as zero */
+    if(a.d == 0.0 || p == 0.0 || (a.v == 0.0 && p < 1.0))
+    {
+        return DVal(pow(a.v, p), 0.0);
+    }
+    return DVal(pow(a.v, p), p*pow(a.v, p - 1.0)*a.d);
+}
+
+static dual DSqrt(dual a)
+{
+    realtype v = sqrt(a.v);
+    return DVal(v, v > 0.0 ? a.d/(2.0*v) : 0.0);
+}
+
+static dual DLog(dual a)    { return DVal(log(a.v), a.d/a.v); }
+static dual DCos(dual a)    { return DVal(cos(a.v), -sin(a.v)*a.d); }
+
+
+
+/*******************************************************************************
+*    Setup
+********************************************************************************/
+void JtimesInit(Model_Data MD, int check)
+//! Function allocates the dual workspace of fDual()
+/*! \param MD is pointer to model data structure
+    \param check is 1 to check fDual() against f() on every call of Jtimes() (Debug in .para)
+*/
+{
+    MD->Jt.Check = check;
+    MD->Jt.Y = (dual *)alignedMalloc((3*MD->NumEle+MD->NumRiv)*sizeof(dual));
+    MD->Jt.DY = (dual *)alignedMalloc((3*MD->NumEle+MD->NumRiv)*sizeof(dual));
+    MD->Jt.FluxSurf = (dual *)alignedMalloc(3*MD->NumEle*sizeof(dual));
+    MD->Jt.FluxSub = (dual *)alignedMalloc(3*MD->NumEle*sizeof(dual));
+    MD->Jt.FluxRiv = (dual *)alignedMalloc(6*(MD->NumRiv > 0 ? MD->NumRiv : 1)*sizeof(dual));
+}
+
+
+/*******************************************************************************
+*    Jacobian-times-vector Function
+********************************************************************************/
+int Jtimes(N_Vector CV_V, N_Vector CV_JV, realtype t, N_Vector CV_Y, N_Vector CV_F, void *DS, N_Vector tmp)
+//! Function computes J*v exactly from the dual evaluation of the right hand side
+/*! \param CV_V is the vector v
+    \param CV_JV is the product J*v (output)
+    \param t is the time of simulation
+    \param CV_Y is state variable vector
+    \param CV_F is f(t, CV_Y)
+    \param DS is pointer to model data structure
+    \param tmp is a work vector of CVODE
+*/
+{
+    int i;
+    realtype *JV, *F;
+    Model_Data MD;
+
+    MD = (Model_Data) DS;
+    JV = NV_DATA_S(CV_JV);
+
+    fDual(t, NV_DATA_S(CV_Y), NV_DATA_S(CV_V), MD);
+
+    /* the value part is f(t, CV_Y): a difference means that fDual() no longer follows f() */
+    if(MD->Jt.Check == 1)
+    {
+        F = NV_DATA_S(CV_F);
+        for(i=0; i<3*MD->NumEle+MD->NumRiv; i++)
+        {
+            if(fabs(MD->Jt.DY[i].v - F[i]) > CHECK_TOL*(1.0 + fabs(F[i])))
+            {
+                printf("\n  Fatal Error: fDual() = %e but f() = %e for state %d at t = %f min!\n", MD->Jt.DY[i].v, F[i], i, t);
+                exit(1);
+            }
+        }
+    }
+
+    #pragma omp parallel for
+    for(i=0; i<3*MD->NumEle+MD->NumRiv; i++)
+    {
+        JV[i] = MD->Jt.DY[i].d;
+    }
+
+    return(0);
+}
+
+
+void fDual(realtype t, realtype *Y, realtype *V, Model_Data MD)
+//! Function evaluates f() in dual numbers at Y along V; the result is left in MD->Jt.DY
+/*! \param t is the time of simulation
+    \param Y is the state
+    \param V is the direction of the derivative
+    \param MD is pointer to model data structure
+*/
+{
+    int i, j, k, l, bank, slot;
+    realtype Distance, Avg_Ksat, Avg_Sf, Avg_Rough, loc_bcEle, Avg_BedDepth, AquiferDepth, c;
+    dual Avg_Y_Sub, Dif_Y_Sub, Grad_Y_Sub;
+    dual TotalY_Riv, TotalY_Riv_down, Perem, Perem_down, Avg_Perem, Avg_Y_Riv, Dif_Y_Riv, CrossA, loc_perem;
+    dual mp_factor, Recharge, zero;
+    dual ye[3], dye[3];
+    dual *DummyY, *DummyDY, *FluxSurf, *FluxSub, *FluxRiv;
+
+    updateForcing(MD, t);
+
+    DummyY = MD->Jt.Y;
+    DummyDY = MD->Jt.DY;
+    FluxSurf = MD->Jt.FluxSurf;
+    FluxSub = MD->Jt.FluxSub;
+    FluxRiv = MD->Jt.FluxRiv;
+    zero = DVal(0.0, 0.0);
+
+    /* bounds of the states: a bound state does not move with v */
+    #pragma omp parallel for
+    for(i=0; i<3*MD->NumEle+MD->NumRiv; i++)
+    {
+        DummyDY[i] = DVal(0.0, 0.0);
+        DummyY[i] = Y[i] <= ABS_TOL ? DVal(0.0, 0.0) : DVal(Y[i], V[i]);
+    }
+    #pragma omp parallel for
+    for(i=MD->NumEle; i<2*MD->NumEle; i++)
+    {
+        if(Y[i] > MD->EleP.AqDepth[i-MD->NumEle])
+        {
+            DummyY[i] = DVal(MD->EleP.AqDepth[i-MD->NumEle], 0.0);
+        }
+        if(Y[i+MD->NumEle] > MD->EleP.AqDepth[i-MD->NumEle])
+        {
+            DummyY[i+MD->NumEle] = DVal(MD->EleP.AqDepth[i-MD->NumEle], 0.0);
+        }
+        if(DummyY[i+MD->NumEle].v + DummyY[i].v > MD->EleP.AqDepth[i-MD->NumEle])
+        {
+            if(DummyY[i].v < MD->EleP.AqDepth[i-MD->NumEle])
+            {
+                DummyY[i] = DScale(1.0, DCSub(MD->EleP.AqDepth[i-MD->NumEle], DummyY[i+MD->NumEle]));
+            }
+            else
+            {
+                DummyY[i+MD->NumEle] = DVal(0.0, 0.0);
+            }
+        }
+    }
+
+    /* interior edges, once from the owner, by the face loop of the SurfMode of the run */
+    MD->DualEleFaces(MD);
+
+    /* boundary edges and vertical fluxes */
+    #pragma omp parallel for private(j,loc_bcEle,Avg_Y_Sub,Distance,Dif_Y_Sub,Avg_Ksat,Grad_Y_Sub,ye,dye)
+    for(i=0; i<MD->NumEle; i++)
+    {
+        for(j=0; j<3; j++)
+        {
+            if(MD->EleEdge[i][j].nabr < 0)
+            {
+                if(MD->Ele[i].BC == 0)
+                {
+                    FluxSurf[3*i+j] = zero;
+                    FluxSub[3*i+j] = zero;
+                }
+                else if(MD->Ele[i].BC > 0)
+                {
+                    /* Dirichlet */
+                    loc_bcEle = Interpolation(&MD->TSD_EleBC[(MD->Ele[i].BC)-1], t);
+                    if(loc_bcEle < MD->EleP.zmin[i])
+                    {
+                        Avg_Y_Sub = DDivC(DummyY[i+2*MD->NumEle], 2);
+                    }
+                    else if(loc_bcEle < MD->EleP.zmax[i])
+                    {
+                        Avg_Y_Sub = DDivC(DAddC(DummyY[i+2*MD->NumEle], loc_bcEle - MD->EleP.zmin[i]), 2.0);
+                    }
+                    else
+                    {
+                        Avg_Y_Sub = DVal(MD->EleEdge[i][j].aqDepth, 0.0);
+                    }
+                    Distance = MD->EleEdge[i][j].bddDist;
+                    Dif_Y_Sub = DSubC(DAddC(DummyY[i+2*MD->NumEle], MD->EleP.zmin[i]), loc_bcEle);
+                    Avg_Ksat = MD->EleP.Ksat[i];
+                    Grad_Y_Sub = DDivC(Dif_Y_Sub, Distance);
+                    FluxSub[3*i+j] = DScale(MD->EleEdge[i][j].length, DMul(DScale(Avg_Ksat, Grad_Y_Sub), Avg_Y_Sub));
+                    FluxSurf[3*i+j] = DDivC(DScale(MD->EleEdge[i][j].length,
+                                                   DMul(DMul(DSqrt(DDivC(DummyY[i], Distance)), DPow(DummyY[i], 2.0/3.0)), DDivC(DummyY[i], 2))),
+                                            MD->EleP.Rough[i]);
+                }
+                else
+                {
+                    /* Neumann: the surface flux of this edge is left as f() last set it */
+                    FluxSub[3*i+j] = DVal(Interpolation(&MD->TSD_EleBC[(-MD->Ele[i].BC)-1+MD->Num1BC], t), 0.0);
+                    FluxSurf[3*i+j] = DVal(MD->FluxSurf[i][j], 0.0);
+                }
+                if(DummyY[i+2*MD->NumEle].v <= 0 && FluxSub[3*i+j].v > 0)
+                {
+                    FluxSub[3*i+j] = zero;
+                }
+            }
+        }
+
+        ye[0] = DummyY[i];
+        ye[1] = DummyY[i+MD->NumEle];
+        ye[2] = DummyY[i+2*MD->NumEle];
+        DualVertical(MD, i, ye, dye);
+        DummyDY[i] = dye[0];
+        DummyDY[i+MD->NumEle] = dye[1];
+        DummyDY[i+2*MD->NumEle] = dye[2];
+    }
+
+    /* river segments: outflow, overland and subsurface exchange with the banks */
+    #pragma omp parallel for private(j,k,TotalY_Riv,Perem,TotalY_Riv_down,Perem_down,Avg_Perem,Avg_Y_Riv,Avg_Rough,Distance,Dif_Y_Riv,Avg_Sf,CrossA,mp_factor,loc_perem,bank,c)
+    for(i=0; i<MD->NumRiv; i++)
+    {
+        for(j=0; j<6; j++)
+        {
+            FluxRiv[6*i+j] = zero;
+        }
+        TotalY_Riv = DAddC(DummyY[i+3*MD->NumEle], MD->RivP.zmin[i]);
+        Perem = DualAreaOrPerem(MD->RivP.xs[i], DummyY[i+3*MD->NumEle], 2);
+        if(MD->Riv[i].down > 0)
+        {
+            k = MD->Riv[i].down - 1;
+            TotalY_Riv_down = DAddC(DummyY[k+3*MD->NumEle], MD->RivP.zmin[k]);
+            Perem_down = DualAreaOrPerem(MD->RivP.xs[k], DummyY[k+3*MD->NumEle], 2);
+            Avg_Perem = DDivC(DAdd(Perem, Perem_down), 2.0);
+            Avg_Y_Riv = DualAvgHead(DummyY[i+3*MD->NumEle], MD->RivP.zmin[i], DummyY[k+3*MD->NumEle], MD->RivP.zmin[k]);
+            Avg_Rough = (MD->RivP.Rough[i] + MD->RivP.Rough[k])/2.0;
+            Distance = (MD->RivP.Length[i] + MD->RivP.Length[k])/2;
+            Dif_Y_Riv = DDivC(DSub(TotalY_Riv, TotalY_Riv_down), Distance);
+            Avg_Sf = (MD->RivP.Sf[i] + MD->RivP.Sf[k])/2.0;
+            CrossA = DualAreaOrPerem(MD->RivP.xs[i], Avg_Y_Riv, 1);
+            FluxRiv[6*i+1] = DualChanFlow(Dif_Y_Riv, Avg_Sf, CrossA, Avg_Rough, Avg_Perem);
+            if(DummyY[i+3*MD->NumEle].v <= 0 && FluxRiv[6*i+1].v > 0)
+            {
+                FluxRiv[6*i+1] = zero;
+            }
+            else if(DummyY[k+3*MD->NumEle].v <= 0 && FluxRiv[6*i+1].v < 0)
+            {
+                FluxRiv[6*i+1] = zero;
+            }
+        }
+        else
+        {
+            switch(MD->Riv[i].down)
+            {
+                case -1:
+                    /* Dirichlet */
+                    c = Interpolation(&MD->TSD_Riv[(MD->Riv[i].BC)-1], t) + MD->Node[MD->Riv[i].ToNode-1].zmin + MD->RivP.bed[i];
+                    Distance = (MD->RivP.Length[i])*0.5;
+                    Dif_Y_Riv = DDivC(DSubC(TotalY_Riv, c), Distance);
+                    CrossA = DualAreaOrPerem(MD->RivP.xs[i], DummyY[i+3*MD->NumEle], 1);
+                    FluxRiv[6*i+1] = DualChanFlow(Dif_Y_Riv, MD->RivP.Sf[i], CrossA, MD->RivP.Rough[i], Perem);
+                    break;
+                case -2:
+                    /* Neumann */
+                    FluxRiv[6*i+1] = DVal(Interpolation(&MD->TSD_Riv[MD->Riv[i].BC-1], t), 0.0);
+                    break;
+                case -3:
+                    /* zero-depth-gradient */
+                    Distance = (MD->RivP.Length[i])*0.5;
+                    c = 0.1/Distance;
+                    CrossA = DualAreaOrPerem(MD->RivP.xs[i], DummyY[i+3*MD->NumEle], 1);
+                    FluxRiv[6*i+1] = DDivC(DMul(DScale(sqrt(c), CrossA), DualAreaOrPerem(MD->RivP.xs[i], DummyY[i+3*MD->NumEle], 4)), MD->RivP.Rough[i]);
+                    break;
+                case -4:
+                    /* critical depth */
+                    CrossA = DualAreaOrPerem(MD->RivP.xs[i], DummyY[i+3*MD->NumEle], 1);
+                    FluxRiv[6*i+1] = DMul(CrossA, DSqrt(DScale(GRAV, DummyY[i+3*MD->NumEle])));
+                    break;
+            }
+            if(DummyY[i+3*MD->NumEle].v <= 0 && FluxRiv[6*i+1].v > 0)
+            {
+                FluxRiv[6*i+1] = zero;
+            }
+        }
+
+        /* overland exchange with the banks: [2] left, [3] right */
+        for(j=0; j<2; j++)
+        {
+            bank = j == 0 ? MD->RivGeom[i].left : MD->RivGeom[i].right;
+            if(bank >= 0)
+            {
+                FluxRiv[6*i+2+j] = DualOLflowFromEleToRiv(DummyY[bank], MD->EleP.zmax[bank], MD->RivP.Cwr[i], MD->RivP.zmax[i], TotalY_Riv, MD->RivP.Length[i]);
+                if(DummyY[i+3*MD->NumEle].v <= 0 && FluxRiv[6*i+2+j].v > 0)
+                {
+                    FluxRiv[6*i+2+j] = zero;
+                }
+                if(DummyY[bank].v <= 0 && FluxRiv[6*i+2+j].v < 0)
+                {
+                    FluxRiv[6*i+2+j] = zero;
+                }
+            }
+        }
+
+        /* subsurface exchange with the banks: [4] left, [5] right */
+        for(j=0; j<2; j++)
+        {
+            bank = j == 0 ? MD->RivGeom[i].left : MD->RivGeom[i].right;
+            if(bank < 0)
+            {
+                continue;
+            }
+            if(MD->EleP.Macropore[bank] == 0)
+            {
+                mp_factor = DVal(1.0, 0.0);
+            }
+            else
+            {
+                mp_factor = DualMacropore(MD, MD->EleP.AqDepth[bank], DummyY[bank], DummyY[bank+MD->NumEle], DummyY[bank+2*MD->NumEle],
+                                          MD->Cal.mpSlopeH, MD->Cal.ovlThreshH);
+            }
+            if((MD->RivP.zmin[i] + DummyY[i+3*MD->NumEle].v - (DummyY[bank+2*MD->NumEle].v + MD->EleP.zmin[bank])) > 0)
+            {
+                loc_perem = Perem;
+            }
+            else if(MD->EleP.zmin[bank] < MD->RivP.zmin[i])
+            {
+                if((DummyY[bank+2*MD->NumEle].v + MD->EleP.zmin[bank] - MD->RivP.zmin[i]) > MD->RivP.depth[i])
+                {
+                    loc_perem = DualAreaOrPerem(MD->RivP.xs[i], DVal(MD->RivP.depth[i], 0.0), 2);
+                }
+                else
+                {
+                    loc_perem = DualAreaOrPerem(MD->RivP.xs[i], DSubC(DAddC(DummyY[bank+2*MD->NumEle], MD->EleP.zmin[bank]), MD->RivP.zmin[i]), 2);
+                }
+            }
+            else
+            {
+                if(DummyY[bank+2*MD->NumEle].v > MD->RivP.depth[i])
+                {
+                    loc_perem = DualAreaOrPerem(MD->RivP.xs[i], DVal(MD->RivP.depth[i], 0.0), 2);
+                }
+                else
+                {
+                    loc_perem = DualAreaOrPerem(MD->RivP.xs[i], DummyY[bank+2*MD->NumEle], 2);
+                }
+            }
+            FluxRiv[6*i+4+j] = DualGWflowFromEleToRiv(DummyY[bank+2*MD->NumEle], MD->EleP.zmax[bank], MD->EleP.zmin[bank],
+                                                      j == 0 ? MD->RivGeom[i].leftDist : MD->RivGeom[i].rightDist, MD->EleP.Macropore[bank],
+                                                      DummyY[i+3*MD->NumEle], TotalY_Riv, MD->RivP.Length[i], mp_factor, loc_perem,
+                                                      MD->EleP.Ksat[bank], MD->EleP.RzD[bank], MD->Cal.rivK);
+            if((DummyY[bank+2*MD->NumEle].v >= MD->EleP.AqDepth[bank]) && FluxRiv[6*i+4+j].v > 0)
+            {
+                FluxRiv[6*i+4+j] = zero;
+            }
+            if(DummyY[i+3*MD->NumEle].v <= 0 && FluxRiv[6*i+4+j].v > 0)
+            {
+                FluxRiv[6*i+4+j] = zero;
+            }
+            if(DummyY[bank+2*MD->NumEle].v <= 0 && FluxRiv[6*i+4+j].v < 0)
+            {
+                FluxRiv[6*i+4+j] = zero;
+            }
+        }
+    }
+
+    /* inflow from the upstream segments */
+    #pragma omp parallel for private(k)
+    for(i=0; i<MD->NumRiv; i++)
+    {
+        for(k=MD->RivUpPtr[i]; k<MD->RivUpPtr[i+1]; k++)
+        {
+            FluxRiv[6*i] = DAdd(FluxRiv[6*i], FluxRiv[6*MD->RivUp[k]+1]);
+        }
+    }
+
+    /* bank elements gather the exchange with their segments */
+    #pragma omp parallel for private(i,j,l,bank,slot,Avg_Y_Sub,Avg_BedDepth)
+    for(k=0; k<MD->NumEle; k++)
+    {
+        for(l=MD->EleRivPtr[k]; l<MD->EleRivPtr[k+1]; l++)
+        {
+            i = MD->EleRiv[l]/2;
+            j = MD->EleRiv[l]%2;
+            bank = j == 0 ? MD->RivGeom[i].left : MD->RivGeom[i].right;
+            slot = j == 0 ? MD->RivGeom[i].leftSlot : MD->RivGeom[i].rightSlot;
+            if(slot >= 0)
+            {
+                FluxSurf[3*bank+slot] = DScale(-1.0, FluxRiv[6*i+2+j]);
+            }
+            else
+            {
+                DummyDY[bank] = DAdd(DummyDY[bank], DDivC(FluxRiv[6*i+2+j], MD->EleP.area[bank]));
+            }
+            if(slot >= 0 && MD->RivGeom[i].left >= 0 && MD->RivGeom[i].right >= 0)
+            {
+                if(j == 0)
+                {
+                    Avg_Y_Sub = DualAvgHead(DummyY[MD->RivGeom[i].left+2*MD->NumEle], MD->EleP.zmin[MD->RivGeom[i].left],
+                                            DummyY[MD->RivGeom[i].right+2*MD->NumEle], MD->EleP.zmin[MD->RivGeom[i].right]);
+                    Avg_BedDepth = (MD->EleP.AqDepth[MD->RivGeom[i].right] + MD->EleP.AqDepth[MD->RivGeom[i].left])*0.5;
+                }
+                else
+                {
+                    Avg_Y_Sub = DualAvgHead(DummyY[MD->RivGeom[i].right+2*MD->NumEle], MD->EleP.zmin[MD->RivGeom[i].right],
+                                            DummyY[MD->RivGeom[i].left+2*MD->NumEle], MD->EleP.zmin[MD->RivGeom[i].left]);
+                    Avg_BedDepth = (MD->EleP.AqDepth[MD->RivGeom[i].left] + MD->EleP.AqDepth[MD->RivGeom[i].right])*0.5;
+                }
+                if(Avg_BedDepth - MD->RivP.depth[i] <= 0)
+                {
+                    FluxSub[3*bank+slot] = DVal(0.0, 0.0);
+                }
+                else if(Avg_Y_Sub.v > Avg_BedDepth - MD->RivP.depth[i])
+                {
+                    FluxSub[3*bank+slot] = DDiv(DScale(Avg_BedDepth - MD->RivP.depth[i], FluxSub[3*bank+slot]), Avg_Y_Sub);
+                }
+            }
+            DummyDY[bank+2*MD->NumEle] = DAdd(DummyDY[bank+2*MD->NumEle], DDivC(FluxRiv[6*i+4+j], MD->EleP.area[bank]));
+        }
+    }
+
+    /* lateral fluxes, recharge and bounds of the element rates */
+    #pragma omp parallel for private(j,AquiferDepth,ye,Recharge)
+    for(i=0; i<MD->NumEle; i++)
+    {
+        for(j=0; j<3; j++)
+        {
+            DummyDY[i] = DSub(DummyDY[i], DDivC(FluxSurf[3*i+j], MD->EleP.area[i]));
+            DummyDY[i+2*MD->NumEle] = DSub(DummyDY[i+2*MD->NumEle], DDivC(FluxSub[3*i+j], MD->EleP.area[i]));
+        }
+        AquiferDepth = MD->EleP.AqDepth[i];
+        ye[0] = DummyY[i];
+        ye[1] = DummyY[i+MD->NumEle];
+        ye[2] = DummyY[i+2*MD->NumEle];
+        Recharge = DualRecharge(MD, i, ye);
+
+        DummyDY[i+MD->NumEle] = DDivC(DAdd(DummyDY[i+MD->NumEle], Recharge), MD->EleP.Porosity[i]);
+        DummyDY[i+2*MD->NumEle] = DDivC(DSub(DummyDY[i+2*MD->NumEle], Recharge), MD->EleP.Porosity[i]);
+
+        if(DummyY[i+2*MD->NumEle].v >= AquiferDepth && DummyDY[i+2*MD->NumEle].v > 0)
+        {
+            DummyDY[i+2*MD->NumEle] = DVal(0.0, 0.0);
+        }
+        if(DummyY[i+2*MD->NumEle].v <= 0 && DummyDY[i+2*MD->NumEle].v < 0)
+        {
+            DummyDY[i+2*MD->NumEle] = DVal(0.0, 0.0);
+        }
+        if(DummyY[i+MD->NumEle].v >= AquiferDepth && DummyDY[i+MD->NumEle].v > 0)
+        {
+            DummyDY[i+MD->NumEle] = DVal(0.0, 0.0);
+        }
+        if(DummyY[i+MD->NumEle].v <= 0 && DummyDY[i+MD->NumEle].v < 0)
+        {
+            DummyDY[i+MD->NumEle] = DVal(0.0, 0.0);
+        }
+        if(DummyY[i].v <= 0 && DummyDY[i].v < 0)
+        {
+            DummyDY[i] = DVal(0.0, 0.0);
+        }
+    }
+
+    /* river rates */
+    #pragma omp parallel for
+    for(i=0; i<MD->NumRiv; i++)
+    {
+        DummyDY[i+3*MD->NumEle] = DSub(FluxRiv[6*i], FluxRiv[6*i+1]);
+        DummyDY[i+3*MD->NumEle] = DSub(DSub(DummyDY[i+3*MD->NumEle], FluxRiv[6*i+2]), FluxRiv[6*i+3]);
+        DummyDY[i+3*MD->NumEle] = DSub(DSub(DummyDY[i+3*MD->NumEle], FluxRiv[6*i+4]), FluxRiv[6*i+5]);
+        DummyDY[i+3*MD->NumEle] = DDiv(DummyDY[i+3*MD->NumEle],
+                                       DScale(MD->RivP.Length[i], DualAreaOrPerem(MD->RivP.xs[i], DummyY[i+3*MD->NumEle], 3)));
+        if(DummyY[i+3*MD->NumEle].v <= 0 && DummyDY[i+3*MD->NumEle].v < 0)
+        {
+            DummyDY[i+3*MD->NumEle] = DVal(0.0, 0.0);
+        }
+    }
+
+    /* per day to per minute, as in f() */
+    #pragma omp parallel for
+    for(i=0; i<3*MD->NumEle+MD->NumRiv; i++)
+    {
+        DummyDY[i] = DDivC(DummyDY[i], 60.0*24.0);
+    }
+}
+
+
+dual DualAvgHead(dual y1, realtype z1, dual y2, realtype z2)
+//! Function returns the average flow depth across an edge from the depths y and bottom elevations z on both sides (as in f())
+/*! \param y1 is the water depth on the first side
+    \param z1 is the bottom elevation on the first side
+    \param y2 is the water depth on the second side
+    \param z2 is the bottom elevation on the second side
+*/
+{
+    if(z2 > z1)
+    {
+        if(z2 > z1 + y1.v)
+        {
+            return DDivC(y2, 2);
+        }
+        return DDivC(DAdd(DSubC(DAddC(y1, z1), z2), y2), 2);
+    }
+    if(z1 > z2 + y2.v)
+    {
+        return DDivC(y1, 2);
+    }
+    return DDivC(DSubC(DAddC(DAdd(y1, y2), z2), z1), 2);
+}
+
+
+dual DualMacropore(Model_Data MD, realtype aqDepth, dual ySurf, dual yUnsat, dual ySat, realtype slope, realtype ovlThresh)
+//! Function returns the macropore factor of a lateral flux (as in f())
+/*! \param MD is pointer to model data structure
+    \param aqDepth is the aquifer depth used for the saturation
+    \param ySurf is the surface storage
+    \param yUnsat is the unsaturated storage
+    \param ySat is the saturated storage
+    \param slope is the macropore slope of the flux direction
+    \param ovlThresh is the surface storage threshold of the flux direction
+*/
+{
+    dual elemSatn, mp;
+
+    if(aqDepth - ySat.v - yUnsat.v <= 0)
+    {
+        elemSatn = DVal(1.0, 0.0);
+    }
+    else
+    {
+        elemSatn = DDivC(ySat, aqDepth);
+    }
+    if((elemSatn.v >= MD->Cal.satThresh) && (ySurf.v > ovlThresh))
+    {
+        mp = DAddC(DScale(slope, DSubC(elemSatn, MD->Cal.satThresh)), 1.0);
+        mp = DAddC(DScale(MD->Cal.mpArea, mp), 1*(1-MD->Cal.mpArea));
+        return mp;
+    }
+    return DVal(1.0, 0.0);
+}
+
+
+static inline void DualEleFace(Model_Data MD, int k, const int surfmode)
+//! Function is EleFaceFlux() in dual numbers; the fluxes are left in MD->Jt
+/*! \param MD is pointer to model data structure
+    \param k is the index of the face
+    \param surfmode is the Surface Overland Mode; a literal constant in every caller
+*/
+{
+    int i, j, inabr, jnabr;
+    realtype Distance, Avg_Ksat, Avg_Sf, Avg_Rough;
+    dual Avg_Y_Surf, Dif_Y_Surf, Grad_Y_Surf, CrossA;
+    dual Avg_Y_Sub, Dif_Y_Sub, Grad_Y_Sub;
+    dual mp_factor, mp_nabr, temp1, temp2, zero;
+    dual *DummyY, *FluxSurf, *FluxSub;
+
+    DummyY = MD->Jt.Y;
+    FluxSurf = MD->Jt.FluxSurf;
+    FluxSub = MD->Jt.FluxSub;
+    zero = DVal(0.0, 0.0);
+
+    i = MD->Face[k].owner;
+    j = MD->Face[k].ownerSlot;
+    inabr = MD->Face[k].nabr;
+    jnabr = MD->Face[k].nabrSlot;
+
+    /* subsurface */
+    Avg_Y_Sub = DualAvgHead(DummyY[i+2*MD->NumEle], MD->EleP.zmin[i], DummyY[inabr+2*MD->NumEle], MD->EleP.zmin[inabr]);
+    Dif_Y_Sub = DSub(DAddC(DummyY[i+2*MD->NumEle], MD->EleP.zmin[i]), DAddC(DummyY[inabr+2*MD->NumEle], MD->EleP.zmin[inabr]));
+    Distance = MD->EleEdge[i][j].distance;
+    Avg_Ksat = (MD->EleP.KsatH[i] + MD->EleP.KsatH[inabr])/2.0;
+    Grad_Y_Sub = DDivC(Dif_Y_Sub, Distance);
+    mp_factor = DVal(1.0, 0.0);
+    mp_nabr = DVal(1.0, 0.0);
+    if(MD->EleP.Macropore[i] == 1 || MD->EleP.Macropore[inabr] == 1)
+    {
+        temp1 = DualMacropore(MD, MD->EleEdge[i][j].aqDepth, DummyY[i], DummyY[i+MD->NumEle], DummyY[i+2*MD->NumEle],
+                              MD->Cal.mpSlopeH, MD->Cal.ovlThreshH);
+        temp2 = DualMacropore(MD, MD->EleEdge[i][j].nabrAqDepth, DummyY[inabr], DummyY[inabr+MD->NumEle], DummyY[inabr+2*MD->NumEle],
+                              MD->Cal.mpSlopeH, MD->Cal.ovlThreshH);
+        if(MD->EleP.Macropore[i] == 1)
+        {
+            mp_factor = DDivC(DAdd(temp1, temp2), 2.0);
+        }
+        if(MD->EleP.Macropore[inabr] == 1)
+        {
+            mp_nabr = DDivC(DAdd(temp1, temp2), 2.0);
+        }
+    }
+    FluxSub[3*i+j] = DScale(MD->EleEdge[i][j].length, DMul(DMul(DScale(Avg_Ksat, mp_factor), Grad_Y_Sub), Avg_Y_Sub));
+    FluxSub[3*inabr+jnabr] = DScale(MD->EleEdge[i][j].length, DMul(DMul(DScale(Avg_Ksat, DScale(-1.0, mp_nabr)), Grad_Y_Sub), Avg_Y_Sub));
+    if(DummyY[i+2*MD->NumEle].v <= 0 && FluxSub[3*i+j].v > 0)
+    {
+        FluxSub[3*i+j] = zero;
+    }
+    if(DummyY[inabr+2*MD->NumEle].v <= 0 && FluxSub[3*i+j].v < 0)
+    {
+        FluxSub[3*i+j] = zero;
+    }
+    if((DummyY[i+2*MD->NumEle].v >= MD->EleEdge[i][j].aqDepth) && FluxSub[3*i+j].v < 0)
+    {
+        FluxSub[3*i+j] = zero;
+    }
+    if((DummyY[inabr+2*MD->NumEle].v >= MD->EleEdge[i][j].nabrAqDepth) && FluxSub[3*i+j].v > 0)
+    {
+        FluxSub[3*i+j] = zero;
+    }
+    if(FluxSub[3*i+j].v == 0)
+    {
+        FluxSub[3*inabr+jnabr] = zero;
+    }
+
+    /* surface */
+    Avg_Y_Surf = DualAvgHead(DummyY[i], MD->EleP.zmax[i], DummyY[inabr], MD->EleP.zmax[inabr]);
+    Dif_Y_Surf = DSub(DAddC(DummyY[i], MD->EleP.zmax[i]), DAddC(DummyY[inabr], MD->EleP.zmax[inabr]));
+    Grad_Y_Surf = DDivC(Dif_Y_Surf, Distance);
+    Avg_Sf = (MD->EleP.Sf[i] + MD->EleP.Sf[inabr])/2.0;
+    Avg_Rough = 0.5*(MD->EleP.Rough[i] + MD->EleP.Rough[inabr]);
+    CrossA = DScale(MD->EleEdge[i][j].length, Avg_Y_Surf);
+    FluxSurf[3*i+j] = surfmode == 1 ? DualSurfFlowKW(Avg_Y_Surf, Grad_Y_Surf, Avg_Sf, CrossA, Avg_Rough)
+                                    : DualSurfFlowDW(Avg_Y_Surf, Grad_Y_Surf, Avg_Sf, CrossA, Avg_Rough);
+    if(DummyY[i].v <= 0 && FluxSurf[3*i+j].v > 0)
+    {
+        FluxSurf[3*i+j] = zero;
+    }
+    if(DummyY[inabr].v <= 0 && FluxSurf[3*i+j].v < 0)
+    {
+        FluxSurf[3*i+j] = zero;
+    }
+    FluxSurf[3*inabr+jnabr] = DScale(-1.0, FluxSurf[3*i+j]);
+}
+
+
+/* One copy of the face loop per Surface Overland Mode, as ELE_FACES in f.c */
+#define DUAL_ELE_FACES(NAME, SURFMODE)                                         \
+void NAME(Model_Data MD)                                                       \
+{                                                                              \
+    int k;                                                                     \
+                                                                               \
+    _Pragma("omp parallel for")                                                \
+    for(k=0; k<MD->NumFace; k++)                                               \
+    {                                                                          \
+        DualEleFace(MD, k, SURFMODE);                                          \
+    }                                                                          \
+}
+
+DUAL_ELE_FACES(DualEleFacesKW, 1)         /* Kinematic Wave */
+DUAL_ELE_FACES(DualEleFacesDW, 2)         /* Diffusion Wave */
+
+
+void DualVertical(Model_Data MD, int i, dual *y, dual *dy)
+//! Function is EleVertical() in dual numbers; ET and infiltration are not stored
+/*! \param MD is pointer to model data structure
+    \param i is the index of the element
+    \param y is the bounded state of the element: surface, unsaturated and saturated storage
+    \param dy is the rate of change of the three states due to the vertical fluxes (output)
+*/
+{
+    realtype LAI, Rmax, num;
+    realtype AquiferDepth;
+    dual elemSatn, beta_s, r_s, et1, et2, Vic, Deficit, mp_factor;
+
+    dy[0] = DVal(0.0, 0.0);
+    dy[1] = DVal(0.0, 0.0);
+    dy[2] = DVal(0.0, 0.0);
+
+    if(MD->EleP.AqDepth[i]-y[2].v-y[1].v <= 0)
+    {
+        elemSatn = DVal(1.0, 0.0);
+    }
+    else
+    {
+        elemSatn = (y[2].v+y[1].v > MD->EleP.RzBase[i]) ? DScale(0.5, DCSub(1, DCos(DScale(3.14, DDivC(y[2], MD->EleP.AqDepth[i]))))) : DVal(0.0, 0.0);
+    }
+    LAI = MD->Forc.LAI[MD->Ele[i].LC-1];
+    et2 = DVal(MD->PET.et2[i], 0.0);
+
+    if(LAI > 0.0)
+    {
+        Rmax = 5000.0/(24*3600);
+        beta_s = elemSatn.v > EPSILON/1000.0 ? elemSatn : DVal(EPSILON/1000.0, 0.0);
+        r_s = DCDiv(MD->PET.rsNum[i], DScale(MD->PET.eta4[i], DScale(LAI, beta_s)));
+        if(r_s.v > Rmax)
+        {
+            r_s = DVal(Rmax, 0.0);
+        }
+        num = LAI*MD->EleP.et1Frac[i]*(1-pow((MD->EleIS[i]<0?0:MD->EleIS[i])/MD->EleISmax[i],2.0/3))*MD->PET.num[i];
+        et1 = DCDiv(num, DScale(1000*2441000.0, DAddC(DScale(MD->EleP.Gamma[i], DAddC(DDivC(r_s, MD->PET.r_a[i]), 1)), MD->PET.Delta[i])));
+    }
+    else
+    {
+        et1 = DVal(0.0, 0.0);
+    }
+
+    AquiferDepth = MD->EleP.AqDepth[i];
+    if(y[2].v+y[1].v >= AquiferDepth)
+    {
+        Deficit = DVal(0.0, 0.0);
+        Vic = DVal(0.0, 0.0);
+    }
+    else if(y[2].v+y[1].v > AquiferDepth-MD->EleP.RzD[i])
+    {
+        Deficit = DCSub(AquiferDepth, y[2]);
+        Vic = DScale(MD->EleP.KsatInf[i], DAddC(DDivC(y[0], MD->EleP.RzD[i]), 1));
+    }
+    else
+    {
+        Deficit = DCSub(AquiferDepth, y[2]);
+        Vic = DScale(MD->EleP.KsatInf[i], DAddC(DDivC(DSub(y[0], DDivC(DLog(DDiv(DAddC(y[1], EPSILON/10000.0), DAddC(DSubC(Deficit, MD->EleP.RzD[i]), EPSILON/10000.0))),
+                                                                             MD->EleP.Alpha[i])), MD->EleP.RzD[i]), 1));
+    }
+
+    if(y[1].v < Deficit.v)
+    {
+        if(y[0].v > 0)
+        {
+            if(MD->EleP.Macropore[i] == 0)
+            {
+                mp_factor = DVal(1.0, 0.0);
+            }
+            else
+            {
+                mp_factor = DualMacropore(MD, MD->EleP.AqDepth[i], y[0], y[1], y[2], MD->Cal.mpSlopeV, MD->Cal.ovlThreshV);
+            }
+            dy[0] = DSub(DCSub(MD->EleNetPrep[i], DMul(mp_factor, Vic)), et2);
+            dy[1] = DScale(1.0-MD->Cal.mpArea, Vic);
+            dy[2] = DAdd(dy[2], DMul(DSubC(mp_factor, 1*(1-MD->Cal.mpArea)), Vic));
+        }
+        else if(MD->EleNetPrep[i] > Vic.v+et2.v)
+        {
+            dy[0] = DCSub(MD->EleNetPrep[i], DAdd(Vic, et2));
+            dy[1] = Vic;
+        }
+        else if(MD->EleNetPrep[i] < Vic.v+et2.v)
+        {
+            if(MD->EleNetPrep[i] < Vic.v)
+            {
+                dy[1] = DCSub(MD->EleNetPrep[i], DMul(elemSatn, et2));
+            }
+            else
+            {
+                dy[1] = Vic;
+            }
+        }
+        else
+        {
+            dy[1] = DCSub(MD->EleNetPrep[i], DMul(elemSatn, et2));
+        }
+    }
+    else
+    {
+        if(y[0].v > 0)
+        {
+            dy[0] = DCSub(MD->EleNetPrep[i], et2);
+        }
+        else if(MD->EleNetPrep[i] > 0)
+        {
+            if(MD->EleNetPrep[i] > et2.v)
+            {
+                dy[0] = DCSub(MD->EleNetPrep[i], et2);
+            }
+        }
+        else
+        {
+            dy[2] = DCSub(0, DMul(elemSatn, et2));
+        }
+    }
+
+    if(y[2].v >= AquiferDepth-MD->EleP.RzD[i])
+    {
+        dy[2] = DSub(dy[2], et1);
+    }
+    else
+    {
+        dy[1] = DSub(dy[1], et1);
+    }
+}
+
+
+dual DualRecharge(Model_Data MD, int i, dual *y)
+//! Function is EleRecharge() in dual numbers
+/*! \param MD is pointer to model data structure
+    \param i is the index of the element
+    \param y is the bounded state of the element: surface, unsaturated and saturated storage
+*/
+{
+    realtype AquiferDepth;
+    dual elemSatn, Recharge;
+
+    AquiferDepth = MD->EleP.AqDepth[i];
+    if(MD->EleP.AqDepth[i]-y[2].v-y[1].v <= 0)
+    {
+        elemSatn = DVal(1.0, 0.0);
+    }
+    else
+    {
+        elemSatn = DScale(0.5, DCSub(1, DCos(DScale(3.14, DDiv(y[1], DCSub(MD->EleP.AqDepth[i], y[2]))))));
+    }
+
+    if(elemSatn.v == 0.0)
+    {
+        Recharge = DVal(0.0, 0.0);
+    }
+    else
+    {
+        Recharge = DMul(DScale(AquiferDepth, DScale(-MD->EleP.KsatRec[i], elemSatn)),
+                        DCSub(1, DDivC(DScale(2, DLog(elemSatn)), AquiferDepth*MD->EleP.Alpha[i])));
+        Recharge = DDiv(Recharge, DAdd(DCSub(AquiferDepth, y[2]), DMul(y[2], elemSatn)));
+    }
+
+    if(y[1].v <= 0 && Recharge.v < 0)
+    {
+        Recharge = DVal(0.0, 0.0);
+    }
+    if(y[2].v <= 0 && Recharge.v > 0)
+    {
+        Recharge = DVal(0.0, 0.0);
+    }
+
+    return Recharge;
+}
+
+
+dual DualAreaOrPerem(riv_xs *xs, dual rivDepth, int a_pBool)
+//! Function is CS_Area(), CS_Perem(), CS_EqWid() and CS_R23() in dual numbers: 1 area, 2 perimeter, 3 equivalent width, 4 hydraulic radius^(2/3)
+/*! \param xs is the cross-section of the river segment's shape
+    \param rivDepth is the depth of water in the river segment
+    \param a_pBool is identifer for either Area or Peremeter
+*/
+{
+    int rivOrder = xs->order;
+    realtype rivCoeff = xs->coeff;
+    realtype val, slope;
+    dual a, b;
+
+    /* tabulated depths: the slope of the monotone cubic is the derivative */
+    if(a_pBool != 3 && CS_Table(xs, a_pBool, rivDepth.v, &val, &slope))
+    {
+        return DVal(val, slope*rivDepth.d);
+    }
+    if(a_pBool == 4)
+    {
+        a = DualAreaOrPerem(xs, rivDepth, 1);
+        b = DualAreaOrPerem(xs, rivDepth, 2);
+        return b.v > 0 ? DPow(DDiv(a, b), 2.0/3.0) : DVal(0.0, 0.0);
+    }
+
+    if(rivOrder == 1)
+    {
+        if(a_pBool == 1)
+        {
+            return DScale(rivCoeff, rivDepth);
+        }
+        if(a_pBool == 2)
+        {
+            return DAddC(DScale(2.0, rivDepth), rivCoeff);
+        }
+        return DVal(rivCoeff, 0.0);
+    }
+    if(rivOrder < 1 || rivOrder > 4)
+    {
+        return DVal(0.0, 0.0);
+    }
+    if(a_pBool != 1 && a_pBool != 2)
+    {
+        /* as in CS_EqWid(): the exponent 1/(rivOrder-1) is an integer division */
+        return DDivC(DScale(2.0, DPow(DAddC(rivDepth, EPSILON), 1/(rivOrder-1))), pow(rivCoeff, 1/(rivOrder-1)));
+    }
+    switch(rivOrder)
+    {
+        case 2:
+            if(a_pBool == 1)
+            {
+                return DDivC(DPow(rivDepth, 2), rivCoeff);
+            }
+            return DDivC(DScale(pow(1+pow(rivCoeff,2),0.5), DScale(2.0, rivDepth)), rivCoeff);
+        case 3:
+            if(a_pBool == 1)
+            {
+                return DDivC(DScale(4, DPow(rivDepth, 1.5)), 3*pow(rivCoeff,0.5));
+            }
+            a = DPow(DDivC(DMul(rivDepth, DAddC(DScale(4*rivCoeff, rivDepth), 1)), rivCoeff), 0.5);
+            b = DAdd(DScale(2, DPow(DScale(rivCoeff, rivDepth), 0.5)), DPow(DAddC(DScale(4*rivCoeff, rivDepth), 1), 0.5));
+            return DAdd(a, DDivC(DLog(b), 2*rivCoeff));
+        default:
+            if(a_pBool == 1)
+            {
+                return DDivC(DScale(3, DPow(rivDepth, 4.0/3.0)), 2*pow(rivCoeff,1.0/3.0));
+            }
+            a = DDivC(DPow(DMul(rivDepth, DAddC(DScale(9*pow(rivCoeff,2.0/3.0), rivDepth), 1)), 0.5), 3);
+            b = DAdd(DScale(3*pow(rivCoeff,1.0/3.0), DPow(rivDepth, 0.5)), DPow(DAddC(DScale(9*pow(rivCoeff,2.0/3.0), rivDepth), 1), 0.5));
+            return DScale(2, DAdd(a, DDivC(DLog(b), 9*pow(rivCoeff,1.0/3.0))));
+    }
+}
+
+
+dual DualSurfFlowKW(dual avg_y, dual grad_y, realtype avg_sf, dual crossA, realtype avg_rough)
+//! Function is SurfFlowKW() in dual numbers; returns the flux
+/*! \param avg_y is the avarage head between the elements
+    \param grad_y is the hydraulic gradient between the elements
+    \param avg_sf is the avarage friction slope of the elements
+    \param crossA is average area of cross-section
+    \param avg_rough is avarage manning's roughness coefficient
+*/
+{
+    int locBool;
+
+    /* below the friction slope the flux and its slope are zero */
+    if(fabs(grad_y.v) <= avg_sf)
+    {
+        return DVal(0.0, 0.0);
+    }
+    locBool = grad_y.v > 0 ? 1 : -1;
+    return DMul(DMul(DScale(locBool, DDivC(DSqrt(DScale(locBool, grad_y)), avg_rough)), DPow(avg_y, 2.0/3.0)), crossA);
+}
+
+
+dual DualSurfFlowDW(dual avg_y, dual grad_y, realtype avg_sf, dual crossA, realtype avg_rough)
+//! Function is SurfFlowDW() in dual numbers; returns the flux
+/*! \param avg_y is the avarage head between the elements
+    \param grad_y is the hydraulic gradient between the elements
+    \param avg_sf is the avarage friction slope of the elements
+    \param crossA is average area of cross-section
+    \param avg_rough is avarage manning's roughness coefficient
+*/
+{
+    int locBool;
+
+    if(fabs(grad_y.v) <= avg_sf)
+    {
+        return DVal(0.0, 0.0);
+    }
+    locBool = grad_y.v > 0 ? 1 : -1;
+    return DMul(DMul(DScale(locBool, crossA), DDivC(DPow(DPow(avg_y, 1.0/3.0), 2), 1.0*avg_rough)), DSqrt(DScale(locBool, grad_y)));
+}
+
+
+dual DualChanFlow(dual grad_y, realtype avg_sf, dual crossA, realtype avg_rough, dual avg_perem)
+//! Function is ChanFlow() in dual numbers; returns the flux
+/*! \param grad_y is the hydraulic gradient between the segments
+    \param avg_sf is the avarage friction slope of the segments
+    \param crossA is average area of cross-section
+    \param avg_rough is avarage manning's roughness coefficient
+    \param avg_perem is the avarage wetted perimeter
+*/
+{
+    int locBool;
+    dual hydRadius;
+
+    if(fabs(grad_y.v) <= avg_sf)
+    {
+        return DVal(0.0, 0.0);
+    }
+    locBool = grad_y.v > 0 ? 1 : -1;
+    /* hydraulic radius is single precision in ChanFlow() */
+    hydRadius = avg_perem.v > 0 ? DDiv(crossA, avg_perem) : DVal(0.0, 0.0);
+    hydRadius.v = (float)hydRadius.v;
+    return DDivC(DMul(DMul(DScale(locBool, DSqrt(DScale(locBool, grad_y))), crossA), DPow(hydRadius, 2.0/3.0)), avg_rough);
+}
+
+
+dual DualOLflowFromEleToRiv(dual sideEle_y, realtype sideEle_zmax, realtype cwr, realtype rivZmax, dual loc_yriver, realtype length)
+//! Function is OLflowFromEleToRiv() in dual numbers; returns the flux
+/*! \param sideEle_y is the surface water head at the side element
+    \param sideEle_zmax is surface elevation of the side element
+    \param cwr is the coefficient of discharge
+    \param rivZmax is the full bank elevation of the river segment
+    \param loc_yriver is the river water head in the river
+    \param length is the lenght of the river segment
+*/
+{
+    realtype loc_bele;
+    dual ele_YH;
+
+    ele_YH = DAddC(sideEle_y, sideEle_zmax);
+    loc_bele = rivZmax < sideEle_zmax ? sideEle_zmax : rivZmax;
+
+    if(loc_yriver.v > ele_YH.v)
+    {
+        if(ele_YH.v > loc_bele)
+        {
+            return DDivC(DMul(DScale(cwr*2.0*sqrt(2*GRAV)*length, DSqrt(DSub(loc_yriver, ele_YH))), DSubC(loc_yriver, loc_bele)), 3.0);
+        }
+        if(loc_bele < loc_yriver.v)
+        {
+            return DDivC(DMul(DScale(cwr*2.0*sqrt(2*GRAV)*length, DSqrt(DSubC(loc_yriver, loc_bele))), DSubC(loc_yriver, loc_bele)), 3.0);
+        }
+        return DVal(0.0, 0.0);
+    }
+    if(loc_yriver.v > loc_bele)
+    {
+        return DDivC(DMul(DScale(-cwr*2.0*sqrt(2*GRAV)*length, DSqrt(DSub(ele_YH, loc_yriver))), DSubC(ele_YH, loc_bele)), 3.0);
+    }
+    if(loc_bele < ele_YH.v)
+    {
+        return DDivC(DMul(DScale(-cwr*2.0*sqrt(2*GRAV)*length, DSqrt(DSubC(ele_YH, loc_bele))), DSubC(ele_YH, loc_bele)), 3.0);
+    }
+    return DVal(0.0, 0.0);
+}
+
+
+dual DualGWflowFromEleToRiv(dual sideEle_y, realtype sideEle_zmax, realtype sideEle_zmin, realtype dist, int loc_McPore, dual loc_yriver, dual loc_totyriver,
+                            realtype length, dual loc_gama, dual loc_perem, realtype loc_ksat, realtype ele_Thresh, realtype rivK)
+//! Function is GWflowFromEleToRiv() in dual numbers; returns the flux
+/*! \param sideEle_y is the groundwater head at the side element
+    \param sideEle_zmax is surface elevation of the side element
+    \param sideEle_zmin is bed elevation of the side element
+    \param dist is the distance between the river segment and the side element centroid
+    \param loc_McPore is the identifier for Macropore
+    \param loc_yriver is the river water head
+    \param loc_totyriver is the river water elevation
+    \param length is the length of the river segment
+    \param loc_gama is macropore factor
+    \param loc_perem is the wetted perimeter
+    \param loc_ksat is the saturated hydraulic conductivity
+    \param ele_Thresh is the threshold of the head difference
+    \param rivK is the calibration factor of conductivity at the river-element interface
+*/
+{
+    realtype mp_Rzd = 0.8;
+    dual loc_sat, loc_rivK_CALIB, ele_YH, dh, flux;
+
+    mp_Rzd = ((sideEle_zmax - sideEle_zmin - mp_Rzd) < 0) ? (sideEle_zmax-sideEle_zmin) : mp_Rzd;
+    loc_sat = DDivC(DSubC(sideEle_y, sideEle_zmax-sideEle_zmin-mp_Rzd), mp_Rzd);
+    loc_rivK_CALIB = loc_sat.v >= 0 ? DAddC(DScale(rivK, loc_sat), 1.0) : DVal(1.0, 0.0);
+    ele_YH = DAddC(sideEle_y, sideEle_zmin);
+
+    if(DSub(loc_totyriver, ele_YH).v > 0)
+    {
+        if(loc_yriver.v > 0)
+        {
+            dh = (loc_totyriver.v-loc_yriver.v) > (ele_YH.v+ele_Thresh) ? DVal(ele_Thresh, 0.0) : DSub(loc_totyriver, ele_YH);
+        }
+        else
+        {
+            dh = DVal(0.0, 0.0);
+        }
+    }
+    else
+    {
+        dh = sideEle_y.v > 0 ? DSub(loc_totyriver, ele_YH) : DVal(0.0, 0.0);
+    }
+    flux = DDivC(DMul(DMul(DScale(loc_ksat, DScale(length, DScale(0.5, loc_perem))), loc_rivK_CALIB), dh), dist);
+    if(flux.v <= 0 && loc_McPore == 1)
+    {
+        flux = DMul(flux, loc_gama);
+    }
+    return flux;
+}
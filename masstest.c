@@ -0,0 +1,198 @@
+/*******************************************************************************
+ * File        : masstest.c                                                    *
+ * Function    : test of the mass balance of the river-element exchange on     *
+ *               reaches with one bank (make test)                             *
+ * Programmers : Yizhong Qu   @ Pennsylvania State Univeristy                  *
+ *               Mukesh Kumar @ Pennsylvania State Univeristy                  *
+ *               Gopal Bhatt  @ Pennsylvania State Univeristy                  *
+ * Version     : 2.0 (July 10, 2007)                                           *
+ *-----------------------------------------------------------------------------*
+ *                                                                             *
+ * The data set of calib.c is read as by pihm.c, and every segment with two    *
+ * banks is given one: the right bank of even segments and the left bank of    *
+ * odd segments are dropped before initialize(). At a wet state with the       *
+ * rivers over their banks, f() is evaluated before and after raising the      *
+ * stage of one inner segment (not an outlet). The stage enters only the       *
+ * exchange of the segment with its banks and its neighbors, so the water      *
+ * gained by the rivers must equal the water lost by the elements: the total   *
+ * of                                                                          *
+ *   area*(dSurf + porosity*(dUnsat + dSat)) over the elements and             *
+ *   length*width*dRiv over the segments                                       *
+ * must not change. The test fails (exit status 1) for a segment where it      *
+ * changes by more than MASS_TOL of the rates involved.                        *
+ *                                                                             *
+ * This code is free for users with research purpose only, if appropriate      *
+ * citation is refered. However, there is no warranty in any format for this   *
+ * product.                                                                    *
+ *                                                                             *
+ * For questions or comments, please contact the authors of the reference.     *
+ * One who want to use it for other consideration may also contact Dr.Duffy    *
+ * at cxd11@psu.edu.                                                           *
+ *******************************************************************************/
+
+//! @file masstest.c Mass balance of the river-element exchange on one-bank reaches
+
+/*    C Header Files    */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* SUNDIAL Header Files */
+#include "sundials_types.h"            /* realtype, integertype, booleantype defination */
+#include "nvector_serial.h"            /* contains the definition of type N_Vector      */
+
+/* PIHM Header Files */
+#include "pihm.h"                      /* Definations for all data Structure in PIHM    */
+
+#define MASS_TOL       1E-9            /**< Relative change of the total rate allowed   */
+
+/* Function declarations */
+void setFileName(char *);                                /* file name prefix of calib.c                          */
+void read_alloc(char *, Model_Data, Control_Data *);     /* read input from files :: read_alloc.c                */
+N_Vector N_VNew_Serial(int);                             /**< \brief CVODE::Set vector of initial values         */
+void initialize(char *, Model_Data, Control_Data *, N_Vector);
+                                                         /* Initialize model & Control Data :: initialize.c      */
+void SetModeKernels(Model_Data);                         /* selects the RHS kernels of the modes :: f.c          */
+void calET_IS(realtype, realtype, Model_Data, N_Vector); /* Calculates ET & IS    :: et_is.c                     */
+int  f(realtype, N_Vector, N_Vector, void *);            /* RHS of system of ODEs :: f.c                         */
+realtype CS_EqWid(riv_xs *, realtype);                   /* equivalent width of a segment :: xsection.c          */
+
+
+realtype TotalRate(Model_Data mData, N_Vector CV_Y, N_Vector CV_Yd, realtype *scale)
+//! Function returns the rate of change of the water volume of the elements and the segments
+/*! \param mData is pointer to model data structure
+    \param CV_Y is the state vector
+    \param CV_Yd is the rate of change of the states from f()
+    \param scale is the total of the absolute volume rates (output)
+*/
+{
+    int i;
+    realtype q, total;
+
+    total = 0.0;
+    *scale = 0.0;
+    for(i=0; i<mData->NumEle; i++)
+    {
+        q = mData->EleP.area[i]*(NV_Ith_S(CV_Yd, i) + mData->EleP.Porosity[i]*(NV_Ith_S(CV_Yd, i+mData->NumEle) + NV_Ith_S(CV_Yd, i+2*mData->NumEle)));
+        total = total + q;
+        *scale = *scale + fabs(q);
+    }
+    for(i=0; i<mData->NumRiv; i++)
+    {
+        q = mData->RivP.Length[i]*CS_EqWid(mData->RivP.xs[i], NV_Ith_S(CV_Y, i+3*mData->NumEle))*NV_Ith_S(CV_Yd, i+3*mData->NumEle);
+        total = total + q;
+        *scale = *scale + fabs(q);
+    }
+
+    return total;
+}
+
+
+/* Main Function of the Test */
+int main(int argc, char *argv[])
+{
+    char *filename;                 /* File name prefix for input/output files    */
+    char tmpFileName[100];
+
+    Model_Data mData;               /* Model Data                                 */
+    Control_Data cData;             /* Control Data                               */
+    N_Vector CV_Y;                  /* State Variables Vector                     */
+    N_Vector CV_Yd;                 /* Rates of the State Variables               */
+
+    int N;                          /* Problem Size  (Numer of ODEs)              */
+    int i, nTest, nFail;
+    realtype t, y0, rate0, rate1, scale0, scale1;
+
+    setFileName(tmpFileName);
+    filename = (char *)malloc(sizeof(char)*(strlen(tmpFileName)+1));
+    strcpy(filename, tmpFileName);
+    mData = (Model_Data)malloc(sizeof *mData);
+
+    read_alloc(filename, mData, &cData);
+    SetModeKernels(mData);
+
+    /* one bank per segment */
+    for(i=0; i<mData->NumRiv; i++)
+    {
+        if(mData->Riv[i].LeftEle > 0 && mData->Riv[i].RightEle > 0)
+        {
+            if(i%2 == 0)
+            {
+                mData->Riv[i].RightEle = 0;
+            }
+            else
+            {
+                mData->Riv[i].LeftEle = 0;
+            }
+        }
+    }
+
+    N = 3*mData->NumEle + mData->NumRiv;
+    if(mData->UnsatMode == 1)
+    {
+        N = 2*mData->NumEle + mData->NumRiv;
+    }
+    if(mData->ISMode == 1)
+    {
+        N = N + 2*mData->NumEle;
+    }
+    CV_Y = N_VNew_Serial(N);
+    CV_Yd = N_VNew_Serial(N);
+
+    initialize(filename, mData, &cData, CV_Y);
+
+    /* a wet state inside the bounds of f(), no rate is clipped; the rivers are over their banks, so that their stage */
+    /* drives the overland exchange */
+    for(i=0; i<mData->NumEle; i++)
+    {
+        NV_Ith_S(CV_Y, i) = 0.05;
+        NV_Ith_S(CV_Y, i+mData->NumEle) = 0.3*mData->EleP.AqDepth[i];
+        NV_Ith_S(CV_Y, i+2*mData->NumEle) = 0.3*mData->EleP.AqDepth[i];
+    }
+    for(i=0; i<mData->NumRiv; i++)
+    {
+        NV_Ith_S(CV_Y, i+3*mData->NumEle) = mData->RivP.depth[i] + 0.1;
+    }
+
+    t = cData.StartTime;
+    if(mData->ISMode == 0)
+    {
+        calET_IS(t, cData.ETStep, mData, CV_Y);
+    }
+
+    nTest = 0;
+    nFail = 0;
+    for(i=0; i<mData->NumRiv; i++)
+    {
+        if(mData->Riv[i].down <= 0)
+        {
+            continue;
+        }
+        f(t, CV_Y, CV_Yd, mData);
+        rate0 = TotalRate(mData, CV_Y, CV_Yd, &scale0);
+
+        y0 = NV_Ith_S(CV_Y, i+3*mData->NumEle);
+        NV_Ith_S(CV_Y, i+3*mData->NumEle) = y0 + 0.1;
+        f(t, CV_Y, CV_Yd, mData);
+        rate1 = TotalRate(mData, CV_Y, CV_Yd, &scale1);
+        NV_Ith_S(CV_Y, i+3*mData->NumEle) = y0;
+
+        nTest++;
+        if(fabs(rate1 - rate0) > MASS_TOL*(scale0 + scale1))
+        {
+            printf("\n  Segment %d (banks %d %d): the volume rate changes by %e of %e\n", i+1, mData->Riv[i].LeftEle, mData->Riv[i].RightEle, rate1 - rate0, scale0);
+            nFail++;
+        }
+    }
+
+    printf("\n  %d of %d one-bank segments do not conserve mass\n", nFail, nTest);
+    if(nFail != 0)
+    {
+        printf("\n  Fatal Error: the river-element exchange creates or destroys water!\n");
+        exit(1);
+    }
+    printf("  Mass balance test passed.\n");
+
+    return 0;
+}
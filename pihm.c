@@ -70,6 +70,9 @@ accomplished are as follows:
 #include <math.h>
 #include <string.h>
 #include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 
 
@@ -80,13 +83,17 @@ accomplished are as follows:
 #include "sundials_math.h"              /* contains UnitRoundoff, RSqrt, SQR functions          */
 #include "cvode.h"                      /* header file fpr CVODE                                */
 #include "cvode_spgmr.h"                /* the Krylov solver SPGMR in the context of CVODE      */
+#include "cvode_spbcg.h"                /* the Krylov solver SPBCG in the context of CVODE      */
+#include "cvode_sptfqmr.h"              /* the Krylov solver SPTFQMR in the context of CVODE    */
 #include "cvode_dense.h"                /* dense direct linear solver in the context of CVODE   */
+#include "cvode_band.h"                 /* band direct linear solver in the context of CVODE    */
 #include "nvector_serial.h"             /* defines the serial implementation NVECTOR-SERIAL     */
 
 
 
 /* PIHM Header Files */
 #include "pihm.h"                       /* Definations for all data Structure in PIHM           */
+#include "stats.h"                      /* solver statistics and run-time profile :: stats.c    */
 //#include "et_is.h"
 
 /* Function declarations */
@@ -94,25 +101,53 @@ void read_alloc(char *, Model_Data, Control_Data *);     /* read input from file
 N_Vector N_VNew_Serial(int);                             /**< \brief CVODE::Set vector of initial values         */
 void initialize(char *, Model_Data, Control_Data *, N_Vector);
                                                          /* Initialize model & Control Data :: initialize.c      */
+int Precond(realtype, N_Vector, N_Vector, booleantype, booleantype *, realtype, void *, N_Vector, N_Vector, N_Vector);
+                                                         /* block-Jacobi preconditioner setup :: precond.c      */
+int PSolve(realtype, N_Vector, N_Vector, N_Vector, N_Vector, realtype, realtype, int, void *, N_Vector);
+                                                         /* block-Jacobi preconditioner solve :: precond.c      */
+void SparseInit(Model_Data);                             /* Jacobian pattern, coloring, envelope :: sparse.c     */
+void BandInit(Model_Data, int);                          /* band ordering and half-bandwidth :: sparse.c         */
+int fBand(realtype, N_Vector, N_Vector, void *);         /* f() on the states of the band ordering :: sparse.c   */
+void BandToModel(Model_Data, N_Vector, N_Vector);        /* band ordering to model ordering :: sparse.c          */
+void BandFromModel(Model_Data, N_Vector, N_Vector);      /* model ordering to band ordering :: sparse.c          */
+N_Vector BandModelState(Model_Data, N_Vector);           /* state of CVODE in the model ordering :: sparse.c     */
+int SparsePrecond(realtype, N_Vector, N_Vector, booleantype, booleantype *, realtype, void *, N_Vector, N_Vector, N_Vector);
+                                                         /* colored Jacobian and sparse LU :: sparse.c           */
+int SparsePSolve(realtype, N_Vector, N_Vector, N_Vector, N_Vector, realtype, realtype, int, void *, N_Vector);
+                                                         /* sparse triangular solves :: sparse.c                 */
+void JtimesInit(Model_Data, int);                        /* dual workspace of J*v :: jtimes.c                    */
+int Jtimes(N_Vector, N_Vector, realtype, N_Vector, N_Vector, void *, N_Vector);
+                                                         /* exact J*v by dual numbers :: jtimes.c                */
 
 void* CVodeCreate(int , int); 					         /**< \brief CVODE::Create the CVODE memory block and specify the Solution Method */
 int CVodeSetFdata(void *, void *);                       /**< \brief CVODE::Set Data for right-hand side function              */
 int CVodeSetInitStep(void *, realtype);                  /**< \brief CVODE::Set Initial step size                              */
 int CVodeSetStabLimDet(void *, booleantype);             /**< \brief CVODE::ON/OFF the BDF stability limit detection algorithm */
 int CVodeSetMaxStep(void *, realtype);                   /**< \brief CVODE::Specify the maximum absolute value of the step size*/
+int CVodeSetStopTime(void *, realtype);                  /**< \brief CVODE::Specify the time past which the solution is not to proceed */
+int CVodeGetCurrentStep(void *, realtype *);             /**< \brief CVODE::Step size to be attempted on the next step        */
+int CVodeGetDky(void *, realtype, int, N_Vector);        /**< \brief CVODE::Interpolated solution (k=0) at a time of the last step */
 int CVodeMalloc(void *, CVRhsFn, realtype, N_Vector, int, realtype, void *); /**< \brief CVODE::provide required problem specifications, allocate internal memory for CVODE, and initialize CVODE*/
 int CVSpgmr(void *, int, int);                           /**< \brief CVODE::selects the CVSPGMR linear solver                  */
+int CVSpbcg(void *, int, int);                           /**< \brief CVODE::selects the CVSPBCG linear solver                  */
+int CVSptfqmr(void *, int, int);                         /**< \brief CVODE::selects the CVSPTFQMR linear solver                */
+int CVBand(void *, long int, long int, long int);        /**< \brief CVODE::selects the CVBAND linear solver                   */
 int CVSpilsSetGSType(void *, int);                       /**< \brief CVODE::specifies Gram-Schmidt orthogonalization to be used*/
+int CVSpilsSetDelt(void *, realtype);                    /**< \brief CVODE::specifies the linear convergence tolerance factor  */
 
 void calET_IS(realtype, realtype, Model_Data, N_Vector); /* Calculates ET & IS    :: et_is.c                     */
-int CVode(void *, realtype, n_Vector, realtype *, int);  /**< \brief CVODE::Advance solution in time             */
+int CVode(void *, realtype, N_Vector, realtype *, int);  /**< \brief CVODE::Advance solution in time             */
 int  f(realtype, N_Vector, N_Vector, void *);            /* RHS of system of ODEs :: f.c                         */
+void SetModeKernels(Model_Data);                         /* selects the RHS kernels of the modes :: f.c          */
 
 void setTSDiCounter(Model_Data mData, realtype t);       /* set the current position (iCounter) of TSD           */
+int AdvanceOneStep(void *, Model_Data, Control_Data *, N_Vector, realtype *, int *, realtype);
+                                                         /* CV_ONE_STEP driver past an output time               */
 realtype Interpolation(TSD *Data, realtype t);           /* Data Value at time=t from a TimeSeries               */
 
-void FPrintInit(Model_Data);
+void FPrintInit(Model_Data, realtype);
 void FPrint(Model_Data, N_Vector, realtype);
+realtype FPrintNextTime(realtype);
 void FPrintInitFile(Model_Data, Control_Data, N_Vector, int);
 void FPrintCloseAll(void);
 
@@ -131,18 +166,20 @@ int main(int argc, char *argv[])
     Model_Data mData;               /* Model Data                                 */
     Control_Data cData;             /* Control Data                               */
     N_Vector CV_Y;                  /* State Variables Vector                     */
+    N_Vector CV_Ys;                 /* State of CVODE (band ordering in Solver 1) */
+    N_Vector CV_Yc;                 /* State of CVODE in one-step mode            */
+    N_Vector CV_Yd;                 /* Rates at the output time (flux snapshot)   */
 
     void *cvode_mem;                /* pointer to the CVODE memory block          */
     int flag;                       /* return value of cvode function calls       */
 
     int N;                          /* Problem Size  (Numer of ODEs)              */
     int i,j,k;                        /* loop index variables                     */
+    int b, itask;                   /* next forcing breakpoint & CVode task       */
     realtype t;                     /* simulation time (real time)                */
+    realtype tc;                    /* time reached by CVODE in one-step mode     */
     realtype NextPtr, StepSize;     /* stress period & step size                  */
 
-    clock_t start, end_r, end_s;    /* system clock at points                     */ //TODO: get rid of it
-    realtype cputime_r, cputime_s;  /* for duration in realtype                   */ //TODO: get rid of it
-
     /***************************
     Next two lines of variable declarations are for printing flow to estuary/BC */
     realtype loc1_bcEle, loc_Avg_Y_Surf, loc_Avg_Y_Sub, loc_Distance, loc_Dif_Y_Sub, loc_Avg_Ksat, loc_Grad_Y_Sub, Sub_Bdd, loc_Dif_Y_Surf, loc_Grad_Y_Surf, Surf_Bdd;
@@ -157,7 +194,6 @@ int main(int argc, char *argv[])
     strcpy(filename, tmpFileName);
 
     printf("\nBelt up!  PIHM 2.0 is starting ... \n");
-    start = clock();
     /* allocate memory for model data structure */
     mData = (Model_Data)malloc(sizeof *mData);
 
@@ -169,7 +205,19 @@ int main(int argc, char *argv[])
 
 
     /* read the input files with "filename" as prefix */
+    ProfStart(PROF_READ);
     read_alloc(filename, mData, &cData);          /* function definition in read_alloc.c    */
+    ProfStop(PROF_READ);
+
+    SetModeKernels(mData);                        /* mode specialized RHS kernels, once     */
+
+#ifdef _OPENMP
+    if(cData.NumThreads > 0)
+    {
+        omp_set_num_threads(cData.NumThreads);    /* threads used by the loops of f()       */
+    }
+    printf("\n  f() runs on up to %d thread(s)\n", omp_get_max_threads());
+#endif
 
     if(mData->UnsatMode ==1) //take off the option 1 from everywhere
     {
@@ -179,23 +227,39 @@ int main(int argc, char *argv[])
     {
         N = 3*mData->NumEle + mData->NumRiv;      /* Set problem dimension                  */
       }
+    if(mData->ISMode == 1)
+    {
+        N = N + 2*mData->NumEle;                  /* interception and snow storage states   */
+    }
 
     CV_Y = N_VNew_Serial(N);                      /* Set Vector of initial values           */
+    CV_Yd = N_VNew_Serial(N);                     /* Rates of the flux snapshot for FPrint  */
 
 
+    ProfStart(PROF_INIT);
     initialize(filename, mData, &cData, CV_Y);    /* initialize mode data structure         */
                                                   /* function definition in initialize.c    */
 
-    FPrintInit(mData);
+    FPrintInit(mData, cData.StartTime);
     //if(cData.Debug == 1) {PrintModelData(mData);}
-
-    end_r = clock();
-    cputime_r = (end_r - start)/(realtype)CLOCKS_PER_SEC;
+    ProfStop(PROF_INIT);
 
     printf("\nSolving ODE system ... \n");
 
 
     /* Create the CVODE memory block and specify the Solution Method */
+    /* the band solver integrates the states in the mesh ordering of sparse.c, CV_Y stays in the model ordering */
+    if(cData.Solver == 1)
+    {
+        BandInit(mData, N);
+        CV_Ys = N_VNew_Serial(N);
+        BandFromModel(mData, CV_Y, CV_Ys);
+    }
+    else
+    {
+        CV_Ys = CV_Y;
+    }
+
     cvode_mem = CVodeCreate(CV_BDF, CV_NEWTON);
     if(cvode_mem == NULL) { printf("CVodeCreate failed. \n"); return(1); }
 
@@ -204,18 +268,72 @@ int main(int argc, char *argv[])
     flag = CVodeSetInitStep(cvode_mem,cData.InitStep);                 /* Set Initial step size                                  */
     flag = CVodeSetStabLimDet(cvode_mem,TRUE);                         /* ON/OFF the BDF stability limit detection algorithm     */
     flag = CVodeSetMaxStep(cvode_mem,cData.MaxStep);                   /* Specify the maximum absolute value of the step size    */
-    flag = CVodeMalloc(cvode_mem, f, cData.StartTime, CV_Y, CV_SS, cData.reltol, &cData.abstol);
+    flag = CVodeMalloc(cvode_mem, cData.Solver == 1 ? fBand : fProf, cData.StartTime, CV_Ys, CV_SS, cData.reltol, &cData.abstol);
                                                                        /* provide required problem specifications,
                                                                          allocate internal memory for CVODE, and initialize CVODE*/
-    flag = CVSpgmr(cvode_mem, PREC_NONE, 0);                           /* selects the CVSPGMR linear solver                      */
-    flag = CVSpilsSetGSType(cvode_mem, MODIFIED_GS);                   /* specifies Gram-Schmidt orthogonalization to be used    */
+
+    /* linear solver of the Newton iteration as selected by Solver in .para */
+    switch(cData.Solver)
+    {
+        case 1:
+            i = mData->Band.bw;                                        /* half-bandwidth in the mesh ordering                    */
+            printf("  Banded direct solver: half-bandwidth %d of %d unknowns\n", i, N);
+            if(3*i + 1 >= N)
+            {
+                printf("  Warning: the band of the Jacobian is as wide as a dense matrix; Solver 2 or 5 is cheaper!\n");
+            }
+            flag = CVBand(cvode_mem, N, i, i);                         /* selects the CVBAND linear solver                       */
+            break;
+        case 2:
+            flag = CVSpgmr(cvode_mem, PREC_LEFT, cData.MaxK);          /* selects the CVSPGMR linear solver                      */
+            flag = CVSpilsSetGSType(cvode_mem, cData.GSType == 2 ? CLASSICAL_GS : MODIFIED_GS);
+                                                                       /* specifies Gram-Schmidt orthogonalization to be used    */
+            break;
+        case 3:
+            flag = CVSpbcg(cvode_mem, PREC_LEFT, cData.MaxK);          /* selects the CVSPBCG linear solver                      */
+            break;
+        case 4:
+            flag = CVSptfqmr(cvode_mem, PREC_LEFT, cData.MaxK);        /* selects the CVSPTFQMR linear solver                    */
+            break;
+        case 5:
+            SparseInit(mData);                                         /* pattern, coloring and envelope of the Jacobian         */
+            flag = CVSpgmr(cvode_mem, PREC_LEFT, cData.MaxK);          /* GMRES on the exactly factored Newton matrix            */
+            flag = CVSpilsSetGSType(cvode_mem, cData.GSType == 2 ? CLASSICAL_GS : MODIFIED_GS);
+            break;
+    }
+    if(cData.Solver >= 2)
+    {
+        flag = CVSpilsSetDelt(cvode_mem, cData.delt);                  /* linear convergence factor (0: CVODE default)           */
+        if(mData->ISMode == 0)                                         /* jtimes.c has no interception and snow states           */
+        {
+            JtimesInit(mData, cData.Debug);                            /* Debug: the value part is checked against f()           */
+            flag = CVSpilsSetJacTimesVecFn(cvode_mem, Jtimes, mData);  /* exact J*v instead of differencing f()                  */
+        }
+    }
+    if(cData.Solver >= 2 && cData.Solver <= 4)
+    {
+        flag = CVSpilsSetPreconditioner(cvode_mem, Precond, PSolve, mData);
+                                                                       /* block-Jacobi preconditioner of precond.c               */
+    }
+    if(cData.Solver == 5)
+    {
+        flag = CVSpilsSetPreconditioner(cvode_mem, SparsePrecond, SparsePSolve, mData);
+                                                                       /* sparse LU of I - gamma*J of sparse.c                   */
+    }
 
 
     /*allocate and copy to get output file name */
-
+    FPrintStatsInit(filename, cData.Profile);                          /* solver statistics (and profile) per output interval    */
 
 
     t = cData.StartTime;                                               /* set "t" to simulation start time                       */
+    b = 0;                                                             /* first forcing breakpoint after StartTime               */
+    if(cData.Dense == 1)
+    {
+        CV_Yc = N_VNew_Serial(N);                                      /* CVODE advances CV_Yc, CV_Y is interpolated             */
+        N_VScale(1.0, CV_Ys, CV_Yc);
+        tc = t;
+    }
 
     /* start CVODE solver in loops for NumStep number of times */
     for(i=0; i<cData.NumSteps; i++)
@@ -229,7 +347,17 @@ int main(int argc, char *argv[])
         /* inner loops to next output points with ET/IS step size control */
         while(t < cData.Tout[i+1])
         {
-            if (t + cData.ETStep >= cData.Tout[i+1])
+            if(cData.Dense == 1)
+            {
+                /* ET/IS follow the steps of CVODE: the output is taken at the end of every step, or at the next interval */
+                /* boundary of FPrint() if it comes first */
+                NextPtr = FPrintNextTime(t);
+                if(NextPtr > cData.Tout[i+1])
+                {
+                    NextPtr = cData.Tout[i+1];
+                }
+            }
+            else if (t + cData.ETStep >= cData.Tout[i+1])
             {
                 NextPtr = cData.Tout[i+1];
             }
@@ -237,9 +365,33 @@ int main(int argc, char *argv[])
             {
                 NextPtr = t + cData.ETStep;
             }
-            StepSize = NextPtr - t;
 
-            calET_IS(t, StepSize, mData, CV_Y);                        /* Calculate Evaporation/Interception Rates             */
+            if(cData.Dense == 0)
+            {
+                /* the forcing changes slope at a breakpoint: end the step exactly there, CVODE must not step across */
+                while(b < cData.NumBreak && cData.Tbreak[b] <= t + 1E-6)
+                {
+                    b++;
+                }
+                if(b < cData.NumBreak && cData.Tbreak[b] <= NextPtr)
+                {
+                    NextPtr = cData.Tbreak[b];
+                    flag = CVodeSetStopTime(cvode_mem, NextPtr);
+                    itask = CV_NORMAL_TSTOP;
+                }
+                else
+                {
+                    itask = CV_NORMAL;
+                }
+                StepSize = NextPtr - t;
+
+                if(mData->ISMode == 0)
+                {
+                    ProfStart(PROF_ETIS);
+                    calET_IS(t, StepSize, mData, CV_Y);                /* Calculate Evaporation/Interception Rates             */
+                    ProfStop(PROF_ETIS);
+                }
+            }
 
 
 /******************************************************************************************/
@@ -263,15 +415,61 @@ int main(int argc, char *argv[])
             Tsteps=t;
             printf("\n Tsteps = %f ",t);
 
-            flag = CVode(cvode_mem, NextPtr, CV_Y, &t, CV_NORMAL);    /* Advance solution in time                                */
+            if(cData.Dense == 0)
+            {
+                ProfStart(PROF_CVODE);
+                flag = CVode(cvode_mem, NextPtr, CV_Ys, &t, itask);   /* Advance solution in time                                */
+                ProfStop(PROF_CVODE);
+            }
+            else
+            {
+                /* one-step mode: CVODE takes its own steps and the means of FPrint() accumulate at the end of each; */
+                /* an interval that ends inside a step is closed with the state interpolated at its boundary         */
+                if(tc <= t + 1E-6)
+                {
+                    flag = AdvanceOneStep(cvode_mem, mData, &cData, CV_Yc, &tc, &b, t + 1E-6);
+                }
+                if(tc < NextPtr + 1E-6)
+                {
+                    N_VScale(1.0, CV_Yc, CV_Ys);
+                    if(tc < NextPtr - 1E-6)
+                    {
+                        NextPtr = tc;
+                    }
+                }
+                else
+                {
+                    flag = CVodeGetDky(cvode_mem, NextPtr, 0, CV_Ys);
+                    if(flag != CV_SUCCESS)
+                    {
+                        printf("\n  Fatal Error: CVodeGetDky failed at t = %f min, flag = %d!\n", NextPtr, flag);
+                        exit(1);
+                    }
+                }
+                t = NextPtr;
+            }
+            if(cData.Solver == 1)
+            {
+                BandToModel(mData, CV_Ys, CV_Y);
+            }
 
+            ProfStart(PROF_TSD);
             setTSDiCounter(mData, t);
+            ProfStop(PROF_TSD);
+            /* flux snapshot: one f() at the output state sets the fluxes, ET, infiltration and recharge (in ISMode 1 also */
+            /* interception and snow) that FPrint() writes at t; CVODE's last evaluation of f() may be at a trial state    */
+            ProfStart(PROF_SNAP);
+            f(t, CV_Y, CV_Yd, mData);
+            ProfStop(PROF_SNAP);
+            ProfStart(PROF_PRINT);
             FPrint(mData, CV_Y, t);
+            ProfStop(PROF_PRINT);
 
 
 /***************************************************************************************************************/
 /*  Specially for Rhode :: Estuary Discharge                                                                   */
 /***************************************************************************************************************/
+    ProfStart(PROF_ESTUARY);
     for(loc_i=0; loc_i<mData->NumEle; loc_i++){
         for(loc_j=0; loc_j<3; loc_j++){
             if(mData->Ele[loc_i].BC > 0){         // Dirichlet BC
@@ -286,21 +484,21 @@ int main(int argc, char *argv[])
                 }
                 else{
                     loc_Avg_Y_Surf = (NV_Ith_S(CV_Y, loc_i) + loc1_bcEle - mData->Ele[loc_i].zmax)/2;
-                    loc_Avg_Y_Sub  = mData->Ele[loc_i].zmax - mData->Ele[loc_i].zmin;
+                    loc_Avg_Y_Sub  = mData->Ele[loc_i].AqDepth;
                 }
-                loc_Distance = sqrt(pow(mData->Ele[loc_i].edge[0]*mData->Ele[loc_i].edge[1]*mData->Ele[loc_i].edge[2]/(4*mData->Ele[loc_i].area), 2) - pow(mData->Ele[loc_i].edge[loc_j]/2, 2));
+                loc_Distance = mData->EleEdge[loc_i][loc_j].bddDist;
                 //Sub
                 loc_Dif_Y_Sub = NV_Ith_S(CV_Y, loc_i+2*mData->NumEle) + mData->Ele[loc_i].zmin - loc1_bcEle;
                 loc_Avg_Ksat = mData->Ele[loc_i].Ksat;
                 loc_Grad_Y_Sub = loc_Dif_Y_Sub/loc_Distance;
-                Sub_Bdd = loc_Avg_Ksat * loc_Grad_Y_Sub * loc_Avg_Y_Sub * mData->Ele[loc_i].edge[loc_j];
+                Sub_Bdd = loc_Avg_Ksat * loc_Grad_Y_Sub * loc_Avg_Y_Sub * mData->EleEdge[loc_i][loc_j].length;
 
                 //Surf
                 loc_Dif_Y_Surf = NV_Ith_S(CV_Y, loc_i) + mData->Ele[loc_i].zmax - loc1_bcEle;
                 loc_Grad_Y_Surf = loc_Dif_Y_Surf / loc_Distance;
                 //Surf_Bdd = 0.1*(Grad_Y_Surf>0?1:-1)* (Avg_Y_Sub * mData->Ele[i].edge[loc_j] ) * (pow(pow(Avg_Y_Surf, 1.0/3.0),2)/(mData->Ele[i].Rough)) * sqrt((Grad_Y_Surf>0?1:-1)*Grad_Y_Surf);
 
-                Surf_Bdd = sqrt(NV_Ith_S(CV_Y, loc_i)/loc_Distance)*pow(NV_Ith_S(CV_Y, loc_i),2.0/3.0)*(NV_Ith_S(CV_Y, loc_i)/2)*mData->Ele[loc_i].edge[loc_j]/mData->Ele[loc_i].Rough;
+                Surf_Bdd = sqrt(NV_Ith_S(CV_Y, loc_i)/loc_Distance)*pow(NV_Ith_S(CV_Y, loc_i),2.0/3.0)*(NV_Ith_S(CV_Y, loc_i)/2)*mData->EleEdge[loc_i][loc_j].length/mData->Ele[loc_i].Rough;
 
                 fprintf(base2File, "%lf\t", Sub_Bdd);
                 fprintf(over2File, "%lf\t", Surf_Bdd);
@@ -320,13 +518,14 @@ int main(int argc, char *argv[])
             ovrEle=0;
             for(k=0; k<mData->NumEle;k++)
             {
-                if(NV_Ith_S(CV_Y, k+2*mData->NumEle)/(mData->Ele[k].zmax-mData->Ele[k].zmin)>0.99){
+                if(NV_Ith_S(CV_Y, k+2*mData->NumEle)/mData->Ele[k].AqDepth>0.99){
                     satEle++;
                 }
                 if(NV_Ith_S(CV_Y, k)>1E-4){
                     ovrEle++;
                 }
             }
+            ProfStop(PROF_ESTUARY);
 
 
             //fprintf(res_flux_file,"\n"); //fflush(res_flux_file);
@@ -336,6 +535,7 @@ int main(int argc, char *argv[])
 
         }
 
+        FPrintStats(cvode_mem, cData.Solver, i, t, flag);             /* CVODE counters and wall time of the interval          */
 
         /* print out results to files at every output time */
            //if (cData.res_out == 1) {FPrintY(mData, CV_Y, t, res_state_file);}
@@ -353,6 +553,7 @@ int main(int argc, char *argv[])
 
     FPrintInitFile(mData, cData, CV_Y, i);                    /* Routine for .init File : print.c     */
     FPrintCloseAll();
+    FPrintStatsClose();
 
 
 
@@ -361,10 +562,6 @@ int main(int argc, char *argv[])
 
 
 
-  /* capture time */
-    end_s = clock();
-    cputime_s = (end_s - end_r)/(realtype)CLOCKS_PER_SEC;
-
     /* print out simulation statistics */
     /*PrintFarewell(cData, iopt, ropt, cputime_r, cputime_s);
     if (cData.res_out == 1) {FPrintFarewell(cData, res_state_file, iopt, ropt, cputime_r, cputime_s);}
@@ -387,6 +584,85 @@ int main(int argc, char *argv[])
 
 
 
+int AdvanceOneStep(void *cvode_mem, Model_Data mData, Control_Data *cData, N_Vector CV_Yc, realtype *tc, int *b, realtype tout)
+//! Function advances CVODE in CV_ONE_STEP mode until it reaches or passes tout; ET/IS follow the steps of CVODE
+/*! The driver takes the output at the end of the step, and at the boundaries of FPrint() inside it by
+    CVodeGetDky(), so CVODE is not tied to the ETStep grid: MaxStep
+    bounds how long the ET/IS rates computed at the start of a step are held. Every step ends on or before
+    the next forcing breakpoint.
+    \param cvode_mem is the CVODE memory block
+    \param mData is pointer to model data structure
+    \param cData is pointer to control data structure
+    \param CV_Yc is the state of CVODE at *tc (in the band ordering with Solver 1)
+    \param tc is the time reached by CVODE
+    \param b is the index of the next forcing breakpoint
+    \param tout is the output time to be passed
+    With interception and snow as states (ISMode 1) there is nothing to do between the steps.
+*/
+{
+    int i, flag;
+    realtype tstop, h, t0;
+
+    flag = CV_SUCCESS;
+    while(*tc < tout)
+    {
+        while(*b < cData->NumBreak && cData->Tbreak[*b] <= *tc + 1E-6)
+        {
+            (*b)++;
+        }
+        tstop = *b < cData->NumBreak ? cData->Tbreak[*b] : cData->Tout[cData->NumSteps];
+        flag = CVodeSetStopTime(cvode_mem, tstop);
+
+        /* interception and snow are stepped over the step CVODE is about to attempt */
+        flag = CVodeGetCurrentStep(cvode_mem, &h);
+        if(h <= 0.0)
+        {
+            h = cData->InitStep;
+        }
+        if(*tc + h > tstop)
+        {
+            h = tstop - *tc;
+        }
+        t0 = *tc;
+        if(mData->ISMode == 0)
+        {
+            for(i=0; i<mData->NumEle; i++)
+            {
+                mData->EleISSave[i] = mData->EleIS[i];
+                mData->EleSnowSave[i] = mData->EleSnow[i];
+            }
+            ProfStart(PROF_ETIS);
+            calET_IS(t0, h, mData, cData->Solver == 1 ? BandModelState(mData, CV_Yc) : CV_Yc);
+            ProfStop(PROF_ETIS);
+        }
+
+        ProfStart(PROF_CVODE);
+        flag = CVode(cvode_mem, tstop, CV_Yc, tc, CV_ONE_STEP_TSTOP);
+        ProfStop(PROF_CVODE);
+        if(flag < 0)
+        {
+            printf("\n  Fatal Error: CVode failed at t = %f min, flag = %d!\n", t0, flag);
+            exit(1);
+        }
+
+        /* a failed attempt made the step shorter: redo interception and snow over the step taken */
+        if(mData->ISMode == 0 && fabs(*tc - t0 - h) > 1E-6*h)
+        {
+            for(i=0; i<mData->NumEle; i++)
+            {
+                mData->EleIS[i] = mData->EleISSave[i];
+                mData->EleSnow[i] = mData->EleSnowSave[i];
+            }
+            ProfStart(PROF_ETIS);
+            calET_IS(t0, *tc - t0, mData, cData->Solver == 1 ? BandModelState(mData, CV_Yc) : CV_Yc);
+            ProfStop(PROF_ETIS);
+        }
+    }
+
+    return(flag);
+}
+
+
 void setTSDiCounter(Model_Data mData, realtype t)
 //! Function sets the marker of all the time series according to given time t
 /*! \param mData is pointer to model data structure
@@ -396,6 +672,9 @@ void setTSDiCounter(Model_Data mData, realtype t)
 
     int k;
 
+    /* Interpolation() starts its search at iCounter: values cached before the move are refreshed */
+    mData->Forc.valid = 0;
+
     for(k=0; k<mData->NumPrep; k++)
     {
         while(mData->TSD_Prep[k].iCounter < mData->TSD_Prep[k].length && t/(24.0*60.0) > mData->TSD_Prep[k].TS[mData->TSD_Prep[k].iCounter+1][0]){
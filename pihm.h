@@ -41,6 +41,9 @@
 //! Variable to store current time
 float Tsteps;                 /* Variable to store current time */
 
+//! Alignment (bytes) of the arrays used in the RHS hot loops: one cache line
+#define PIHM_ALIGN 64
+
 
 
 /*******************************************************************************/
@@ -62,6 +65,7 @@ typedef struct element_type
     realtype y;               /**< y of centroid                                 */
     realtype zmin;            /**< z_min of centroid                             */
     realtype zmax;            /**< z_max of centroid                             */
+    realtype AqDepth;         /**< Aquifer depth (zmax - zmin) of the element    */
     realtype NodeZmin;        /**< Z_min of any of the three nodes               */
     realtype NodeZmax;        /**< Z_max of any of the three nodes               */
     realtype NodeDist;        /**< Distance between Z_max and Z_min nodes        */
@@ -259,6 +263,282 @@ typedef struct TSD_type
 
 
 
+/* Data Structure of Static Geometry of an Element Edge */
+typedef struct edge_geom_type
+//! Data Structure of Static Geometry of an Element Edge :: built once in initialize.c
+{
+    int nabr;                 /**< neighbor index (0-based; -1: on boundary)      */
+    realtype length;          /**< Length of the edge                             */
+    realtype distance;        /**< Distance between centroids of the neighbors    */
+    realtype bddDist;         /**< Distance between circumcenter and the edge     */
+    realtype aqDepth;         /**< Aquifer depth of the element                   */
+    realtype nabrAqDepth;     /**< Aquifer depth of the neighbor                  */
+
+} edge_geom;
+
+
+
+/* Data Structure of Static Geometry of a River Segment */
+typedef struct riv_geom_type
+//! Data Structure of Static Geometry of a River Segment :: built once in initialize.c
+{
+    int left;                 /**< Left element (0-based; -1: none)               */
+    int right;                /**< Right element (0-based; -1: none)              */
+    int leftSlot;             /**< Edge of left element facing right element (-1) */
+    int rightSlot;            /**< Edge of right element facing left element (-1) */
+    realtype leftDist;        /**< Distance between segment and left element      */
+    realtype rightDist;       /**< Distance between segment and right element     */
+
+} riv_geom;
+
+
+
+/* Data Structure of an Interior Edge (face shared by two elements) */
+typedef struct face_type
+//! Data Structure of an Interior Edge :: each shared edge is listed once, built in initialize.c
+{
+    int owner;                /**< Owner element (0-based; lower index)           */
+    int nabr;                 /**< Neighbor element (0-based)                     */
+    int ownerSlot;            /**< Edge index of the face in the owner element    */
+    int nabrSlot;             /**< Edge index of the face in the neighbor element */
+
+} face;
+
+
+
+/* Calibration Parameters used during time stepping */
+typedef struct calib_param_type
+//! Calibration Parameters used during time stepping :: loaded once from calib.c in initialize.c
+{
+    /* RHS (f.c) */
+    realtype Vic;             /**< Fractional factor for Infiltration Capacity    */
+    realtype rivK;            /**< Conductivity factor at River-Element Interface */
+    realtype Kh;              /**< Horizontal Conductivity factor of Elements     */
+    realtype Rec;             /**< Groundwater Recharge factor                    */
+    realtype et2;             /**< ET2 factor                                     */
+    realtype et1;             /**< ET1 factor                                     */
+    realtype satThresh;       /**< Saturation above which macropores respond      */
+    realtype mpMultFH;        /**< Horizontal Conductivity factor of Macropores   */
+    realtype mpMultFV;        /**< Vertical Conductivity factor of Macropores     */
+    realtype mpArea;          /**< Fractional Area of Macropores                  */
+    realtype ovlThreshH;      /**< Overland depth for horizontal macropore flow   */
+    realtype ovlThreshV;      /**< Overland depth for vertical macropore flow     */
+    realtype rzd;             /**< Subtracted from Root Zone Depth                */
+
+    /* Interception & ET (et_is.c) */
+    realtype is;              /**< Maximum Interception Storage factor            */
+    realtype et0;             /**< ET0 factor                                     */
+    realtype mf;              /**< Melt Factor multiplier                         */
+    realtype tf;              /**< Throughfall factor                             */
+
+    /* Derived constants */
+    realtype mpSlopeH;        /**< mpMultFH/(1-satThresh)                         */
+    realtype mpSlopeV;        /**< mpMultFV/(1-satThresh)                         */
+    realtype tfCoeff;         /**< tf*5.65e-2: Throughfall coefficient            */
+
+} calib_param;
+
+
+
+/* Structure-of-Arrays View of Element Parameters */
+typedef struct ele_param_type
+//! Structure-of-Arrays View of Element Parameters :: read by f() and calET_IS(), built once in initialize.c
+{
+    realtype *block;          /**< Contiguous aligned storage of the arrays below */
+    realtype *zmin;           /**< z_min of centroid                              */
+    realtype *zmax;           /**< z_max of centroid                              */
+    realtype *AqDepth;        /**< Aquifer depth (zmax - zmin)                    */
+    realtype *area;           /**< Area of the element                            */
+    realtype *Ksat;           /**< Saturated Hydraulic Conductivity               */
+    realtype *Porosity;       /**< Porosity                                       */
+    realtype *Alpha;          /**< van Genuchten alpha                            */
+    realtype *Beta;           /**< van Genuchten exponent                         */
+    realtype *Sf;             /**< Friction Slope                                 */
+    realtype *RzD;            /**< Root Zone Depth                                */
+    realtype *Rough;          /**< Roughness (Manning's) Coefficient              */
+    realtype *LAImax;         /**< Maximum Leaf Area Index                        */
+    realtype *VegFrac;        /**< Vegitation Fraction                            */
+    realtype *Albedo;         /**< Albedo                                         */
+    realtype *Rs_ref;         /**< Reference Stomatal Resistance                  */
+    realtype *Rmin;           /**< Minimum Stomatal Resistance                    */
+    realtype *windH;          /**< Height at which Wind Velocity is measured      */
+    realtype *base;           /**< Base value of the soil type                    */
+
+    /* Parameters with calibration factors applied */
+    realtype *KsatH;          /**< Kh*Ksat: horizontal (element-element) Ksat     */
+    realtype *KsatInf;        /**< Ksat/Vic: infiltration capacity Ksat           */
+    realtype *KsatRec;        /**< Rec*Ksat: recharge Ksat                        */
+    realtype *RzBase;         /**< AqDepth-RzD-rzd: ET threshold of Sat+Unsat     */
+    realtype *et0Frac;        /**< et0/LAImax                                     */
+    realtype *et1Frac;        /**< et1*VegFrac/LAImax                             */
+    realtype *et2Frac;        /**< et2*(1-VegFrac)                                */
+    realtype *ISFactor;       /**< is*SIFactor: ISmax per unit LAI                */
+    realtype *Gamma;          /**< Psychrometric constant at the element height   */
+    int *Macropore;           /**< Macropore flag of the soil type                */
+
+} ele_param;
+
+
+
+/* Cross-section Geometry of a River Shape */
+typedef struct riv_xs_type
+//! Cross-section Geometry of a River Shape :: constants and depth tables built once by XSInit() in xsection.c
+{
+    int order;                /**< Interpolation order of the shape (1-4)         */
+    realtype coeff;           /**< Coefficient c of the bank profile              */
+    realtype k[4];            /**< Depth independent factors of the closed forms  */
+    int n;                    /**< Number of table intervals (0: closed forms)    */
+    realtype hmax;            /**< Depth covered by the table                     */
+    realtype rdu;             /**< n/sqrt(hmax): inverse of the step of sqrt(D)   */
+    realtype *block;          /**< Storage of the tables below [6*(n+1)]          */
+    realtype *A, *dA;         /**< Area and its slope in sqrt(D) at the nodes     */
+    realtype *P, *dP;         /**< Wetted Peremeter and its slope                 */
+    realtype *R, *dR;         /**< Hydraulic radius^(2/3) and its slope           */
+
+} riv_xs;
+
+
+
+/* Structure-of-Arrays View of River Segment Parameters */
+typedef struct riv_param_type
+//! Structure-of-Arrays View of River Segment Parameters :: shape/material resolved, built once in initialize.c
+{
+    realtype *block;          /**< Contiguous aligned storage of the arrays below */
+    realtype *zmin;           /**< Bed elevation                                  */
+    realtype *zmax;           /**< Bank elevation                                 */
+    realtype *depth;          /**< Max depth of the segment                       */
+    realtype *Length;         /**< Length of the segment                          */
+    realtype *coeff;          /**< Shape coefficient c in D = c*B/2               */
+    realtype *bed;            /**< Bed elevation of the shape                     */
+    realtype *Rough;          /**< Roughness (Manning's) Coefficient of material  */
+    realtype *Sf;             /**< Friction Slope of material                     */
+    realtype *Cwr;            /**< Discharge Coefficient of material              */
+    int *interpOrd;           /**< Interpolation order of the shape               */
+    riv_xs **xs;              /**< Cross-section geometry of the shape            */
+
+} riv_param;
+
+
+
+/* Forcing Values at a given Time, one entry per unique Time Series */
+typedef struct forcing_cache_type
+//! Forcing Values at a given Time :: each Time Series is interpolated once per time value by updateForcing() in f.c
+{
+    int valid;                /**< 0: has to be refilled before use               */
+    realtype t;               /**< Time (minutes) at which the values are valid   */
+    realtype *block;          /**< Contiguous storage of the arrays below         */
+    realtype *Prep;           /**< Precipitation [NumPrep]                        */
+    realtype *Temp;           /**< Temperature [NumTemp]                          */
+    realtype *Humidity;       /**< Relative Humidity [NumHumidity]                */
+    realtype *WindVel;        /**< Wind Velocity [NumWindVel]                     */
+    realtype *Rn;             /**< Net Radiation [NumRn]                          */
+    realtype *Pressure;       /**< Vapor Pressure [NumP]                          */
+    realtype *LAI;            /**< Leaf Area Index [NumLC]                        */
+    realtype *DH;             /**< Zero plane Displacement Height [NumLC]         */
+    realtype *MeltF;          /**< Melt Factor [NumMeltF]                         */
+
+} forcing_cache;
+
+
+
+/* State-independent Potential ET Terms, one entry per Element */
+typedef struct pet_cache_type
+//! Penman-Monteith Terms that depend on the forcing only :: refilled with the forcing cache by updatePET() in f.c
+{
+    realtype *block;          /**< Contiguous aligned storage of the arrays below */
+    realtype *Delta;          /**< Slope of the saturation vapor pressure curve   */
+    realtype *r_a;            /**< Aerodynamic resistance                         */
+    realtype *num;            /**< Radiation + aerodynamic numerator of ET0/1/2   */
+    realtype *et2;            /**< Evaporation from ground (state independent)    */
+    realtype *rsNum;          /**< Rmin*alpha_r: numerator of r_s                 */
+    realtype *eta4;           /**< eta_s^4: vapor pressure deficit factor of r_s  */
+
+} pet_cache;
+
+
+
+/* Data Structure of the Block-Jacobi Preconditioner */
+typedef struct precond_type
+//! Data Structure of the Preconditioner of I - gamma*J :: allocated in initialize.c, set up in precond.c
+{
+    realtype *EleJac;         /**< Vertical Jacobian blocks [9*NumEle], row major */
+    realtype *EleLU;          /**< LU factors of I - gamma*EleJac [9*NumEle]      */
+    int *ElePiv;              /**< Pivot rows of the LU factors [3*NumEle]        */
+    realtype *RivJac;         /**< Jacobian diagonal of segments [NumRiv]         */
+    realtype *RivDiag;        /**< 1 - gamma*RivJac [NumRiv]                      */
+    int *RivColor;            /**< Parity of the distance to the outlet [NumRiv]  */
+    realtype *ISJac;          /**< Jacobian diagonal of IS & snow [2*NumEle]      */
+    realtype *ISDiag;         /**< 1 - gamma*ISJac [2*NumEle] (ISMode 1)          */
+
+} precond;
+
+
+
+/* Data Structure of the Sparse Jacobian and its LU Factors */
+typedef struct sparse_jac_type
+//! Data Structure of the Sparse Newton Matrix :: pattern, coloring and envelope fixed in sparse.c at start-up
+{
+    int N;                    /**< Number of unknowns                             */
+    int *colPtr;              /**< Offsets into rowIdx/val per column [N+1]       */
+    int *rowIdx;              /**< Rows of the Jacobian pattern (CSC)             */
+    realtype *val;            /**< Finite difference Jacobian (CSC)               */
+    int NumColor;             /**< Number of colors (evaluations of f())          */
+    int *color;               /**< Color of each column [N]                       */
+    int *colorPtr;            /**< Offsets into colorCol per color [NumColor+1]   */
+    int *colorCol;            /**< Columns of each color                          */
+    int *perm;                /**< State at each position of the factorization    */
+    int *iperm;               /**< Position of each state in the factorization    */
+    int *first;               /**< First index of the envelope per row/column     */
+    long *envPtr;             /**< Offsets into L and U per row/column [N+1]      */
+    realtype *L;              /**< Unit lower factor, envelope rows               */
+    realtype *U;              /**< Upper factor, envelope columns                 */
+    realtype *D;              /**< Diagonal of the upper factor [N]               */
+
+} sparse_jac;
+
+
+
+/* Data Structure of the Banded Direct Solver */
+typedef struct band_jac_type
+//! Data Structure of the Banded Direct Solver (Solver 1) :: mesh ordering fixed in sparse.c at start-up
+{
+    int N;                    /**< Number of unknowns                             */
+    int bw;                   /**< Half-bandwidth of the Jacobian in the ordering */
+    int *perm;                /**< State at each position of the band [N]         */
+    N_Vector Y;               /**< States in the model ordering for f()           */
+    N_Vector Ydot;            /**< Rates in the model ordering from f()           */
+    N_Vector Ym;              /**< States in the model ordering for calET_IS()    */
+
+} band_jac;
+
+
+
+/* Dual Number of the Jacobian-times-vector Function */
+typedef struct dual_type
+//! Dual Number :: value and derivative along the vector v of J*v (jtimes.c)
+{
+    realtype v;               /**< Value                                          */
+    realtype d;               /**< Directional derivative                         */
+
+} dual;
+
+
+
+/* Data Structure of the Dual Workspace of Jtimes */
+typedef struct jtimes_work_type
+//! Data Structure of the Dual Workspace :: allocated once in jtimes.c, mirrors the workspace of f()
+{
+    dual *Y;                  /**< Bounded states [3*NumEle+NumRiv]               */
+    dual *DY;                 /**< Rates of change [3*NumEle+NumRiv]              */
+    dual *FluxSurf;           /**< Overland flux per element edge [3*NumEle]      */
+    dual *FluxSub;            /**< Subsurface flux per element edge [3*NumEle]    */
+    dual *FluxRiv;            /**< Flux of river segments [6*NumRiv]              */
+    int Check;                /**< 1: check the values against f() (Debug)       */
+
+} jtimes_work;
+
+
+
 /* Model Data Structure */
 typedef struct model_data_structure
 //! Model (PIHM) Data Structure
@@ -267,6 +547,12 @@ typedef struct model_data_structure
     int UnsatMode;               /**< Unsat Mode Identifier                       */
     int SurfMode;                /**< Surface Overland Mode Identifier            */
     int RivMode;                 /**< River Routing Mode Identifier               */
+    int ISMode;                  /**< 0: IS & snow in calET_IS 1: CVODE states    */
+    int XSTab;                   /**< 0: closed form cross-sections n: tables     */
+
+    /* RHS kernels specialized for the modes above: selected once by SetModeKernels() in f.c */
+    int (*EleFaces)(struct model_data_structure *, realtype *, realtype);     /**< Face fluxes of f(); # of NaN */
+    void (*DualEleFaces)(struct model_data_structure *);                     /**< Same in fDual() :: jtimes.c */
 
     /* Number of different model representation components */
     int NumEle;                  /**< Number of Elements in the model domain      */
@@ -315,9 +601,28 @@ typedef struct model_data_structure
 
     /* Attributes of River (linear) objects in the model domain */
     river_shape *Riv_Shape;      /**< River Shape Information                     */
+    riv_xs *RivXS;               /**< Cross-section geometry of each River Shape  */
     river_material *Riv_Mat;     /**< River Bank Material Information             */
     river_IC *Riv_IC;            /**< River Initial Condition                     */
 
+    /* Static geometry derived from the mesh */
+    edge_geom **EleEdge;         /**< Edge Geometry of Elements [NumEle][3]       */
+    riv_geom *RivGeom;           /**< Geometry of River Segs w.r.t. Elements      */
+    int NumFace;                 /**< Number of Interior Edges (shared faces)     */
+    face *Face;                  /**< Interior Edges: owner/neighbor slot map     */
+
+    /* River network derived from the .riv file */
+    int *RivUpPtr;               /**< Offsets into RivUp [NumRiv+1]               */
+    int *RivUp;                  /**< Upstream Segments of each Segment (CSR)     */
+    int RivOutlet;               /**< Segment whose outflow is reported as Q      */
+    int *EleRivPtr;              /**< Offsets into EleRiv [NumEle+1]              */
+    int *EleRiv;                 /**< Bank Segments: 2*segment+side (0 L, 1 R)    */
+
+    /* Structure-of-Arrays views of the parameters used in the hot loops */
+    ele_param EleP;              /**< Element Parameters (SoA)                    */
+    riv_param RivP;              /**< River Segment Parameters (SoA)              */
+    calib_param Cal;             /**< Calibration Parameters                      */
+
     /* Time Series Data in the model domain */
     TSD *TSD_Inc;                /**< Infiltration Capacity                       */
     TSD *TSD_LAI;                /**< Leaf Area Index Time Series Data            */
@@ -340,6 +645,14 @@ typedef struct model_data_structure
 
     TSD *TSD_Riv;                /**< River Related Time Series Data              */
 
+    forcing_cache Forc;          /**< Forcing interpolated at the current time    */
+    pet_cache PET;               /**< Potential ET terms at the forcing time      */
+
+    precond Prec;                /**< Block-Jacobi Preconditioner of CVSpgmr      */
+    sparse_jac Sparse;           /**< Sparse Newton Matrix of Solver 5            */
+    band_jac Band;               /**< Mesh ordering of the Band Solver 1          */
+    jtimes_work Jt;              /**< Dual Workspace of the exact J*v             */
+
     /* Storage for fluxes at Time = t */
     realtype **FluxSurf;         /**< Overland Flux between two elements          */
     realtype **FluxSub;          /**< Subsurface Flux between two elements        */
@@ -355,6 +668,14 @@ typedef struct model_data_structure
     realtype *EleISmax;          /**< Maximum Interception Storage Capacity       */
     realtype *EleTF;             /**< Rate of Through Fall                        */
     realtype **EleET;            /**< Rate of Evapo-Transpiration                 */
+
+    /* Persistent workspace of the RHS function f(): allocated once, never per call */
+    realtype *DummyY;            /**< Bounded copy of the state vector            */
+    realtype *DummyDY;           /**< Rate of change before unit conversion       */
+
+    /* Workspace of the one-step driver (Dense 1): IS and snow before a step, restored if CVODE shortens it */
+    realtype *EleISSave;         /**< Interception Storage at the start of a step */
+    realtype *EleSnowSave;       /**< Snow Storage at the start of a step         */
     realtype Q;
 
 } *Model_Data;
@@ -375,15 +696,19 @@ typedef struct control_data_structure
     int etis_out;                /**< 1: Yea 0: Nay                               */
 
     /* Solver Control Options */
-    int Solver;                  /**< Solver Type::                               */
+    int Solver;                  /**< 1:Band 2:SPGMR 3:SPBCG 4:SPTFQMR 5:Sparse   */
     realtype abstol;             /**< Absolute Tolerance                          */
     realtype reltol;             /**< Relative Tolerance                          */
     realtype InitStep;           /**< Initial step size                           */
     realtype MaxStep;            /**< Maximum absolute step size                  */
     realtype ETStep;             /**< Absolute step size for ET Computation       */
 
-    int GSType, MaxK;
-    realtype delt;
+    int GSType;                  /**< SPGMR only:: 1: Modified 2: Classical GS    */
+    int MaxK;                    /**< Max Krylov dimension (0: CVODE default)     */
+    realtype delt;               /**< Linear convergence factor (0: default)      */
+    int NumThreads;              /**< Threads used by f() (0: OpenMP default)     */
+    int Profile;                 /**< 0: off 1: summary 2: and per interval       */
+    int Dense;                   /**< 0: CV_NORMAL to every ETStep 1: CV_ONE_STEP */
 
     realtype StartTime;          /**< Simulation Start (Real) Time                */
     realtype EndTime;            /**< Simulation End (Real) Time                  */
@@ -394,6 +719,8 @@ typedef struct control_data_structure
     realtype b;                  /**< Base Step Size                              */
     int NumSteps;                /**< Number of Step to be taken by CVode         */
     realtype *Tout;              /**< Array of Time at which State is computed    */
+    int NumBreak;                /**< Number of forcing breakpoints               */
+    realtype *Tbreak;            /**< Sorted breakpoints of all forcing TS (min)  */
 
 } Control_Data;
 
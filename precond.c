@@ -0,0 +1,438 @@
+/*******************************************************************************
+ * File        : precond.c                                                     *
+ * Function    : block-Jacobi preconditioner of the Newton matrix for CVSpgmr  *
+ * Programmers : Yizhong Qu   @ Pennsylvania State Univeristy                  *
+ *               Mukesh Kumar @ Pennsylvania State Univeristy                  *
+ *               Gopal Bhatt  @ Pennsylvania State Univeristy                  *
+ * Version     : 2.0 (July 10, 2007)                                           *
+ *-----------------------------------------------------------------------------*
+ *                                                                             *
+ * CVODE solves (I - gamma*J) x = b in every Newton iteration. The stiffest    *
+ * couplings of PIHM are local: the surface, unsaturated and saturated storage *
+ * of an element exchange water through infiltration, recharge and ET, and a   *
+ * river segment is dominated by its own outflow. The preconditioner keeps     *
+ *   1. a 3x3 block per element, from finite differences of the vertical terms *
+ *      of f() (EleVertical and EleRecharge), factored by LU with pivoting;    *
+ *   2. the diagonal entry of every river segment, from finite differences of  *
+ *      f() in which all segments of one color are perturbed at once. Segments *
+ *      of equal color never drain into each other, so two evaluations of f()  *
+ *      give the exact diagonal.                                               *
+ * Lateral coupling between elements is left to the Krylov iteration.          *
+ * With interception and snow as states (ISMode 1) their diagonal is added:    *
+ * each store depends on itself only, so one evaluation of f() gives it.       *
+ *                                                                             *
+ * This code is free for users with research purpose only, if appropriate      *
+ * citation is refered. However, there is no warranty in any format for this   *
+ * product.                                                                    *
+ *                                                                             *
+ * For questions or comments, please contact the authors of the reference.     *
+ * One who want to use it for other consideration may also contact Dr.Duffy    *
+ * at cxd11@psu.edu.                                                           *
+ *******************************************************************************/
+
+//! @file precond.c Block-Jacobi preconditioner (setup and solve) registered through CVSpils
+
+/*    C Header Files    */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+/*    SUNDIALS Header Files    */
+#include "nvector_serial.h"
+#include "sundials_types.h"
+
+/*    PIHM Header Files    */
+#include "pihm.h"
+#include "stats.h"
+
+#define ABS_TOL    1E-4		/**< Bound of the states as used in f()              */
+
+/*    Function Declarations    */
+void EleVertical(Model_Data MD, int i, realtype *y, realtype *dy, realtype *et, realtype *vic);
+realtype EleRecharge(Model_Data MD, int i, realtype *y);
+void EleRate(Model_Data MD, int i, realtype *y, realtype *rate);
+int LUFactor3(realtype *a, int *piv);
+void LUSolve3(realtype *a, int *piv, realtype *b);
+void PrecondIS(realtype t, N_Vector CV_Y, N_Vector CV_F, Model_Data MD, N_Vector tmp1, N_Vector tmp2);
+int PrecondISFactor(Model_Data MD, realtype gamma);
+void PrecondISSolve(Model_Data MD, realtype *R, realtype *Z);
+
+
+
+/*******************************************************************************
+*    Preconditioner Setup
+********************************************************************************/
+int Precond(realtype t, N_Vector CV_Y, N_Vector CV_F, booleantype jok, booleantype *jcurPtr,
+            realtype gamma, void *DS, N_Vector tmp1, N_Vector tmp2, N_Vector tmp3)
+//! Function evaluates (unless jok) the Jacobian blocks and factors I - gamma*J
+/*! \param t is the time of simulation
+    \param CV_Y is state variable vector
+    \param CV_F is f(t, CV_Y)
+    \param jok is TRUE if the saved Jacobian blocks may be reused
+    \param jcurPtr is set to TRUE if the Jacobian blocks were re-evaluated
+    \param gamma is the scalar of the Newton matrix I - gamma*J
+    \param DS is pointer to model data structure
+    \param tmp1 tmp2 tmp3 are work vectors of CVODE
+*/
+{
+    int i, j, k, c, singular;
+    realtype srur, inc;
+    realtype y[3], yp[3], rate[3], ratep[3];
+    realtype *Y, *F, *YP, *FP, *J, *A;
+    Model_Data MD;
+
+    MD = (Model_Data) DS;
+    Y = NV_DATA_S(CV_Y);
+    F = NV_DATA_S(CV_F);
+    srur = sqrt(UNIT_ROUNDOFF);
+
+    if(jok == FALSE)
+    {
+        /* element blocks: vertical terms depend on the three states of the element only */
+        #pragma omp parallel for private(j,k,c,inc,y,yp,rate,ratep,J)
+        for(i=0; i<MD->NumEle; i++)
+        {
+            /* same bounds as in f() */
+            for(k=0; k<3; k++)
+            {
+                y[k] = Y[i+k*MD->NumEle] <= ABS_TOL ? 0 : Y[i+k*MD->NumEle];
+            }
+            if(y[1] > MD->EleP.AqDepth[i])
+            {
+                y[1] = MD->EleP.AqDepth[i];
+            }
+            if(y[2] > MD->EleP.AqDepth[i])
+            {
+                y[2] = MD->EleP.AqDepth[i];
+            }
+            if(y[1] + y[2] > MD->EleP.AqDepth[i])
+            {
+                if(y[1] < MD->EleP.AqDepth[i])
+                {
+                    y[1] = MD->EleP.AqDepth[i] - y[2];
+                }
+                else
+                {
+                    y[2] = 0.0;
+                }
+            }
+
+            EleRate(MD, i, y, rate);
+            J = &MD->Prec.EleJac[9*i];
+            for(c=0; c<3; c++)
+            {
+                /* states are water depths in m; step back from the top of the aquifer */
+                inc = srur*(y[c] > 1.0 ? y[c] : 1.0);
+                if(c > 0 && y[c] + inc > MD->EleP.AqDepth[i])
+                {
+                    inc = -inc;
+                }
+                for(k=0; k<3; k++)
+                {
+                    yp[k] = y[k];
+                }
+                yp[c] = y[c] + inc;
+                EleRate(MD, i, yp, ratep);
+                for(j=0; j<3; j++)
+                {
+                    J[3*j+c] = (ratep[j] - rate[j])/inc;
+                }
+            }
+        }
+
+        /* river diagonal: one evaluation of f() per color */
+        YP = NV_DATA_S(tmp1);
+        FP = NV_DATA_S(tmp2);
+        for(c=0; c<2; c++)
+        {
+            N_VScale(1.0, CV_Y, tmp1);
+            for(i=0; i<MD->NumRiv; i++)
+            {
+                if(MD->Prec.RivColor[i] == c)
+                {
+                    k = i + 3*MD->NumEle;
+                    MD->Prec.RivJac[i] = srur*(fabs(Y[k]) > 1.0 ? fabs(Y[k]) : 1.0);
+                    YP[k] = Y[k] + MD->Prec.RivJac[i];
+                }
+            }
+            fProf(t, tmp1, tmp2, MD);
+            for(i=0; i<MD->NumRiv; i++)
+            {
+                if(MD->Prec.RivColor[i] == c)
+                {
+                    k = i + 3*MD->NumEle;
+                    MD->Prec.RivJac[i] = (FP[k] - F[k])/MD->Prec.RivJac[i];
+                }
+            }
+        }
+        if(MD->ISMode == 1)
+        {
+            PrecondIS(t, CV_Y, CV_F, MD, tmp1, tmp2);
+        }
+        /* leave the fluxes stored by f() consistent with CV_Y */
+        fProf(t, CV_Y, tmp2, MD);
+
+        *jcurPtr = TRUE;
+    }
+    else
+    {
+        *jcurPtr = FALSE;
+    }
+
+    /* factor I - gamma*J */
+    singular = 0;
+    #pragma omp parallel for private(k,J,A) reduction(+:singular)
+    for(i=0; i<MD->NumEle; i++)
+    {
+        J = &MD->Prec.EleJac[9*i];
+        A = &MD->Prec.EleLU[9*i];
+        for(k=0; k<9; k++)
+        {
+            A[k] = -gamma*J[k];
+        }
+        A[0] = A[0] + 1.0;
+        A[4] = A[4] + 1.0;
+        A[8] = A[8] + 1.0;
+        singular = singular + LUFactor3(A, &MD->Prec.ElePiv[3*i]);
+    }
+    for(i=0; i<MD->NumRiv; i++)
+    {
+        MD->Prec.RivDiag[i] = 1.0 - gamma*MD->Prec.RivJac[i];
+        if(fabs(MD->Prec.RivDiag[i]) < UNIT_ROUNDOFF)
+        {
+            singular++;
+        }
+    }
+    if(MD->ISMode == 1)
+    {
+        singular = singular + PrecondISFactor(MD, gamma);
+    }
+
+    /* a positive return value lets CVODE retry with a smaller step */
+    return(singular > 0 ? 1 : 0);
+}
+
+
+/*******************************************************************************
+*    Preconditioner Solve
+********************************************************************************/
+int PSolve(realtype t, N_Vector CV_Y, N_Vector CV_F, N_Vector CV_R, N_Vector CV_Z,
+           realtype gamma, realtype delta, int lr, void *DS, N_Vector tmp)
+//! Function solves P z = r with the factors computed in Precond()
+/*! \param t is the time of simulation
+    \param CV_Y is state variable vector
+    \param CV_F is f(t, CV_Y)
+    \param CV_R is the right hand side r
+    \param CV_Z is the solution z
+    \param gamma is the scalar of the Newton matrix I - gamma*J
+    \param delta is the tolerance of an iterative solve (not used: the solve is direct)
+    \param lr is 1 for left and 2 for right preconditioning
+    \param DS is pointer to model data structure
+    \param tmp is a work vector of CVODE
+*/
+{
+    int i, k;
+    realtype b[3];
+    realtype *R, *Z;
+    Model_Data MD;
+
+    MD = (Model_Data) DS;
+    R = NV_DATA_S(CV_R);
+    Z = NV_DATA_S(CV_Z);
+
+    #pragma omp parallel for private(k,b)
+    for(i=0; i<MD->NumEle; i++)
+    {
+        for(k=0; k<3; k++)
+        {
+            b[k] = R[i+k*MD->NumEle];
+        }
+        LUSolve3(&MD->Prec.EleLU[9*i], &MD->Prec.ElePiv[3*i], b);
+        for(k=0; k<3; k++)
+        {
+            Z[i+k*MD->NumEle] = b[k];
+        }
+    }
+    for(i=0; i<MD->NumRiv; i++)
+    {
+        Z[i+3*MD->NumEle] = R[i+3*MD->NumEle]/MD->Prec.RivDiag[i];
+    }
+    if(MD->ISMode == 1)
+    {
+        PrecondISSolve(MD, R, Z);
+    }
+
+    return(0);
+}
+
+
+void PrecondIS(realtype t, N_Vector CV_Y, N_Vector CV_F, Model_Data MD, N_Vector tmp1, N_Vector tmp2)
+//! Function evaluates the Jacobian diagonal of interception and snow storage (ISMode 1) with one evaluation of f()
+/*! \param t is the time of simulation
+    \param CV_Y is state variable vector
+    \param CV_F is f(t, CV_Y)
+    \param MD is pointer to model data structure
+    \param tmp1 tmp2 are work vectors of CVODE
+*/
+{
+    int i, k;
+    realtype srur, *Y, *F, *YP, *FP;
+
+    Y = NV_DATA_S(CV_Y);
+    F = NV_DATA_S(CV_F);
+    YP = NV_DATA_S(tmp1);
+    FP = NV_DATA_S(tmp2);
+    srur = sqrt(UNIT_ROUNDOFF);
+
+    /* the rate of a store depends on that store only: all of them are perturbed at once */
+    N_VScale(1.0, CV_Y, tmp1);
+    for(i=0; i<2*MD->NumEle; i++)
+    {
+        k = i + 3*MD->NumEle + MD->NumRiv;
+        MD->Prec.ISJac[i] = srur*(fabs(Y[k]) > 1.0 ? fabs(Y[k]) : 1.0);
+        YP[k] = Y[k] + MD->Prec.ISJac[i];
+    }
+    fProf(t, tmp1, tmp2, MD);
+    for(i=0; i<2*MD->NumEle; i++)
+    {
+        k = i + 3*MD->NumEle + MD->NumRiv;
+        MD->Prec.ISJac[i] = (FP[k] - F[k])/MD->Prec.ISJac[i];
+    }
+}
+
+
+int PrecondISFactor(Model_Data MD, realtype gamma)
+//! Function sets the diagonal 1 - gamma*J of interception and snow storage; returns the number of vanishing entries
+/*! \param MD is pointer to model data structure
+    \param gamma is the scalar of the Newton matrix I - gamma*J
+*/
+{
+    int i, singular;
+
+    singular = 0;
+    for(i=0; i<2*MD->NumEle; i++)
+    {
+        MD->Prec.ISDiag[i] = 1.0 - gamma*MD->Prec.ISJac[i];
+        if(fabs(MD->Prec.ISDiag[i]) < UNIT_ROUNDOFF)
+        {
+            singular++;
+        }
+    }
+    return(singular);
+}
+
+
+void PrecondISSolve(Model_Data MD, realtype *R, realtype *Z)
+//! Function solves the diagonal part of P z = r that belongs to interception and snow storage
+/*! \param MD is pointer to model data structure
+    \param R is the right hand side r
+    \param Z is the solution z
+*/
+{
+    int i, k;
+
+    for(i=0; i<2*MD->NumEle; i++)
+    {
+        k = i + 3*MD->NumEle + MD->NumRiv;
+        Z[k] = R[k]/MD->Prec.ISDiag[i];
+    }
+}
+
+
+void EleRate(Model_Data MD, int i, realtype *y, realtype *rate)
+//! Function evaluates the vertical part of f() for the three states of element i (per minute, like f())
+/*! \param MD is pointer to model data structure
+    \param i is the index of the element
+    \param y is the bounded state of the element: surface, unsaturated and saturated storage
+    \param rate is the rate of change of the three states (output)
+*/
+{
+    realtype dy[3], et[3], vic, recharge;
+
+    EleVertical(MD, i, y, dy, et, &vic);
+    recharge = EleRecharge(MD, i, y);
+
+    rate[0] = dy[0]/(60.0*24.0);
+    rate[1] = (dy[1] + recharge)/MD->EleP.Porosity[i]/(60.0*24.0);
+    rate[2] = (dy[2] - recharge)/MD->EleP.Porosity[i]/(60.0*24.0);
+}
+
+
+int LUFactor3(realtype *a, int *piv)
+//! Function factors a row major 3x3 matrix in place by LU with partial pivoting; returns 1 if singular
+/*! \param a is the matrix, overwritten by its L (unit diagonal) and U factors
+    \param piv is the pivot row of each column (output)
+*/
+{
+    int i, j, k, p;
+    realtype tmp;
+
+    for(k=0; k<3; k++)
+    {
+        p = k;
+        for(i=k+1; i<3; i++)
+        {
+            if(fabs(a[3*i+k]) > fabs(a[3*p+k]))
+            {
+                p = i;
+            }
+        }
+        piv[k] = p;
+        if(a[3*p+k] == 0.0)
+        {
+            return(1);
+        }
+        if(p != k)
+        {
+            for(j=0; j<3; j++)
+            {
+                tmp = a[3*k+j];
+                a[3*k+j] = a[3*p+j];
+                a[3*p+j] = tmp;
+            }
+        }
+        for(i=k+1; i<3; i++)
+        {
+            a[3*i+k] = a[3*i+k]/a[3*k+k];
+            for(j=k+1; j<3; j++)
+            {
+                a[3*i+j] = a[3*i+j] - a[3*i+k]*a[3*k+j];
+            }
+        }
+    }
+    return(0);
+}
+
+
+void LUSolve3(realtype *a, int *piv, realtype *b)
+//! Function solves a x = b with the factors of LUFactor3(); b is overwritten by x
+/*! \param a is the LU factors
+    \param piv is the pivot rows
+    \param b is the right hand side on entry and the solution on return
+*/
+{
+    int i, j;
+    realtype tmp;
+
+    for(i=0; i<3; i++)
+    {
+        if(piv[i] != i)
+        {
+            tmp = b[i];
+            b[i] = b[piv[i]];
+            b[piv[i]] = tmp;
+        }
+        for(j=0; j<i; j++)
+        {
+            b[i] = b[i] - a[3*i+j]*b[j];
+        }
+    }
+    for(i=2; i>=0; i--)
+    {
+        for(j=i+1; j<3; j++)
+        {
+            b[i] = b[i] - a[3*i+j]*b[j];
+        }
+        b[i] = b[i]/a[3*i+i];
+    }
+}
@@ -7,6 +7,9 @@
  * Version     : 2.0 (July 10, 2007)                                           *
  *-----------------------------------------------------------------------------*
  *                                                                             *
+ * Which variables are printed, their averaging intervals and file formats are *
+ * read at run time from <filename>.out (see print.c). The defaults below      *
+ * apply to every variable if there is no .out file.                           *
  *                                                                             *
  * This code is free for users with research purpose only, if appropriate      *
  * citation is refered. However, there is no warranty in any format for this   *
@@ -17,7 +20,7 @@
  * at cxd11@psu.edu.                                                           *
  *******************************************************************************/
 
-//! @file print.h define output file mode and which output paramater to print. Also, corresponding function declaration
+//! @file print.h output variable identifiers, defaults of the output control and function declarations of print.c
 
 /*    File Print Mode identifiers    */
 #define TXT            1        /**< TXT is read as 1 */
@@ -29,90 +32,37 @@
 
 
 /************************/
-/* 1=> .txt Files       */
-/* 2=> .netcdf Files    */
+/* Output Variables     */
 /************************/
-#define FPRINT_MODE    CDF		/**< Specify output file mode: 1=.txt; 2=.nc */
+#define OUT_IS         0        /**< Interception storage state          */
+#define OUT_SAT        1        /**< Saturated zone state                */
+#define OUT_USAT       2        /**< Unsaturated zone state              */
+#define OUT_SURF       3        /**< Surface state                       */
+#define OUT_ET0        4        /**< Evaporation rate from canopy        */
+#define OUT_ET1        5        /**< Transpiration rate (ET1)            */
+#define OUT_ET2        6        /**< Evaporation rate from ground (ET2)  */
+#define OUT_NETPPT     7        /**< Net precipitation rate              */
+#define OUT_INFIL      8        /**< Infiltration rate                   */
+#define OUT_RECHARGE   9        /**< Recharge rate to ground water       */
+#define OUT_RIVHEAD    10       /**< Head of river segments              */
+#define OUT_RIVFLOW    11       /**< Outflow from river segments         */
+#define OUT_RIVBASE    12       /**< Baseflow to river segments          */
+#define OUT_RIVSURF    13       /**< Surface flow to river segments      */
+#define OUT_NUM        14       /**< Number of output variables          */
 
 
-//////////////////////////////////
-#define ISState        YEA      /**< Output interception storage state? YEA:NAY */
-#define SatState       YEA      /**< Output staturated zone state? YEA:NAY      */
-#define UsatState      YEA      /**< Output unsaturated zone state? YEA:NAY     */
-#define SurfState      YEA      /**< Output surface state? YEA:NAY              */
-
-#define ISStateT       60       /**< Output mean interception storage at _ minute intervel   */
-#define SatStateT      60       /**< Output mean saturated zone state at _ minute intervel   */
-#define UsatStateT     60       /**< Output mean unsaturated zone state at _ minute intervel */
-#define SurfStateT     60       /**< Output mean surface state at _ minute intervel          */
-//////////////////////////////////
-#define ET0            YEA      /**< Output evaporation rate from cannopy? YEA:NAY */
-#define ET1            YEA      /**< Output ET1? YEA:NAY                           */
-#define ET2            YEA      /**< Output ET2? YEA:NAY                           */
-#define NetPpt         YEA      /**< Output net precipitation rate? YEA:NAY        */
-#define Infil          YEA      /**< Output infiltration rate? YEA:NAY             */
-#define RECHARGE       YEA      /**< Output recharge rate to ground water? YEA:NAY */
-
-#define ET0T           60       /**< Output mean evaporation rate from cannopy at _ minute intervel   */
-#define ET1T           60       /**< Output mean et1 at _ minute intervel                             */
-#define ET2T           60       /**< Output mean et2 at _ minute intervel                             */
-#define NetPptT        60       /**< Output mean net precipitation rate at _ minute intervel          */
-#define InfilT         60       /**< Output infiltration rate at _ minute intervel                    */
-#define RECHARGET      60       /**< Output recharge rate to groundwater at _ minute intervel         */
-//////////////////////////////////
-#define RivHead        YEA      /**< Output head of river segments? YEA:NAY */
-
-#define RivHeadT       60       /**< Output river head at _ minute intervel         */
-//////////////////////////////////
-#define RivFlow        YEA      /**< Output outflow from river segments? YEA:NAY   */
-#define RivBase        YEA      /**< Output baseflow to river segments? YEA:NAY    */
-#define RivSurf        YEA      /**< Output surfaceflow to river segments? YEA:NAY */
-
-#define RivFlowT       60       /**< Output outflow from river segments at _ minute intervel   */
-#define RivBaseT       60       /**< Output baseflow to river segments at _ minute intervel    */
-#define RivSurfT       60       /**< Output surfaceflow to river segments at _ minute intervel */
-//////////////////////////////////
-#define FluxSurf       YEA
-#define FluxSat        YEA
-
-#define FluxSurfT      60
-#define FluxSatT       60
-//////////////////////////////////
+/************************/
+/* Defaults of .out     */
+/************************/
+#define OUT_DEFAULT_PRINT   YEA      /**< Print a variable without .out? YEA:NAY                   */
+#define OUT_DEFAULT_T       60       /**< Output mean values without .out at _ minute intervel     */
+#define OUT_DEFAULT_MODE    CDF      /**< File mode without .out: 1=.txt; 2=.nc                    */
+#define OUT_SLOTS           32       /**< Snapshot buffers queued to the writer thread without .out; 0: write in FPrint() */
 
 
 /* Function Prototypes */
-void FPrintInit(Model_Data);                                        /* Initialize variables for FPrint           */
-
-void printIS(Model_Data, FILE *, realtype);                         /* Print Interception Storage in TXT mode    */
-void printIScdf(Model_Data, int, int, realtype);                    /* Print Interception Storage in CDF mode    */
-
-void printSatState(Model_Data, N_Vector, FILE *, realtype);         /* Print Saturated State in TXT mode         */
-void printSatStatecdf(Model_Data, N_Vector, int, int, realtype);    /* Print Saturated State in CDF mode         */
-void printUsatState(Model_Data, N_Vector, FILE *, realtype);        /* Print Unsaturated State in TXT mode       */
-void printUsatStatecdf(Model_Data, N_Vector, int, int, realtype);   /* Print Unsaturated State in CDF mode       */
-void printSurfState(Model_Data, N_Vector, FILE *, realtype);        /* Print Overland State in TXT mode          */
-void printSurfStatecdf(Model_Data, N_Vector, int, int, realtype);   /* Print Overland State in CDF mode          */
-
-void printET0(Model_Data, FILE *, realtype);                        /* Print Evaporation from Veg in TXT mode    */
-void printET0cdf(Model_Data, int, int, realtype);                   /* Print Evaporation from Veg in CDF mode    */
-void printET1(Model_Data, FILE *, realtype);                        /* Print Evaporation from Sur in TXT mode    */
-void printET1cdf(Model_Data, int, int, realtype);                   /* Print Evaporation from Sur in CDF mode    */
-void printET2(Model_Data, FILE *, realtype);                        /* Print Evaporation from Grd in TXT mode    */
-void printET2cdf(Model_Data, int, int, realtype);                   /* Print Evaporation from Grd in CDF mode    */
-void printNetPpt(Model_Data, FILE *, realtype);                     /* Print Net Precipitation in TXT mode       */
-void printNetPptcdf(Model_Data, int, int, realtype);                /* Print Net Precipitation in CDF mode       */
-void printInfil(Model_Data, FILE *, realtype);                      /* Print Variable Infiltration in TXT mode   */
-void printInfilcdf(Model_Data, int, int, realtype);                 /* Print Variable Infiltration in CDF mode   */
-void printRecharge(Model_Data, FILE *, realtype);                   /* Print Recharge to GW in TXT mode          */
-void printRechargecdf(Model_Data, int, int, realtype);              /* Print Recharge to GW in CDF mode          */
-
-void printRiverFlow(Model_Data, N_Vector, FILE *, realtype);        /* Print outflow from river segin TXT mode   */
-void printRiverFlowcdf(Model_Data, N_Vector, int, int, realtype);   /* Print outflow from river segin CDF mode   */
-void printRiverBase(Model_Data, FILE *, realtype);                  /* Print Base flow to river seg in TXT mode  */
-void printRiverBasecdf(Model_Data, int, int, realtype);             /* Print Base flow to river seg in CDF mode  */
-void printRiverSurf(Model_Data, FILE *, realtype);                  /* Print over flow to river seg in TXT mode  */
-void printRiverSurfcdf(Model_Data, int, int, realtype);             /* Print over flow to river seg in CDF mode  */
-void printRiverHead(Model_Data, N_Vector, FILE *, realtype);        /* Print River State in TXT mode             */
-void printRiverHeadcdf(Model_Data, N_Vector, int, int, realtype);   /* Print River State in CDF mode             */
-
-void FPrintCloseAll(void);
+void FPrintInit(Model_Data, realtype);                              /* Read .out, open files, allocate the means */
+void FPrint(Model_Data, N_Vector, realtype);                        /* Accumulate and print the output variables */
+realtype FPrintNextTime(realtype);                                  /* Next interval boundary of the output      */
+void FPrintInitFile(Model_Data, Control_Data, N_Vector, int);       /* Print the .init.end file                  */
+void FPrintCloseAll(void);                                          /* Write the queued records, close the files */
@@ -709,7 +709,15 @@ void read_alloc(char *filename, Model_Data DS, Control_Data *CS)
     //fscanf(para_file, "%d %d %d %d", &CS->res_out, &CS->flux_out, &CS->q_out, &CS->etis_out);
     fscanf(para_file, "%d %d %d", &DS->UnsatMode, &DS->SurfMode, &DS->RivMode);
     fscanf(para_file, "%d", &CS->Solver);
-    if(CS->Solver == 2) //TODO : Needs Correction !!!
+    if(CS->Solver < 1 || CS->Solver > 5)
+    {
+        printf("\n  Fatal Error: Solver %d in %s.para is not 1 (Band), 2 (SPGMR), 3 (SPBCG), 4 (SPTFQMR) or 5 (Sparse)!\n", CS->Solver, filename);
+        exit(1);
+    }
+    CS->GSType = 1;
+    CS->MaxK = 0;
+    CS->delt = 0.0;
+    if(CS->Solver >= 2)         /* Krylov solvers (5: SPGMR on the sparse LU) */
     {
         fscanf(para_file, "%d %d %lf", &CS->GSType, &CS->MaxK, &CS->delt);
     }
@@ -720,6 +728,27 @@ void read_alloc(char *filename, Model_Data DS, Control_Data *CS)
     {
         fscanf(para_file, "%lf %lf", &CS->a, &CS->b);
     }
+    /* optional trailing entries: threads used by f(), run-time profile, driver mode, IS mode and cross-section tables; absent in older .para files */
+    if(fscanf(para_file, "%d", &CS->NumThreads) != 1 || CS->NumThreads < 0)
+    {
+        CS->NumThreads = 0;
+    }
+    if(fscanf(para_file, "%d", &CS->Profile) != 1 || CS->Profile < 0 || CS->Profile > 2)
+    {
+        CS->Profile = 0;
+    }
+    if(fscanf(para_file, "%d", &CS->Dense) != 1 || CS->Dense != 1)
+    {
+        CS->Dense = 0;
+    }
+    if(fscanf(para_file, "%d", &DS->ISMode) != 1 || DS->ISMode != 1)
+    {
+        DS->ISMode = 0;
+    }
+    if(fscanf(para_file, "%d", &DS->XSTab) != 1 || DS->XSTab < 0)
+    {
+        DS->XSTab = 0;
+    }
 
     if(CS->a != 1.0)
     {
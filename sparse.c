@@ -0,0 +1,816 @@
+/*******************************************************************************
+ * File        : sparse.c                                                      *
+ * Function    : sparse finite difference Jacobian and sparse LU of the Newton *
+ *               matrix (Solver 5)                                             *
+ * Programmers : Yizhong Qu   @ Pennsylvania State Univeristy                  *
+ *               Mukesh Kumar @ Pennsylvania State Univeristy                  *
+ *               Gopal Bhatt  @ Pennsylvania State Univeristy                  *
+ * Version     : 2.0 (July 10, 2007)                                           *
+ *-----------------------------------------------------------------------------*
+ *                                                                             *
+ * The Jacobian of f() is fixed in structure by the mesh: an element couples   *
+ * its three layers, its neighbors (Ele[].nabr) and the river segments on its  *
+ * banks (Riv[].LeftEle/RightEle); a segment couples its bank elements and the *
+ * segments up- and downstream (Riv[].down). At start-up                       *
+ *   1. the pattern is derived from these links;                               *
+ *   2. the columns are distance-2 colored: columns of one color share no row, *
+ *      so one evaluation of f() per color gives all their entries;            *
+ *   3. the unknowns are ordered by reverse Cuthill-McKee over the mesh, the   *
+ *      layers of an element kept together, and the envelope of the LU factors *
+ *      is fixed once (symbolic factorization).                                *
+ * Each setup then evaluates the Jacobian (unless CVODE allows reuse) and      *
+ * refactors I - gamma*J within the fixed envelope. The factors are used as    *
+ * preconditioner of CVSpgmr, so GMRES converges in one or two iterations:     *
+ * a direct Newton solve through the CVSpils interface, since SUNDIALS 2.2.0   *
+ * has no sparse direct linear solver.                                         *
+ *                                                                             *
+ * The banded direct solver (Solver 1) works in the same ordering: CVBand      *
+ * integrates the states permuted by reverse Cuthill-McKee, in which the       *
+ * half-bandwidth spans a few rows of elements instead of the 3*NumEle of the  *
+ * state vector stored layer by layer. fBand() permutes the states and rates   *
+ * around f(); the driver keeps the model ordering (BandToModel()).            *
+ *                                                                             *
+ * This code is free for users with research purpose only, if appropriate      *
+ * citation is refered. However, there is no warranty in any format for this   *
+ * product.                                                                    *
+ *                                                                             *
+ * For questions or comments, please contact the authors of the reference.     *
+ * One who want to use it for other consideration may also contact Dr.Duffy    *
+ * at cxd11@psu.edu.                                                           *
+ *******************************************************************************/
+
+//! @file sparse.c Colored finite difference Jacobian and envelope LU of the Newton matrix
+
+/*    C Header Files    */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+/*    SUNDIALS Header Files    */
+#include "nvector_serial.h"
+#include "sundials_types.h"
+
+/*    PIHM Header Files    */
+#include "pihm.h"
+#include "stats.h"
+
+/*    Function Declarations    */
+void PrecondIS(realtype t, N_Vector CV_Y, N_Vector CV_F, Model_Data MD, N_Vector tmp1, N_Vector tmp2);
+int PrecondISFactor(Model_Data MD, realtype gamma);
+void PrecondISSolve(Model_Data MD, realtype *R, realtype *Z);
+void *alignedMalloc(size_t size);
+void SparseInit(Model_Data MD);
+void BandInit(Model_Data MD, int N);
+int fBand(realtype t, N_Vector CV_Yb, N_Vector CV_Ydotb, void *DS);
+void BandToModel(Model_Data MD, N_Vector CV_Yb, N_Vector CV_Y);
+void BandFromModel(Model_Data MD, N_Vector CV_Y, N_Vector CV_Yb);
+N_Vector BandModelState(Model_Data MD, N_Vector CV_Yb);
+int SparsePrecond(realtype t, N_Vector CV_Y, N_Vector CV_F, booleantype jok, booleantype *jcurPtr,
+                  realtype gamma, void *DS, N_Vector tmp1, N_Vector tmp2, N_Vector tmp3);
+int SparsePSolve(realtype t, N_Vector CV_Y, N_Vector CV_F, N_Vector CV_R, N_Vector CV_Z,
+                 realtype gamma, realtype delta, int lr, void *DS, N_Vector tmp);
+
+
+
+/*******************************************************************************
+*    Node Graph of the Mesh and its Ordering
+********************************************************************************/
+static void MeshGraph(Model_Data MD, int **pPtr, int **pAdj)
+//! Function builds the adjacency lists of the nodes (elements, then river segments) coupled in f()
+/*! \param MD is pointer to model data structure
+    \param pPtr is set to the offsets into the lists per node [NumNode+1]
+    \param pAdj is set to the adjacent nodes of every node, the node itself included
+*/
+{
+    int i, k, NumNode;
+    int *nodePtr, *nodeAdj, *count;
+
+    NumNode = MD->NumEle + MD->NumRiv;
+
+    /* node graph: elements [0,NumEle), segments [NumEle,NumNode); every list holds the node itself */
+    nodePtr = (int *)malloc((NumNode+1)*sizeof(int));
+    count = (int *)malloc((NumNode+1)*sizeof(int));
+    for(i=0; i<=NumNode; i++)
+    {
+        nodePtr[i] = 0;
+    }
+    for(i=0; i<NumNode; i++)
+    {
+        nodePtr[i+1]++;
+    }
+    for(k=0; k<MD->NumFace; k++)
+    {
+        nodePtr[MD->Face[k].owner+1]++;
+        nodePtr[MD->Face[k].nabr+1]++;
+    }
+    for(i=0; i<MD->NumRiv; i++)
+    {
+        if(MD->RivGeom[i].left >= 0)
+        {
+            nodePtr[MD->RivGeom[i].left+1]++;
+            nodePtr[MD->NumEle+i+1]++;
+        }
+        if(MD->RivGeom[i].right >= 0)
+        {
+            nodePtr[MD->RivGeom[i].right+1]++;
+            nodePtr[MD->NumEle+i+1]++;
+        }
+        if(MD->Riv[i].down > 0)
+        {
+            nodePtr[MD->NumEle+i+1]++;
+            nodePtr[MD->NumEle+MD->Riv[i].down]++;
+        }
+    }
+    for(i=0; i<NumNode; i++)
+    {
+        nodePtr[i+1] = nodePtr[i+1] + nodePtr[i];
+        count[i] = nodePtr[i];
+    }
+    nodeAdj = (int *)malloc((nodePtr[NumNode] > 0 ? nodePtr[NumNode] : 1)*sizeof(int));
+    for(i=0; i<NumNode; i++)
+    {
+        nodeAdj[count[i]++] = i;
+    }
+    for(k=0; k<MD->NumFace; k++)
+    {
+        nodeAdj[count[MD->Face[k].owner]++] = MD->Face[k].nabr;
+        nodeAdj[count[MD->Face[k].nabr]++] = MD->Face[k].owner;
+    }
+    for(i=0; i<MD->NumRiv; i++)
+    {
+        if(MD->RivGeom[i].left >= 0)
+        {
+            nodeAdj[count[MD->RivGeom[i].left]++] = MD->NumEle+i;
+            nodeAdj[count[MD->NumEle+i]++] = MD->RivGeom[i].left;
+        }
+        if(MD->RivGeom[i].right >= 0)
+        {
+            nodeAdj[count[MD->RivGeom[i].right]++] = MD->NumEle+i;
+            nodeAdj[count[MD->NumEle+i]++] = MD->RivGeom[i].right;
+        }
+        if(MD->Riv[i].down > 0)
+        {
+            nodeAdj[count[MD->NumEle+i]++] = MD->NumEle+MD->Riv[i].down-1;
+            nodeAdj[count[MD->NumEle+MD->Riv[i].down-1]++] = MD->NumEle+i;
+        }
+    }
+
+    free(count);
+    *pPtr = nodePtr;
+    *pAdj = nodeAdj;
+}
+
+
+static void MeshOrder(Model_Data MD, int *nodePtr, int *nodeAdj, int nIS, int *perm)
+//! Function orders the states by reverse Cuthill-McKee over the node graph, the states of an element kept together
+/*! \param MD is pointer to model data structure
+    \param nodePtr is the offsets into the adjacency lists per node (MeshGraph())
+    \param nodeAdj is the adjacent nodes of every node
+    \param nIS is 1 if interception and snow are states (ISMode 1), else 0
+    \param perm is set to the state at each position [3*NumEle+NumRiv (+2*NumEle)]
+*/
+{
+    int i, k, l, m, a, b, NumNode, head, tail, start, base;
+    int *count, *nodeOrder, *mark;
+
+    NumNode = MD->NumEle + MD->NumRiv;
+    count = (int *)malloc((NumNode > 0 ? NumNode : 1)*sizeof(int));
+    mark = (int *)malloc((NumNode > 0 ? NumNode : 1)*sizeof(int));
+
+    /* reverse Cuthill-McKee ordering of the nodes, one connected part at a time */
+    nodeOrder = (int *)malloc((NumNode > 0 ? NumNode : 1)*sizeof(int));
+    for(i=0; i<NumNode; i++)
+    {
+        mark[i] = 0;
+    }
+    tail = 0;
+    for(start=0; start<NumNode; start++)
+    {
+        if(mark[start])
+        {
+            continue;
+        }
+        /* breadth-first sweep from start; count holds the level of each node */
+        base = tail;
+        head = tail;
+        nodeOrder[tail++] = start;
+        mark[start] = 1;
+        count[start] = 0;
+        while(head < tail)
+        {
+            i = nodeOrder[head++];
+            for(k=nodePtr[i]; k<nodePtr[i+1]; k++)
+            {
+                if(!mark[nodeAdj[k]])
+                {
+                    mark[nodeAdj[k]] = 1;
+                    count[nodeAdj[k]] = count[i] + 1;
+                    nodeOrder[tail++] = nodeAdj[k];
+                }
+            }
+        }
+        /* restart from a node of least degree in the last level, far from start */
+        a = nodeOrder[tail-1];
+        for(k=tail-1; k>=base && count[nodeOrder[k]]==count[nodeOrder[tail-1]]; k--)
+        {
+            if(nodePtr[nodeOrder[k]+1]-nodePtr[nodeOrder[k]] <= nodePtr[a+1]-nodePtr[a])
+            {
+                a = nodeOrder[k];
+            }
+        }
+        for(k=base; k<tail; k++)
+        {
+            mark[nodeOrder[k]] = 0;
+        }
+        head = base;
+        tail = base;
+        nodeOrder[tail++] = a;
+        mark[a] = 1;
+        while(head < tail)
+        {
+            i = nodeOrder[head++];
+            m = tail;
+            for(k=nodePtr[i]; k<nodePtr[i+1]; k++)
+            {
+                if(!mark[nodeAdj[k]])
+                {
+                    mark[nodeAdj[k]] = 1;
+                    nodeOrder[tail++] = nodeAdj[k];
+                }
+            }
+            /* new nodes in order of increasing degree */
+            for(k=m+1; k<tail; k++)
+            {
+                b = nodeOrder[k];
+                for(l=k; l>m && nodePtr[nodeOrder[l-1]+1]-nodePtr[nodeOrder[l-1]] > nodePtr[b+1]-nodePtr[b]; l--)
+                {
+                    nodeOrder[l] = nodeOrder[l-1];
+                }
+                nodeOrder[l] = b;
+            }
+        }
+    }
+
+
+    /* state ordering: nodes reversed, the layers (and interception and snow) of an element kept together */
+    m = 0;
+    for(k=NumNode-1; k>=0; k--)
+    {
+        a = nodeOrder[k];
+        if(a < MD->NumEle)
+        {
+            perm[m++] = a;
+            perm[m++] = a + MD->NumEle;
+            perm[m++] = a + 2*MD->NumEle;
+            if(nIS)
+            {
+                perm[m++] = a + 3*MD->NumEle + MD->NumRiv;
+                perm[m++] = a + 4*MD->NumEle + MD->NumRiv;
+            }
+        }
+        else
+        {
+            perm[m++] = 3*MD->NumEle + a - MD->NumEle;
+        }
+    }
+
+    free(count);
+    free(nodeOrder);
+    free(mark);
+}
+
+
+/*******************************************************************************
+*    Pattern, Coloring and Symbolic Factorization
+********************************************************************************/
+void SparseInit(Model_Data MD)
+//! Function derives the Jacobian pattern from the mesh, colors its columns and fixes the envelope of the LU factors
+/*! \param MD is pointer to model data structure
+*/
+{
+    int i, j, k, l, m, a, b, c, n, N, NumNode;
+    int *nodePtr, *nodeAdj, *mark, *forbid;
+    sparse_jac *S;
+
+    S = &MD->Sparse;
+    NumNode = MD->NumEle + MD->NumRiv;
+    N = 3*MD->NumEle + MD->NumRiv;
+    S->N = N;
+
+    /* node graph: elements [0,NumEle), segments [NumEle,NumNode); every list holds the node itself */
+    MeshGraph(MD, &nodePtr, &nodeAdj);
+
+    /* state pattern (structurally symmetric): all states of a node depend on all states of its adjacent nodes */
+    S->colPtr = (int *)malloc((N+1)*sizeof(int));
+    mark = (int *)malloc((N > NumNode ? N : NumNode)*sizeof(int));
+    for(i=0; i<N; i++)
+    {
+        mark[i] = -1;
+    }
+    S->colPtr[0] = 0;
+    for(i=0; i<NumNode; i++)
+    {
+        n = 0;
+        for(k=nodePtr[i]; k<nodePtr[i+1]; k++)
+        {
+            if(mark[nodeAdj[k]] != i)
+            {
+                mark[nodeAdj[k]] = i;
+                n = n + (nodeAdj[k] < MD->NumEle ? 3 : 1);
+            }
+        }
+        for(l=0; l<(i < MD->NumEle ? 3 : 1); l++)
+        {
+            j = i < MD->NumEle ? i + l*MD->NumEle : 3*MD->NumEle + i - MD->NumEle;
+            S->colPtr[j+1] = n;
+        }
+    }
+    for(j=0; j<N; j++)
+    {
+        S->colPtr[j+1] = S->colPtr[j+1] + S->colPtr[j];
+    }
+    S->rowIdx = (int *)malloc(S->colPtr[N]*sizeof(int));
+    S->val = (realtype *)alignedMalloc(S->colPtr[N]*sizeof(realtype));
+    for(i=0; i<NumNode; i++)
+    {
+        mark[i] = -1;
+    }
+    for(i=0; i<NumNode; i++)
+    {
+        for(l=0; l<(i < MD->NumEle ? 3 : 1); l++)
+        {
+            j = i < MD->NumEle ? i + l*MD->NumEle : 3*MD->NumEle + i - MD->NumEle;
+            m = S->colPtr[j];
+            for(k=nodePtr[i]; k<nodePtr[i+1]; k++)
+            {
+                a = nodeAdj[k];
+                if(mark[a] == j)
+                {
+                    continue;
+                }
+                mark[a] = j;
+                if(a < MD->NumEle)
+                {
+                    S->rowIdx[m++] = a;
+                    S->rowIdx[m++] = a + MD->NumEle;
+                    S->rowIdx[m++] = a + 2*MD->NumEle;
+                }
+                else
+                {
+                    S->rowIdx[m++] = 3*MD->NumEle + a - MD->NumEle;
+                }
+            }
+        }
+    }
+
+    /* distance-2 coloring (greedy): columns sharing a row get different colors */
+    S->color = (int *)malloc(N*sizeof(int));
+    forbid = (int *)malloc((N+1)*sizeof(int));
+    for(j=0; j<=N; j++)
+    {
+        forbid[j] = -1;
+    }
+    S->NumColor = 0;
+    for(j=0; j<N; j++)
+    {
+        for(k=S->colPtr[j]; k<S->colPtr[j+1]; k++)
+        {
+            /* the columns of row i are the rows of column i by symmetry */
+            i = S->rowIdx[k];
+            for(l=S->colPtr[i]; l<S->colPtr[i+1]; l++)
+            {
+                if(S->rowIdx[l] < j)
+                {
+                    forbid[S->color[S->rowIdx[l]]] = j;
+                }
+            }
+        }
+        for(c=0; forbid[c] == j; c++)
+        {
+        }
+        S->color[j] = c;
+        S->NumColor = c+1 > S->NumColor ? c+1 : S->NumColor;
+    }
+
+    /* columns of each color */
+    S->colorPtr = (int *)malloc((S->NumColor+1)*sizeof(int));
+    S->colorCol = (int *)malloc(N*sizeof(int));
+    for(c=0; c<=S->NumColor; c++)
+    {
+        S->colorPtr[c] = 0;
+    }
+    for(j=0; j<N; j++)
+    {
+        S->colorPtr[S->color[j]+1]++;
+    }
+    for(c=0; c<S->NumColor; c++)
+    {
+        S->colorPtr[c+1] = S->colorPtr[c+1] + S->colorPtr[c];
+        forbid[c] = S->colorPtr[c];
+    }
+    for(j=0; j<N; j++)
+    {
+        S->colorCol[forbid[S->color[j]]++] = j;
+    }
+
+    /* reverse Cuthill-McKee ordering of the nodes, the three layers of an element kept together */
+    S->perm = (int *)malloc(N*sizeof(int));
+    S->iperm = (int *)malloc(N*sizeof(int));
+    MeshOrder(MD, nodePtr, nodeAdj, 0, S->perm);
+    for(k=0; k<N; k++)
+    {
+        S->iperm[S->perm[k]] = k;
+    }
+
+    /* symbolic factorization: the envelope of a symmetric pattern holds all fill of LU without pivoting */
+    S->first = (int *)malloc(N*sizeof(int));
+    S->envPtr = (long *)malloc((N+1)*sizeof(long));
+    for(k=0; k<N; k++)
+    {
+        S->first[k] = k;
+    }
+    for(j=0; j<N; j++)
+    {
+        for(k=S->colPtr[j]; k<S->colPtr[j+1]; k++)
+        {
+            a = S->iperm[S->rowIdx[k]];
+            b = S->iperm[j];
+            if(b < S->first[a])
+            {
+                S->first[a] = b;
+            }
+        }
+    }
+    S->envPtr[0] = 0;
+    for(k=0; k<N; k++)
+    {
+        S->envPtr[k+1] = S->envPtr[k] + (k - S->first[k]);
+    }
+    S->L = (realtype *)alignedMalloc((S->envPtr[N] > 0 ? S->envPtr[N] : 1)*sizeof(realtype));
+    S->U = (realtype *)alignedMalloc((S->envPtr[N] > 0 ? S->envPtr[N] : 1)*sizeof(realtype));
+    S->D = (realtype *)alignedMalloc(N*sizeof(realtype));
+
+    printf("  Sparse Jacobian: %d unknowns, %d nonzeros, %d colors, envelope %ld\n", N, S->colPtr[N], S->NumColor, S->envPtr[N]);
+
+    free(nodePtr);
+    free(nodeAdj);
+    free(mark);
+    free(forbid);
+}
+
+
+/*******************************************************************************
+*    Jacobian Evaluation and Numeric Factorization
+********************************************************************************/
+int SparsePrecond(realtype t, N_Vector CV_Y, N_Vector CV_F, booleantype jok, booleantype *jcurPtr,
+                  realtype gamma, void *DS, N_Vector tmp1, N_Vector tmp2, N_Vector tmp3)
+//! Function evaluates (unless jok) the colored finite difference Jacobian and factors I - gamma*J
+/*! \param t is the time of simulation
+    \param CV_Y is state variable vector
+    \param CV_F is f(t, CV_Y)
+    \param jok is TRUE if the saved Jacobian may be reused
+    \param jcurPtr is set to TRUE if the Jacobian was re-evaluated
+    \param gamma is the scalar of the Newton matrix I - gamma*J
+    \param DS is pointer to model data structure
+    \param tmp1 tmp2 tmp3 are work vectors of CVODE
+*/
+{
+    int i, j, k, l, c, p0, p;
+    realtype srur, sum;
+    realtype *Y, *F, *YP, *FP, *inc, *Lk, *Uk;
+    sparse_jac *S;
+    Model_Data MD;
+
+    MD = (Model_Data) DS;
+    S = &MD->Sparse;
+    Y = NV_DATA_S(CV_Y);
+    F = NV_DATA_S(CV_F);
+    srur = sqrt(UNIT_ROUNDOFF);
+
+    if(jok == FALSE)
+    {
+        /* one evaluation of f() per color */
+        YP = NV_DATA_S(tmp1);
+        FP = NV_DATA_S(tmp2);
+        inc = NV_DATA_S(tmp3);
+        for(c=0; c<S->NumColor; c++)
+        {
+            N_VScale(1.0, CV_Y, tmp1);
+            for(l=S->colorPtr[c]; l<S->colorPtr[c+1]; l++)
+            {
+                j = S->colorCol[l];
+                inc[j] = srur*(fabs(Y[j]) > 1.0 ? fabs(Y[j]) : 1.0);
+                /* step back from the top of the aquifer, where f() bounds the subsurface states */
+                if(j >= MD->NumEle && j < 3*MD->NumEle && Y[j] + inc[j] > MD->EleP.AqDepth[j%MD->NumEle])
+                {
+                    inc[j] = -inc[j];
+                }
+                YP[j] = Y[j] + inc[j];
+            }
+            fProf(t, tmp1, tmp2, MD);
+            #pragma omp parallel for private(j,k)
+            for(l=S->colorPtr[c]; l<S->colorPtr[c+1]; l++)
+            {
+                j = S->colorCol[l];
+                for(k=S->colPtr[j]; k<S->colPtr[j+1]; k++)
+                {
+                    S->val[k] = (FP[S->rowIdx[k]] - F[S->rowIdx[k]])/inc[j];
+                }
+            }
+        }
+        /* interception and snow (ISMode 1) are outside the pattern: diagonal of precond.c */
+        if(MD->ISMode == 1)
+        {
+            PrecondIS(t, CV_Y, CV_F, MD, tmp1, tmp2);
+        }
+        /* leave the fluxes stored by f() consistent with CV_Y */
+        fProf(t, CV_Y, tmp2, MD);
+
+        *jcurPtr = TRUE;
+    }
+    else
+    {
+        *jcurPtr = FALSE;
+    }
+
+    if(MD->ISMode == 1 && PrecondISFactor(MD, gamma) > 0)
+    {
+        return(1);
+    }
+
+    /* scatter I - gamma*J into the envelope, in the state ordering of the factorization */
+    for(k=0; k<S->envPtr[S->N]; k++)
+    {
+        S->L[k] = 0.0;
+        S->U[k] = 0.0;
+    }
+    for(k=0; k<S->N; k++)
+    {
+        S->D[k] = 1.0;
+    }
+    for(j=0; j<S->N; j++)
+    {
+        c = S->iperm[j];
+        for(k=S->colPtr[j]; k<S->colPtr[j+1]; k++)
+        {
+            i = S->iperm[S->rowIdx[k]];
+            if(i > c)
+            {
+                S->L[S->envPtr[i] + c - S->first[i]] = -gamma*S->val[k];
+            }
+            else if(i < c)
+            {
+                S->U[S->envPtr[c] + i - S->first[c]] = -gamma*S->val[k];
+            }
+            else
+            {
+                S->D[i] = S->D[i] - gamma*S->val[k];
+            }
+        }
+    }
+
+    /* Crout LU within the envelope: row k of L and column k of U, then the pivot D[k] */
+    for(k=0; k<S->N; k++)
+    {
+        Lk = &S->L[S->envPtr[k] - S->first[k]];
+        Uk = &S->U[S->envPtr[k] - S->first[k]];
+        for(j=S->first[k]; j<k; j++)
+        {
+            p0 = S->first[k] > S->first[j] ? S->first[k] : S->first[j];
+            sum = 0.0;
+            for(p=p0; p<j; p++)
+            {
+                sum = sum + Lk[p]*S->U[S->envPtr[j] + p - S->first[j]];
+            }
+            Lk[j] = (Lk[j] - sum)/S->D[j];
+            sum = 0.0;
+            for(p=p0; p<j; p++)
+            {
+                sum = sum + S->L[S->envPtr[j] + p - S->first[j]]*Uk[p];
+            }
+            Uk[j] = Uk[j] - sum;
+        }
+        sum = 0.0;
+        for(p=S->first[k]; p<k; p++)
+        {
+            sum = sum + Lk[p]*Uk[p];
+        }
+        S->D[k] = S->D[k] - sum;
+        /* no pivoting: a vanishing pivot lets CVODE retry with a smaller step */
+        if(fabs(S->D[k]) < UNIT_ROUNDOFF)
+        {
+            return(1);
+        }
+    }
+
+    return(0);
+}
+
+
+/*******************************************************************************
+*    Sparse Triangular Solves
+********************************************************************************/
+int SparsePSolve(realtype t, N_Vector CV_Y, N_Vector CV_F, N_Vector CV_R, N_Vector CV_Z,
+                 realtype gamma, realtype delta, int lr, void *DS, N_Vector tmp)
+//! Function solves (I - gamma*J) z = r with the factors computed in SparsePrecond()
+/*! \param t is the time of simulation
+    \param CV_Y is state variable vector
+    \param CV_F is f(t, CV_Y)
+    \param CV_R is the right hand side r
+    \param CV_Z is the solution z
+    \param gamma is the scalar of the Newton matrix I - gamma*J
+    \param delta is the tolerance of an iterative solve (not used: the solve is direct)
+    \param lr is 1 for left and 2 for right preconditioning
+    \param DS is pointer to model data structure
+    \param tmp is a work vector of CVODE
+*/
+{
+    int k, p;
+    realtype sum;
+    realtype *R, *Z, *B, *Lk, *Uk;
+    sparse_jac *S;
+    Model_Data MD;
+
+    MD = (Model_Data) DS;
+    S = &MD->Sparse;
+    R = NV_DATA_S(CV_R);
+    Z = NV_DATA_S(CV_Z);
+    B = NV_DATA_S(tmp);
+
+    /* forward substitution with the unit lower factor (by rows) */
+    for(k=0; k<S->N; k++)
+    {
+        Lk = &S->L[S->envPtr[k] - S->first[k]];
+        sum = R[S->perm[k]];
+        for(p=S->first[k]; p<k; p++)
+        {
+            sum = sum - Lk[p]*B[p];
+        }
+        B[k] = sum;
+    }
+    /* backward substitution with the upper factor (by columns) */
+    for(k=S->N-1; k>=0; k--)
+    {
+        Uk = &S->U[S->envPtr[k] - S->first[k]];
+        B[k] = B[k]/S->D[k];
+        for(p=S->first[k]; p<k; p++)
+        {
+            B[p] = B[p] - Uk[p]*B[k];
+        }
+        Z[S->perm[k]] = B[k];
+    }
+    if(MD->ISMode == 1)
+    {
+        PrecondISSolve(MD, R, Z);
+    }
+
+    return(0);
+}
+
+
+
+/*******************************************************************************
+*    Banded Direct Solver in the Mesh Ordering (Solver 1)
+********************************************************************************/
+void BandInit(Model_Data MD, int N)
+//! Function orders the states by reverse Cuthill-McKee for CVBand and returns the half-bandwidth in MD->Band.bw
+/*! \param MD is pointer to model data structure
+    \param N is the number of unknowns (with interception and snow in ISMode 1)
+*/
+{
+    int i, k, a, d, NumNode;
+    int *nodePtr, *nodeAdj, *first, *last;
+    band_jac *B;
+
+    B = &MD->Band;
+    NumNode = MD->NumEle + MD->NumRiv;
+    B->N = N;
+    B->perm = (int *)malloc(N*sizeof(int));
+    B->Y = N_VNew_Serial(N);
+    B->Ydot = N_VNew_Serial(N);
+    B->Ym = N_VNew_Serial(N);
+
+    MeshGraph(MD, &nodePtr, &nodeAdj);
+    MeshOrder(MD, nodePtr, nodeAdj, MD->ISMode == 1, B->perm);
+
+    /* positions of the first and last state of every node */
+    first = (int *)malloc(NumNode*sizeof(int));
+    last = (int *)malloc(NumNode*sizeof(int));
+    for(a=0; a<NumNode; a++)
+    {
+        first[a] = -1;
+    }
+    for(k=0; k<N; k++)
+    {
+        i = B->perm[k];
+        if(i < 3*MD->NumEle)
+        {
+            a = i%MD->NumEle;
+        }
+        else if(i < 3*MD->NumEle + MD->NumRiv)
+        {
+            a = MD->NumEle + i - 3*MD->NumEle;
+        }
+        else
+        {
+            a = (i - 3*MD->NumEle - MD->NumRiv)%MD->NumEle;
+        }
+        if(first[a] < 0)
+        {
+            first[a] = k;
+        }
+        last[a] = k;
+    }
+
+    /* all states of a node depend on all states of its adjacent nodes (and of itself) */
+    B->bw = 0;
+    for(a=0; a<NumNode; a++)
+    {
+        for(k=nodePtr[a]; k<nodePtr[a+1]; k++)
+        {
+            d = last[a] - first[nodeAdj[k]];
+            B->bw = d > B->bw ? d : B->bw;
+        }
+    }
+
+    free(nodePtr);
+    free(nodeAdj);
+    free(first);
+    free(last);
+}
+
+
+int fBand(realtype t, N_Vector CV_Yb, N_Vector CV_Ydotb, void *DS)
+//! Function is the RHS given to CVODE with the band solver: fProf() on the states in the model ordering
+/*! \param t is the time of simulation
+    \param CV_Yb is the state vector in the band ordering
+    \param CV_Ydotb is the rate of change of the states in the band ordering (output)
+    \param DS is pointer to model data structure
+*/
+{
+    int k, flag;
+    realtype *Yb, *Ydotb, *Y, *Ydot;
+    Model_Data MD;
+
+    MD = (Model_Data) DS;
+    Yb = NV_DATA_S(CV_Yb);
+    Ydotb = NV_DATA_S(CV_Ydotb);
+    Y = NV_DATA_S(MD->Band.Y);
+    Ydot = NV_DATA_S(MD->Band.Ydot);
+
+    for(k=0; k<MD->Band.N; k++)
+    {
+        Y[MD->Band.perm[k]] = Yb[k];
+    }
+    flag = fProf(t, MD->Band.Y, MD->Band.Ydot, DS);
+    for(k=0; k<MD->Band.N; k++)
+    {
+        Ydotb[k] = Ydot[MD->Band.perm[k]];
+    }
+
+    return(flag);
+}
+
+
+void BandToModel(Model_Data MD, N_Vector CV_Yb, N_Vector CV_Y)
+//! Function copies a state vector from the band ordering to the model ordering
+/*! \param MD is pointer to model data structure
+    \param CV_Yb is the state vector in the band ordering
+    \param CV_Y is the state vector in the model ordering (output)
+*/
+{
+    int k;
+
+    for(k=0; k<MD->Band.N; k++)
+    {
+        NV_Ith_S(CV_Y, MD->Band.perm[k]) = NV_Ith_S(CV_Yb, k);
+    }
+}
+
+
+void BandFromModel(Model_Data MD, N_Vector CV_Y, N_Vector CV_Yb)
+//! Function copies a state vector from the model ordering to the band ordering
+/*! \param MD is pointer to model data structure
+    \param CV_Y is the state vector in the model ordering
+    \param CV_Yb is the state vector in the band ordering (output)
+*/
+{
+    int k;
+
+    for(k=0; k<MD->Band.N; k++)
+    {
+        NV_Ith_S(CV_Yb, k) = NV_Ith_S(CV_Y, MD->Band.perm[k]);
+    }
+}
+
+
+N_Vector BandModelState(Model_Data MD, N_Vector CV_Yb)
+//! Function returns the state of CVODE in the model ordering, in the workspace MD->Band.Ym
+/*! \param MD is pointer to model data structure
+    \param CV_Yb is the state vector in the band ordering
+*/
+{
+    BandToModel(MD, CV_Yb, MD->Band.Ym);
+    return MD->Band.Ym;
+}
+
@@ -0,0 +1,312 @@
+/*******************************************************************************
+ * File        : stats.c                                                       *
+ * Function    : solver statistics and run-time profile of every output        *
+ *               interval                                                      *
+ * Programmers : Yizhong Qu   @ Pennsylvania State Univeristy                  *
+ *               Mukesh Kumar @ Pennsylvania State Univeristy                  *
+ *               Gopal Bhatt  @ Pennsylvania State Univeristy                  *
+ * Version     : 2.0 (July 10, 2007)                                           *
+ *-----------------------------------------------------------------------------*
+ *                                                                             *
+ * At every output time cData.Tout[i] the counters of CVODE and of its linear  *
+ * solver are read and the increase over the interval is written as one row of *
+ * <filename>.stats.csv, together with the wall time spent on the interval.    *
+ * Columns:                                                                    *
+ *   interval, t (min), wall (s), flag of the last CVode() call,               *
+ *   steps, rhs evals, lin setups, err test fails, nonlin iters,               *
+ *   nonlin conv fails, last order, last step, current step (min),             *
+ *   lin iters, lin conv fails, prec evals, prec solves, jtimes evals          *
+ *   (Krylov solvers 2-5 only), jac evals (band solver 1 only) and rhs evals   *
+ *   of the linear solver.                                                     *
+ * Columns that do not apply to the selected solver are written as 0.          *
+ *                                                                             *
+ * The run-time profile adds up the wall time of the phases of stats.h. It is  *
+ * selected by Profile in .para: 0 off, 1 summary at the end of the run, 2 the *
+ * summary and the time of every phase per interval in <filename>.prof.csv.    *
+ * A timer costs two reads of the monotonic clock per call and nothing but a   *
+ * test of profMode when the profile is off.                                   *
+ *                                                                             *
+ * This code is free for users with research purpose only, if appropriate      *
+ * citation is refered. However, there is no warranty in any format for this   *
+ * product.                                                                    *
+ *                                                                             *
+ * For questions or comments, please contact the authors of the reference.     *
+ * One who want to use it for other consideration may also contact Dr.Duffy    *
+ * at cxd11@psu.edu.                                                           *
+ *******************************************************************************/
+
+//! @file stats.c CVODE counters and phase timers per output interval in csv files
+
+/*    C Header Files    */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*    SUNDIALS Header Files    */
+#include "sundials_types.h"
+#include "cvode.h"
+#include "cvode_band.h"
+#include "cvode_spils.h"
+#include "nvector_serial.h"
+
+/*    PIHM Header Files    */
+#include "pihm.h"
+#include "stats.h"
+
+#define NSTATS    13        /**< Number of counters kept between two rows     */
+
+
+FILE *statsPtr;             /**< File pointer for .stats.csv file             */
+char *statsFile;            /**< string to hold .stats.csv file name          */
+FILE *profPtr;              /**< File pointer for .prof.csv file              */
+char *profFile;             /**< string to hold .prof.csv file name           */
+
+static long int statsLast[NSTATS];   /**< Counters at the end of the previous interval */
+static long int statsTotal[NSTATS];  /**< Counters at the end of the last interval     */
+static double statsWall0;            /**< Wall clock at the start of the interval      */
+static double statsWallStart;        /**< Wall clock at the start of the integration   */
+
+/* read_alloc() is timed before .para is read: the timers run until FPrintStatsInit() */
+static int profMode = 1;                      /**< 0: off 1: summary 2: and per interval */
+static double profStart[PROF_NUM];            /**< Wall clock at ProfStart() of a phase  */
+static double profSum[PROF_NUM];              /**< Time spent in a phase                 */
+static double profLast[PROF_NUM];             /**< profSum at the previous output time   */
+static long int profCalls[PROF_NUM];          /**< Number of timed calls of a phase      */
+static const char *profName[PROF_NUM] = {"read_alloc", "initialize", "calET_IS", "CVode", "  f()", "setTSDiCounter", "FPrint", "estuary", "snapshot f()"};
+
+double WallClock(void);
+int f(realtype, N_Vector, N_Vector, void *);
+
+
+
+/*******************************************************************************
+*    Open .stats.csv and write its header
+********************************************************************************/
+void FPrintStatsInit(char *filename, int profile)
+//! Opens <filename>.stats.csv (and .prof.csv), writes the headers and starts the wall clock of the first interval
+/*! \param filename is the prefix of the output files
+    \param profile is 0 (no profile), 1 (summary) or 2 (summary and per interval) as read from .para
+*/
+{
+    int k;
+
+    statsFile = (char *)malloc(sizeof(char)*(20+strlen(filename)));
+    strcpy(statsFile, filename);
+    strcat(statsFile, ".stats.csv");
+    statsPtr = fopen(statsFile, "w");
+    if(statsPtr == NULL)
+    {
+        printf("\n  Fatal Error: %s can not be opened!\n", statsFile);
+        exit(1);
+    }
+
+    fprintf(statsPtr, "interval,t,wall,flag,steps,rhs_evals,lin_setups,err_test_fails,nonlin_iters,nonlin_conv_fails,");
+    fprintf(statsPtr, "order,h_last,h_cur,lin_iters,lin_conv_fails,prec_evals,prec_solves,jtimes_evals,jac_evals,lin_rhs_evals\n");
+    fflush(statsPtr);
+
+    for(k=0; k<NSTATS; k++)
+    {
+        statsLast[k] = 0;
+        statsTotal[k] = 0;
+    }
+
+    profMode = profile;
+    if(profMode == 2)
+    {
+        profFile = (char *)malloc(sizeof(char)*(20+strlen(filename)));
+        strcpy(profFile, filename);
+        strcat(profFile, ".prof.csv");
+        profPtr = fopen(profFile, "w");
+        if(profPtr == NULL)
+        {
+            printf("\n  Fatal Error: %s can not be opened!\n", profFile);
+            exit(1);
+        }
+        fprintf(profPtr, "interval,t,etis,cvode,rhs,solver,tsd,print,estuary,snapshot\n");
+        fflush(profPtr);
+    }
+    for(k=0; k<PROF_NUM; k++)
+    {
+        profLast[k] = profSum[k];
+    }
+
+    statsWall0 = WallClock();
+    statsWallStart = statsWall0;
+}
+
+
+/*******************************************************************************
+*    Write the counters of one output interval
+********************************************************************************/
+void FPrintStats(void *cvode_mem, int solver, int i, realtype t, int flag)
+//! Reads the CVODE counters and writes their increase since the previous output time as one row
+/*! \param cvode_mem is the CVODE memory block
+    \param solver is the linear solver selected in .para (cData.Solver)
+    \param i is the index of the output interval (ends at cData.Tout[i+1])
+    \param t is time of current simulation
+    \param flag is the return value of the last call of CVode()
+*/
+{
+    int k, order;
+    long int *n;
+    realtype hLast, hCur;
+    double wall, dt[PROF_NUM];
+
+    n = statsTotal;
+    for(k=0; k<NSTATS; k++)
+    {
+        n[k] = 0;
+    }
+    order = 0;
+    hLast = 0.0;
+    hCur = 0.0;
+
+    CVodeGetNumSteps(cvode_mem, &n[0]);
+    CVodeGetNumRhsEvals(cvode_mem, &n[1]);
+    CVodeGetNumLinSolvSetups(cvode_mem, &n[2]);
+    CVodeGetNumErrTestFails(cvode_mem, &n[3]);
+    CVodeGetNumNonlinSolvIters(cvode_mem, &n[4]);
+    CVodeGetNumNonlinSolvConvFails(cvode_mem, &n[5]);
+    CVodeGetLastOrder(cvode_mem, &order);
+    CVodeGetLastStep(cvode_mem, &hLast);
+    CVodeGetCurrentStep(cvode_mem, &hCur);
+    if(solver >= 2)
+    {
+        CVSpilsGetNumLinIters(cvode_mem, &n[6]);
+        CVSpilsGetNumConvFails(cvode_mem, &n[7]);
+        CVSpilsGetNumPrecEvals(cvode_mem, &n[8]);
+        CVSpilsGetNumPrecSolves(cvode_mem, &n[9]);
+        CVSpilsGetNumJtimesEvals(cvode_mem, &n[10]);
+        CVSpilsGetNumRhsEvals(cvode_mem, &n[12]);
+    }
+    else
+    {
+        CVBandGetNumJacEvals(cvode_mem, &n[11]);
+        CVBandGetNumRhsEvals(cvode_mem, &n[12]);
+    }
+
+    wall = WallClock();
+    fprintf(statsPtr, "%d,%lf,%.3f,%d", i+1, t, wall-statsWall0, flag);
+    for(k=0; k<6; k++)
+    {
+        fprintf(statsPtr, ",%ld", n[k]-statsLast[k]);
+    }
+    fprintf(statsPtr, ",%d,%e,%e", order, hLast, hCur);
+    for(k=6; k<NSTATS; k++)
+    {
+        fprintf(statsPtr, ",%ld", n[k]-statsLast[k]);
+    }
+    fprintf(statsPtr, "\n");
+    fflush(statsPtr);
+
+    for(k=0; k<NSTATS; k++)
+    {
+        statsLast[k] = n[k];
+    }
+    statsWall0 = wall;
+
+    if(profMode == 2)
+    {
+        for(k=0; k<PROF_NUM; k++)
+        {
+            dt[k] = profSum[k] - profLast[k];
+            profLast[k] = profSum[k];
+        }
+        fprintf(profPtr, "%d,%lf,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f\n", i+1, t, dt[PROF_ETIS], dt[PROF_CVODE], dt[PROF_RHS],
+                dt[PROF_CVODE]-dt[PROF_RHS], dt[PROF_TSD], dt[PROF_PRINT], dt[PROF_ESTUARY], dt[PROF_SNAP]);
+        fflush(profPtr);
+    }
+}
+
+
+/*******************************************************************************
+*    Close .stats.csv and summarize the run
+********************************************************************************/
+void FPrintStatsClose(void)
+//! Prints the totals of the run (and the profile) to stdout and closes the files
+{
+    int k;
+    double total;
+
+    total = WallClock() - statsWallStart;
+
+    printf("\n\nCVODE statistics (per interval in %s)\n", statsFile);
+    printf("  steps %ld, rhs evals %ld (+%ld in lin solver), lin setups %ld\n", statsTotal[0], statsTotal[1], statsTotal[12], statsTotal[2]);
+    printf("  err test fails %ld, nonlin iters %ld, nonlin conv fails %ld\n", statsTotal[3], statsTotal[4], statsTotal[5]);
+    printf("  lin iters %ld, lin conv fails %ld, prec evals %ld, jac evals %ld\n", statsTotal[6], statsTotal[7], statsTotal[8], statsTotal[11]);
+    printf("  wall time of the integration %.1f s\n", total);
+    fclose(statsPtr);
+
+    if(profMode > 0)
+    {
+        total = total + profSum[PROF_READ] + profSum[PROF_INIT];
+        printf("\nRun-time profile (wall s, %% of the run)\n");
+        for(k=0; k<PROF_NUM; k++)
+        {
+            printf("  %-16s %10ld calls %10.2f s %6.1f %%\n", profName[k], profCalls[k], profSum[k], 100.0*profSum[k]/total);
+        }
+        printf("  %-16s %16s %10.2f s %6.1f %%\n", "  CVODE w/o f()", "", profSum[PROF_CVODE]-profSum[PROF_RHS],
+               100.0*(profSum[PROF_CVODE]-profSum[PROF_RHS])/total);
+        if(profMode == 2)
+        {
+            fclose(profPtr);
+        }
+    }
+}
+
+
+/*******************************************************************************
+*    Phase timers
+********************************************************************************/
+void ProfStart(int k)
+//! Starts the timer of phase k
+/*! \param k is the phase (PROF_* in stats.h)
+*/
+{
+    if(profMode > 0)
+    {
+        profStart[k] = WallClock();
+    }
+}
+
+
+void ProfStop(int k)
+//! Adds the time since ProfStart(k) to phase k
+/*! \param k is the phase (PROF_* in stats.h)
+*/
+{
+    if(profMode > 0)
+    {
+        profSum[k] = profSum[k] + WallClock() - profStart[k];
+        profCalls[k]++;
+    }
+}
+
+
+int fProf(realtype t, N_Vector CV_Y, N_Vector CV_Ydot, void *DS)
+//! Function is the RHS given to CVODE: f() with its time added to PROF_RHS
+/*! \param t is the time of simulation
+    \param CV_Y is state variable vector
+    \param CV_Ydot is the rate of change of the states (output)
+    \param DS is pointer to model data structure
+*/
+{
+    int flag;
+
+    ProfStart(PROF_RHS);
+    flag = f(t, CV_Y, CV_Ydot, DS);
+    ProfStop(PROF_RHS);
+
+    return(flag);
+}
+
+
+double WallClock(void)
+//! Function returns a monotonic wall clock in seconds; clock() would add up the cpu time of all threads
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return(ts.tv_sec + 1E-9*ts.tv_nsec);
+}
@@ -0,0 +1,48 @@
+#ifndef STATS_H
+#define STATS_H
+
+/*******************************************************************************
+ * File        : stats.h                                                       *
+ * Function    : phase identifiers and function declarations for stats.c       *
+ * Programmers : Yizhong Qu   @ Pennsylvania State Univeristy                  *
+ *               Mukesh Kumar @ Pennsylvania State Univeristy                  *
+ *               Gopal Bhatt  @ Pennsylvania State Univeristy                  *
+ * Version     : 2.0 (July 10, 2007)                                           *
+ *-----------------------------------------------------------------------------*
+ *                                                                             *
+ * This code is free for users with research purpose only, if appropriate      *
+ * citation is refered. However, there is no warranty in any format for this   *
+ * product.                                                                    *
+ *                                                                             *
+ * For questions or comments, please contact the authors of the reference.     *
+ * One who want to use it for other consideration may also contact Dr.Duffy    *
+ * at cxd11@psu.edu.                                                           *
+ *******************************************************************************/
+
+//! @file stats.h Phases timed by the run-time profile and function declarations of stats.c
+
+#include "sundials_types.h"
+#include "nvector_serial.h"
+
+/*    Phases of the run-time profile    */
+#define PROF_READ        0        /**< read_alloc()                            */
+#define PROF_INIT        1        /**< initialize() and FPrintInit()           */
+#define PROF_ETIS        2        /**< calET_IS()                              */
+#define PROF_CVODE       3        /**< CVode(), including PROF_RHS             */
+#define PROF_RHS         4        /**< f() in CVode() and its preconditioners  */
+#define PROF_TSD         5        /**< setTSDiCounter()                        */
+#define PROF_PRINT       6        /**< FPrint()                                */
+#define PROF_ESTUARY     7        /**< estuary and saturation diagnostics      */
+#define PROF_SNAP        8        /**< flux snapshot f() before FPrint()       */
+#define PROF_NUM         9        /**< Number of phases                        */
+
+/* Function Prototypes */
+void FPrintStatsInit(char *, int);                    /* open .stats.csv (and .prof.csv)            */
+void FPrintStats(void *, int, int, realtype, int);    /* CVODE counters of one output interval      */
+void FPrintStatsClose(void);                          /* totals of the run, close the files         */
+
+void ProfStart(int);                                  /* start the timer of a phase                 */
+void ProfStop(int);                                   /* add the time since ProfStart to the phase  */
+int  fProf(realtype, N_Vector, N_Vector, void *);     /* f() with its time added to PROF_RHS        */
+
+#endif
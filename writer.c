@@ -0,0 +1,292 @@
+/*******************************************************************************
+ * File        : writer.c                                                      *
+ * Function    : output writer thread: the rows and records of FPrint() are    *
+ *               written to disk while the solver goes on                      *
+ * Programmers : Yizhong Qu   @ Pennsylvania State Univeristy                  *
+ *               Mukesh Kumar @ Pennsylvania State Univeristy                  *
+ *               Gopal Bhatt  @ Pennsylvania State Univeristy                  *
+ * Version     : 2.0 (July 10, 2007)                                           *
+ *-----------------------------------------------------------------------------*
+ *                                                                             *
+ * A print routine that flushes its mean values hands them to WriterTxt() or   *
+ * WriterCdf(). The values are copied into the next free buffer of a ring of   *
+ * OUT_SLOTS snapshot buffers (print.h) and the routine may reset and reuse    *
+ * its accumulator at once. A dedicated thread takes the buffers in order and  *
+ * does the fprintf() or nc_put_vara_double(); a buffer is free again after    *
+ * its record has been written. When the ring is full the solver waits for     *
+ * the writer (backpressure), so the memory is bounded by the ring.            *
+ *                                                                             *
+ * The writer thread is the only caller of the TXT and CDF output functions    *
+ * between WriterInit() and WriterClose(); the files are opened before and     *
+ * closed after. With OUT_SLOTS 0 the records are written at once by the       *
+ * caller, as before.                                                          *
+ *                                                                             *
+ * This code is free for users with research purpose only, if appropriate      *
+ * citation is refered. However, there is no warranty in any format for this   *
+ * product.                                                                    *
+ *                                                                             *
+ * For questions or comments, please contact the authors of the reference.     *
+ * One who want to use it for other consideration may also contact Dr.Duffy    *
+ * at cxd11@psu.edu.                                                           *
+ *******************************************************************************/
+
+//! @file writer.c Ring of snapshot buffers written to the output files by a dedicated thread
+
+/*    C Header Files    */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+/*    NetCDF Header Files    */
+#include <netcdf.h>
+
+/*    PIHM Header Files    */
+#include "writer.h"
+
+#define REC_TXT    1        /**< One row of a TXT file                        */
+#define REC_CDF    2        /**< One record of a CDF variable                 */
+
+
+/* One queued row or record */
+typedef struct out_rec_type
+//! One row of a TXT file or one record of a CDF variable waiting for the writer thread
+{
+    int kind;                 /**< REC_TXT or REC_CDF                             */
+    FILE *file;               /**< TXT file                                       */
+    int ncid;                 /**< CDF file                                       */
+    int varid;                /**< CDF variable                                   */
+    int rec;                  /**< Index of the CDF record (time)                 */
+    int len;                  /**< Number of values                               */
+    double *data;             /**< Snapshot of the values [maxLen]                */
+
+} out_rec;
+
+
+static out_rec *ring;                /**< Snapshot buffers [nSlots]                    */
+static int nSlots;                   /**< Number of buffers, 0: synchronous writes     */
+static int maxLen;                   /**< Values per buffer                            */
+static int head;                     /**< Next buffer to fill                          */
+static int tail;                     /**< Next buffer to write                         */
+static int queued;                   /**< Buffers filled and not yet written           */
+static int stopWriter;               /**< Set by WriterClose(): leave once drained     */
+static long int nRecs;               /**< Records handed to the writer                 */
+static long int nWaits;              /**< Times the solver waited for a free buffer    */
+
+static pthread_t writerThread;
+static pthread_mutex_t ringLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t notEmpty = PTHREAD_COND_INITIALIZER;   /**< a buffer was queued        */
+static pthread_cond_t notFull = PTHREAD_COND_INITIALIZER;    /**< a buffer was written       */
+
+
+
+/*******************************************************************************
+*    Writing of one Record
+********************************************************************************/
+static void WriteRec(out_rec *r)
+//! Function writes one row of a TXT file or one record of a CDF variable
+/*! \param r is the record
+*/
+{
+    int i, retval;
+    size_t start[2], count[2];
+
+    if(r->kind == REC_TXT)
+    {
+        for(i=0; i<r->len; i++)
+        {
+            fprintf(r->file, "%lf\t", r->data[i]);
+        }
+        fprintf(r->file, "\n");
+    }
+    else
+    {
+        start[0] = r->rec;
+        start[1] = 0;
+        count[0] = 1;
+        count[1] = r->len;
+        if((retval = nc_put_vara_double(r->ncid, r->varid, start, count, r->data)))
+        {
+            printf("Error: %s\n", nc_strerror(retval));
+        }
+    }
+}
+
+
+static void *WriterLoop(void *arg)
+//! Function is the writer thread: writes the queued buffers in order until WriterClose()
+/*! \param arg is not used
+*/
+{
+    out_rec *r;
+
+    pthread_mutex_lock(&ringLock);
+    for(;;)
+    {
+        while(queued == 0 && !stopWriter)
+        {
+            pthread_cond_wait(&notEmpty, &ringLock);
+        }
+        if(queued == 0)
+        {
+            break;
+        }
+        r = &ring[tail];
+        pthread_mutex_unlock(&ringLock);
+
+        /* the buffer stays taken while it is written */
+        WriteRec(r);
+
+        pthread_mutex_lock(&ringLock);
+        tail = (tail + 1)%nSlots;
+        queued--;
+        pthread_cond_broadcast(&notFull);
+    }
+    pthread_mutex_unlock(&ringLock);
+    return NULL;
+}
+
+
+static void Queue(out_rec *r, double *data)
+//! Function copies a record into the next free buffer and hands it to the writer; waits while the ring is full
+/*! \param r is the record without data
+    \param data is the values of the record
+*/
+{
+    out_rec *s;
+
+    nRecs++;
+    if(nSlots == 0)
+    {
+        r->data = data;
+        WriteRec(r);
+        return;
+    }
+    if(r->len > maxLen)
+    {
+        printf("\n  Fatal Error: output record of %d values exceeds the writer buffers of %d!\n", r->len, maxLen);
+        exit(1);
+    }
+
+    pthread_mutex_lock(&ringLock);
+    if(queued == nSlots)
+    {
+        nWaits++;
+    }
+    while(queued == nSlots)
+    {
+        pthread_cond_wait(&notFull, &ringLock);
+    }
+    s = &ring[head];
+    pthread_mutex_unlock(&ringLock);
+
+    /* the free buffer at head is not seen by the writer before it is queued below */
+    s->kind = r->kind;
+    s->file = r->file;
+    s->ncid = r->ncid;
+    s->varid = r->varid;
+    s->rec = r->rec;
+    s->len = r->len;
+    memcpy(s->data, data, r->len*sizeof(double));
+
+    pthread_mutex_lock(&ringLock);
+    head = (head + 1)%nSlots;
+    queued++;
+    pthread_cond_signal(&notEmpty);
+    pthread_mutex_unlock(&ringLock);
+}
+
+
+
+/*******************************************************************************
+*    Interface of the Print Routines
+********************************************************************************/
+void WriterInit(int slots, int len)
+//! Function allocates the ring of snapshot buffers and starts the writer thread
+/*! \param slots is the number of buffers; 0 writes every record at once in the caller
+    \param len is the largest number of values of a record (elements or river segments)
+*/
+{
+    int i;
+
+    nSlots = slots > 0 ? slots : 0;
+    maxLen = len > 0 ? len : 1;
+    head = tail = queued = 0;
+    stopWriter = 0;
+    nRecs = nWaits = 0;
+    if(nSlots == 0)
+    {
+        return;
+    }
+
+    ring = (out_rec *)malloc(nSlots*sizeof(out_rec));
+    ring[0].data = (double *)malloc(nSlots*maxLen*sizeof(double));
+    for(i=1; i<nSlots; i++)
+    {
+        ring[i].data = ring[0].data + i*maxLen;
+    }
+    if(pthread_create(&writerThread, NULL, WriterLoop, NULL) != 0)
+    {
+        printf("\n  Warning: output writer thread not started, writing synchronously\n");
+        free(ring[0].data);
+        free(ring);
+        nSlots = 0;
+    }
+}
+
+
+void WriterTxt(FILE *file, double *data, int len)
+//! Function queues one row of a TXT file: the values separated by tabs
+/*! \param file is the TXT file
+    \param data is the values; the caller may reuse it on return
+    \param len is the number of values
+*/
+{
+    out_rec r;
+
+    r.kind = REC_TXT;
+    r.file = file;
+    r.ncid = r.varid = r.rec = 0;
+    r.len = len;
+    Queue(&r, data);
+}
+
+
+void WriterCdf(int ncid, int varid, int rec, double *data, int len)
+//! Function queues one record (time) of a CDF variable
+/*! \param ncid is the netcdf file identifier
+    \param varid is the netcdf variable identifier
+    \param rec is the index of the record
+    \param data is the values; the caller may reuse it on return
+    \param len is the number of values
+*/
+{
+    out_rec r;
+
+    r.kind = REC_CDF;
+    r.file = NULL;
+    r.ncid = ncid;
+    r.varid = varid;
+    r.rec = rec;
+    r.len = len;
+    Queue(&r, data);
+}
+
+
+void WriterClose(void)
+//! Function writes the remaining records, stops and joins the writer thread; the files may be closed after
+{
+    if(nSlots > 0)
+    {
+        pthread_mutex_lock(&ringLock);
+        stopWriter = 1;
+        pthread_cond_signal(&notEmpty);
+        pthread_mutex_unlock(&ringLock);
+        pthread_join(writerThread, NULL);
+
+        free(ring[0].data);
+        free(ring);
+        printf("\n  Output writer: %ld records, %d buffers, the solver waited %ld times for a free buffer\n", nRecs, nSlots, nWaits);
+    }
+    nSlots = 0;
+}
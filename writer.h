@@ -0,0 +1,32 @@
+#ifndef WRITER_H
+#define WRITER_H
+
+/*******************************************************************************
+ * File        : writer.h                                                      *
+ * Function    : function declarations for writer.c                            *
+ * Programmers : Yizhong Qu   @ Pennsylvania State Univeristy                  *
+ *               Mukesh Kumar @ Pennsylvania State Univeristy                  *
+ *               Gopal Bhatt  @ Pennsylvania State Univeristy                  *
+ * Version     : 2.0 (July 10, 2007)                                           *
+ *-----------------------------------------------------------------------------*
+ *                                                                             *
+ * This code is free for users with research purpose only, if appropriate      *
+ * citation is refered. However, there is no warranty in any format for this   *
+ * product.                                                                    *
+ *                                                                             *
+ * For questions or comments, please contact the authors of the reference.     *
+ * One who want to use it for other consideration may also contact Dr.Duffy    *
+ * at cxd11@psu.edu.                                                           *
+ *******************************************************************************/
+
+//! @file writer.h Function declarations of the output writer thread in writer.c
+
+#include <stdio.h>
+
+/* Function Prototypes */
+void WriterInit(int, int);                            /* ring of snapshot buffers, start the thread */
+void WriterTxt(FILE *, double *, int);                /* queue one row of a TXT file                */
+void WriterCdf(int, int, int, double *, int);         /* queue one record of a CDF variable         */
+void WriterClose(void);                               /* drain, stop and join the thread            */
+
+#endif
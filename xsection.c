@@ -0,0 +1,406 @@
+/*******************************************************************************
+ * File        : xsection.c                                                    *
+ * Function    : cross-section geometry of the river shapes: area, wetted      *
+ *               peremeter, equivalent width, hydraulic radius^(2/3) and the   *
+ *               depth of a given area                                         *
+ * Programmers : Yizhong Qu   @ Pennsylvania State Univeristy                  *
+ *               Mukesh Kumar @ Pennsylvania State Univeristy                  *
+ *               Gopal Bhatt  @ Pennsylvania State Univeristy                  *
+ * Version     : 2.0 (July 10, 2007)                                           *
+ *-----------------------------------------------------------------------------*
+ *                                                                             *
+ * A shape of interpolation order p has the bank profile D = c*(B/2)^(p-1).    *
+ * The closed forms of the area and the peremeter are evaluated with the depth *
+ * independent factors cached per shape by XSInit(): every pow() of the        *
+ * coefficient c is taken once, the results are bitwise those of the original  *
+ * CS_AreaOrPerem().                                                           *
+ *                                                                             *
+ * For the orders 3 and 4 a peremeter still costs pow(), log() and sqrt().     *
+ * With XSTab = n > 0 in .para the area, the peremeter and the hydraulic       *
+ * radius^(2/3) are tabulated from 0 to twice the deepest bank of the shape at *
+ * n+1 equidistant values of u = sqrt(D), in which the fractional powers of D  *
+ * are smoother, and read with a monotone cubic (Fritsch-Carlson) Hermite      *
+ * interpolation, value and slope. Depths beyond the table and the first       *
+ * XS_DRY intervals, where the leading powers of D are not resolved, fall back *
+ * to the closed forms. The orders 1 and 2 are always evaluated in closed      *
+ * form, which is cheaper than a lookup.                                       *
+ *                                                                             *
+ * This code is free for users with research purpose only, if appropriate      *
+ * citation is refered. However, there is no warranty in any format for this   *
+ * product.                                                                    *
+ *                                                                             *
+ * For questions or comments, please contact the authors of the reference.     *
+ * One who want to use it for other consideration may also contact Dr.Duffy    *
+ * at cxd11@psu.edu.                                                           *
+ *******************************************************************************/
+
+//! @file xsection.c Cross-section geometry of the river shapes, closed form and tabulated
+
+/*    C Header Files    */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+/*    SUNDIALS Header Files    */
+#include "sundials_types.h"
+#include "nvector_serial.h"
+
+/*    PIHM Header Files    */
+#include "pihm.h"
+
+#define EPSILON 0.05        /**< as in f.c                                    */
+#define XS_HFAC 2.0         /**< Tables reach XS_HFAC times the deepest bank  */
+#define XS_DRY 2            /**< Intervals at the dry bed left to closed forms */
+
+/*    Function Declarations    */
+void *alignedMalloc(size_t size);
+void XSInit(Model_Data DS);
+realtype CS_Area(riv_xs *xs, realtype rivDepth);
+realtype CS_Perem(riv_xs *xs, realtype rivDepth);
+realtype CS_EqWid(riv_xs *xs, realtype rivDepth);
+realtype CS_R23(riv_xs *xs, realtype rivDepth);
+int CS_Table(riv_xs *xs, int a_pBool, realtype rivDepth, realtype *val, realtype *slope);
+
+
+
+/*******************************************************************************
+*    Closed Forms with the cached factors of the shape
+********************************************************************************/
+static realtype XSArea(riv_xs *xs, realtype rivDepth)
+//! Function returns the area of the cross-section in closed form
+/*! \param xs is the cross-section of the shape
+    \param rivDepth is the depth of water
+*/
+{
+    switch(xs->order)
+    {
+        case 1:
+            return rivDepth*xs->coeff;
+        case 2:
+            return pow(rivDepth,2)/xs->coeff;
+        case 3:
+            return 4*pow(rivDepth,1.5)/xs->k[0];
+        default:
+            return 3*pow(rivDepth,4.0/3.0)/xs->k[0];
+    }
+}
+
+
+static realtype XSPerem(riv_xs *xs, realtype rivDepth)
+//! Function returns the wetted peremeter of the cross-section in closed form
+/*! \param xs is the cross-section of the shape
+    \param rivDepth is the depth of water
+*/
+{
+    switch(xs->order)
+    {
+        case 1:
+            return 2.0*rivDepth+xs->coeff;
+        case 2:
+            return 2.0*rivDepth*xs->k[1]/xs->coeff;
+        case 3:
+            return (pow(rivDepth*(1+xs->k[1]*rivDepth)/xs->coeff,0.5))+(log(2*pow(xs->coeff*rivDepth,0.5)+pow(1+xs->k[1]*rivDepth,0.5))/xs->k[2]);
+        default:
+            return 2*((pow(rivDepth*(1+xs->k[1]*rivDepth),0.5)/3)+(log(xs->k[3]*pow(rivDepth,0.5)+pow(1+xs->k[1]*rivDepth,0.5))/xs->k[2]));
+    }
+}
+
+
+static realtype XSR23(riv_xs *xs, realtype rivDepth)
+//! Function returns the hydraulic radius^(2/3) of the cross-section in closed form
+/*! \param xs is the cross-section of the shape
+    \param rivDepth is the depth of water
+*/
+{
+    realtype rivArea, rivPerem;
+
+    rivArea = XSArea(xs, rivDepth);
+    rivPerem = XSPerem(xs, rivDepth);
+    return rivPerem>0?pow(rivArea/rivPerem,2.0/3.0):0;
+}
+
+
+
+/*******************************************************************************
+*    Monotone Cubic Tables
+********************************************************************************/
+static void XSSlopes(realtype *y, realtype *m, int n, realtype dh)
+//! Function sets the Fritsch-Carlson slopes m of the n+1 equidistant values y: the Hermite cubic keeps their monotony
+/*! \param y is the table of values
+    \param m is the table of slopes (output)
+    \param n is the number of intervals
+    \param dh is the step of the abscissa
+*/
+{
+    int j;
+    realtype d0, d1, alpha, beta, tau;
+
+    /* central slopes inside, one sided three point slopes at the ends; zero at an extremum */
+    for(j=1; j<n; j++)
+    {
+        d0 = (y[j]-y[j-1])/dh;
+        d1 = (y[j+1]-y[j])/dh;
+        m[j] = d0*d1 > 0 ? (d0+d1)/2 : 0.0;
+    }
+    d0 = (y[1]-y[0])/dh;
+    d1 = (y[2]-y[1])/dh;
+    m[0] = (3*d0-d1)/2*d0 > 0 ? (3*d0-d1)/2 : 0.0;
+    d0 = (y[n]-y[n-1])/dh;
+    d1 = (y[n-1]-y[n-2])/dh;
+    m[n] = (3*d0-d1)/2*d0 > 0 ? (3*d0-d1)/2 : 0.0;
+
+    /* limit the slopes of every interval to alpha^2+beta^2 <= 9 */
+    for(j=0; j<n; j++)
+    {
+        d0 = (y[j+1]-y[j])/dh;
+        if(d0 == 0.0)
+        {
+            m[j] = m[j+1] = 0.0;
+            continue;
+        }
+        alpha = m[j]/d0;
+        beta = m[j+1]/d0;
+        tau = alpha*alpha + beta*beta;
+        if(tau > 9)
+        {
+            tau = 3/sqrt(tau);
+            m[j] = tau*alpha*d0;
+            m[j+1] = tau*beta*d0;
+        }
+    }
+}
+
+
+int CS_Table(riv_xs *xs, int a_pBool, realtype rivDepth, realtype *val, realtype *slope)
+//! Function reads area (1), peremeter (2) or hydraulic radius^(2/3) (4) and its slope from the table; returns 0 if the depth is not tabulated
+/*! \param xs is the cross-section of the shape
+    \param a_pBool is the identifier of the quantity
+    \param rivDepth is the depth of water
+    \param val is the value (output)
+    \param slope is the derivative with respect to the depth (output)
+*/
+{
+    int j;
+    realtype u, s, du, h00, h10, h01, h11, *y, *m;
+
+    if(xs->n == 0 || !(rivDepth >= 0 && rivDepth <= xs->hmax))
+    {
+        return 0;
+    }
+    y = a_pBool == 1 ? xs->A : (a_pBool == 2 ? xs->P : xs->R);
+    m = a_pBool == 1 ? xs->dA : (a_pBool == 2 ? xs->dP : xs->dR);
+
+    u = sqrt(rivDepth);
+    s = u*xs->rdu;
+    j = (int)s;
+    if(j < XS_DRY)
+    {
+        return 0;
+    }
+    j = j < xs->n ? j : xs->n-1;
+    s = s - j;
+    du = 1.0/xs->rdu;
+
+    /* cubic Hermite basis on [j, j+1] */
+    h00 = (1+2*s)*(1-s)*(1-s);
+    h10 = s*(1-s)*(1-s);
+    h01 = s*s*(3-2*s);
+    h11 = s*s*(s-1);
+    *val = h00*y[j] + h10*du*m[j] + h01*y[j+1] + h11*du*m[j+1];
+    if(slope != NULL)
+    {
+        /* dval/dD = dval/du/(2u); the slope at the dry bed is taken as zero, as in DPow() of jtimes.c */
+        *slope = 6*s*(s-1)*(y[j]-y[j+1])*xs->rdu + (1-s)*(1-3*s)*m[j] + s*(3*s-2)*m[j+1];
+        *slope = u > 0 ? *slope/(2*u) : 0.0;
+    }
+    return 1;
+}
+
+
+
+/*******************************************************************************
+*    Cross-section of a River Segment
+********************************************************************************/
+realtype CS_Area(riv_xs *xs, realtype rivDepth)
+//! returns Area of a river segment cross-section
+/*! \param xs is the cross-section of the segment's shape
+    \param rivDepth is the depth of water in the river segment
+*/
+{
+    realtype val;
+
+    if(CS_Table(xs, 1, rivDepth, &val, NULL))
+    {
+        return val;
+    }
+    return XSArea(xs, rivDepth);
+}
+
+
+realtype CS_Perem(riv_xs *xs, realtype rivDepth)
+//! returns Wetted Peremeter of a river segment cross-section
+/*! \param xs is the cross-section of the segment's shape
+    \param rivDepth is the depth of water in the river segment
+*/
+{
+    realtype val;
+
+    if(CS_Table(xs, 2, rivDepth, &val, NULL))
+    {
+        return val;
+    }
+    return XSPerem(xs, rivDepth);
+}
+
+
+realtype CS_R23(riv_xs *xs, realtype rivDepth)
+//! returns Hydraulic radius^(2/3) of a river segment cross-section; 0 for a dry section
+/*! \param xs is the cross-section of the segment's shape
+    \param rivDepth is the depth of water in the river segment
+*/
+{
+    realtype val;
+
+    if(CS_Table(xs, 4, rivDepth, &val, NULL))
+    {
+        return val;
+    }
+    return XSR23(xs, rivDepth);
+}
+
+
+realtype CS_EqWid(riv_xs *xs, realtype rivDepth)
+//! returns Equivalent (top) Width of a river segment cross-section
+/*! \param xs is the cross-section of the segment's shape
+    \param rivDepth is the depth of water in the river segment
+*/
+{
+    /* the width was 2*(D+EPSILON)^(1/(p-1))/c^(1/(p-1)) with the integer division 1/(p-1): the exponent is 1 for */
+    /* p = 2 and 0 for p = 3, 4 */
+    switch(xs->order)
+    {
+        case 1:
+            return xs->coeff;
+        case 2:
+            return 2.0*(rivDepth+EPSILON)/xs->coeff;
+        default:
+            return 2.0;
+    }
+}
+
+
+
+/*******************************************************************************
+*    Set up of the Cross-sections
+********************************************************************************/
+void XSInit(Model_Data DS)
+//! Function caches the factors of the closed forms of every river shape and builds the depth tables if XSTab > 0
+/*! \param DS is pointer to model data structure
+*/
+{
+    int i, j, n;
+    realtype c, h, du, s, val, err[3];
+    riv_xs *xs;
+
+    DS->RivXS = (riv_xs *)malloc(DS->NumRivShape*sizeof(riv_xs));
+    for(i=0; i<DS->NumRivShape; i++)
+    {
+        xs = &DS->RivXS[i];
+        c = DS->Riv_Shape[i].coeff;
+        xs->order = DS->Riv_Shape[i].interpOrd;
+        xs->coeff = c;
+        xs->k[0] = xs->k[1] = xs->k[2] = xs->k[3] = 0.0;
+        switch(xs->order)
+        {
+            case 1:
+                break;
+            case 2:
+                xs->k[1] = pow(1+pow(c,2),0.5);
+                break;
+            case 3:
+                xs->k[0] = 3*pow(c,0.5);
+                xs->k[1] = 4*c;
+                xs->k[2] = 2*c;
+                break;
+            case 4:
+                xs->k[0] = 2*pow(c,1.0/3.0);
+                xs->k[1] = 9*pow(c,2.0/3.0);
+                xs->k[2] = 9*pow(c,1.0/3.0);
+                xs->k[3] = 3*pow(c,1.0/3.0);
+                break;
+            default:
+                printf("\n  Fatal Error: interpolation order %d of river shape %d is not 1-4!\n", xs->order, DS->Riv_Shape[i].index);
+                exit(1);
+        }
+        xs->n = 0;
+        xs->hmax = 0.0;
+        xs->rdu = 0.0;
+        xs->block = NULL;
+        xs->A = xs->dA = xs->P = xs->dP = xs->R = xs->dR = NULL;
+    }
+
+    /* segments point at the geometry of their shape; the tables reach beyond the deepest bank of the shape */
+    for(i=0; i<DS->NumRiv; i++)
+    {
+        xs = &DS->RivXS[DS->Riv[i].shape - 1];
+        DS->RivP.xs[i] = xs;
+        xs->hmax = DS->RivP.depth[i] > xs->hmax ? DS->RivP.depth[i] : xs->hmax;
+    }
+
+    if(DS->XSTab == 0)
+    {
+        return;
+    }
+    n = DS->XSTab < XS_DRY+2 ? XS_DRY+2 : DS->XSTab;
+    for(i=0; i<DS->NumRivShape; i++)
+    {
+        xs = &DS->RivXS[i];
+        if(xs->order < 3)
+        {
+            continue;
+        }
+        xs->hmax = XS_HFAC*(xs->hmax > 0 ? xs->hmax : DS->Riv_Shape[i].depth);
+        if(xs->hmax <= 0)
+        {
+            continue;
+        }
+        du = sqrt(xs->hmax)/n;
+        xs->block = (realtype *)alignedMalloc(6*(n+1)*sizeof(realtype));
+        xs->A  = xs->block;
+        xs->dA = xs->block + (n+1);
+        xs->P  = xs->block + 2*(n+1);
+        xs->dP = xs->block + 3*(n+1);
+        xs->R  = xs->block + 4*(n+1);
+        xs->dR = xs->block + 5*(n+1);
+        for(j=0; j<=n; j++)
+        {
+            h = (j*du)*(j*du);
+            xs->A[j] = XSArea(xs, h);
+            xs->P[j] = XSPerem(xs, h);
+            xs->R[j] = XSR23(xs, h);
+        }
+        XSSlopes(xs->A, xs->dA, n, du);
+        XSSlopes(xs->P, xs->dP, n, du);
+        XSSlopes(xs->R, xs->dR, n, du);
+        xs->rdu = n/sqrt(xs->hmax);
+        xs->n = n;
+
+        /* accuracy of the table at the middle of the intervals */
+        err[0] = err[1] = err[2] = 0.0;
+        for(j=XS_DRY; j<n; j++)
+        {
+            h = ((j+0.5)*du)*((j+0.5)*du);
+            CS_Table(xs, 1, h, &val, NULL);
+            s = fabs(val/XSArea(xs, h)-1);
+            err[0] = s > err[0] ? s : err[0];
+            CS_Table(xs, 2, h, &val, NULL);
+            s = fabs(val/XSPerem(xs, h)-1);
+            err[1] = s > err[1] ? s : err[1];
+            CS_Table(xs, 4, h, &val, NULL);
+            s = fabs(val/XSR23(xs, h)-1);
+            err[2] = s > err[2] ? s : err[2];
+        }
+        printf("\n  River shape %d: %d table intervals to depth %g, max rel. error A %.1e P %.1e R^(2/3) %.1e",
+               DS->Riv_Shape[i].index, n, xs->hmax, err[0], err[1], err[2]);
+    }
+}